@@ -0,0 +1,127 @@
+/*
+ * Hit rate and throughput of LRU and ARC caches on a Zipf-distributed trace, and on the same
+ * trace interleaved with one-off scans. A cache built from hash_table_t and dll_t that finds the
+ * node to move with dll_search is timed on a shorter trace for comparison.
+ *
+ * gcc -O2 -Isrc bench/bench_cache.c bench/bench_utils.c src/dsa_hash.c src/dsa_ht.c src/dsa_dll.c src/dsa_cache.c -lm -o bench_cache
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench_utils.h"
+#include "../src/dsa_cache.h"
+
+#define KEYS 1000000
+#define OPS 4000000
+#define SEARCH_OPS 100000
+#define CAPACITY 10000
+#define ZIPF_S 0.99
+/* Every SCAN_EVERY accesses a run of SCAN_LENGTH keys outside the Zipf key space is read once */
+#define SCAN_EVERY 1000
+#define SCAN_LENGTH 200
+
+/* Keys 1..KEYS, key k drawn with probability proportional to 1 / k^ZIPF_S */
+static void make_trace(intptr_t *trace, bool scans)
+{
+	double *cdf = malloc(sizeof(double) * KEYS);
+	uint64_t state = 0x9e3779b97f4a7c15u;
+	intptr_t scan_key = KEYS + 1;
+	double total = 0;
+
+	for (size_t k = 0; k < KEYS; k++) {
+		total += 1.0 / pow((double)(k + 1), ZIPF_S);
+		cdf[k] = total;
+	}
+	for (size_t i = 0; i < OPS; i++) {
+		if (scans && i % SCAN_EVERY < SCAN_LENGTH) {
+			trace[i] = scan_key++;
+			continue;
+		}
+		double u = (double)(bench_rand(&state) >> 11) / (double)(1ull << 53) * total;
+		size_t lo = 0;
+		size_t hi = KEYS - 1;
+		while (lo < hi) {
+			size_t mid = (lo + hi) / 2;
+			if (cdf[mid] < u) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+		trace[i] = (intptr_t)lo + 1;
+	}
+	free(cdf);
+}
+
+static void run(const char *label, cache_policy_t policy, const intptr_t *trace)
+{
+	cache_options_t options = { .policy = policy, .hash = ht_hash_intptr };
+	cache_t *cache = create_cache(CAPACITY, bench_compare_intptr, &options);
+	char name[64];
+	double start;
+
+	start = bench_now();
+	for (size_t i = 0; i < OPS; i++) {
+		if (!cache_get(cache, (void *)trace[i])) {
+			cache_put(cache, (void *)trace[i], (void *)trace[i]);
+		}
+	}
+	snprintf(name, sizeof(name), "%s", label);
+	bench_report(name, OPS, bench_now() - start);
+	printf("%-40s hit rate %.2f%%, %zu evictions\n", label, 100.0 * cache->hits / OPS, cache->evictions);
+	destroy_cache(&cache, NULL);
+}
+
+/* The pairing the cache module replaces: the list node of a hit is found with dll_search */
+static void run_search(const intptr_t *trace)
+{
+	hash_table_t *ht = create_ht_hash(CAPACITY * 2, ht_hash_intptr, NULL);
+	dll_t *dll = dll_create();
+	dll_node_t *node = NULL;
+	size_t hits = 0;
+	double start;
+
+	start = bench_now();
+	for (size_t i = 0; i < SEARCH_OPS; i++) {
+		void *key = (void *)trace[i];
+		if (search_ht(ht, key, bench_compare_intptr)) {
+			node = dll_search(dll, key);
+			dll_unlink(dll, node);
+			dll_link_front(dll, node);
+			hits++;
+			continue;
+		}
+		if (dll->nodes >= CAPACITY) {
+			node = dll->tail;
+			dll_unlink(dll, node);
+			delete_ht_item(ht, node->data, bench_compare_intptr);
+			free(node);
+		}
+		insert_ht(ht, key, bench_compare_intptr);
+		dll_link_front(dll, dll_create_node(key));
+	}
+	bench_report("ht + dll_search LRU", SEARCH_OPS, bench_now() - start);
+	printf("%-40s hit rate %.2f%%\n", "ht + dll_search LRU", 100.0 * hits / SEARCH_OPS);
+	dll_destroy(&dll, bench_keep);
+	destroy_ht(&ht, bench_keep);
+}
+
+int main(void)
+{
+	intptr_t *trace = malloc(sizeof(intptr_t) * OPS);
+
+	if (!trace) {
+		return 1;
+	}
+	make_trace(trace, false);
+	run("zipf LRU", CACHE_LRU, trace);
+	run("zipf ARC", CACHE_ARC, trace);
+	run_search(trace);
+
+	make_trace(trace, true);
+	run("zipf + scans LRU", CACHE_LRU, trace);
+	run("zipf + scans ARC", CACHE_ARC, trace);
+
+	free(trace);
+	return 0;
+}
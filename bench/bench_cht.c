@@ -0,0 +1,109 @@
+/*
+ * Multi-threaded throughput of the concurrent hash table against hash_table_t behind a global mutex.
+ *
+ * gcc -O2 -pthread -Isrc bench/bench_cht.c bench/bench_utils.c src/dsa_cht.c src/dsa_hash.c src/dsa_ht.c -o bench_cht
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "bench_utils.h"
+#include "../src/dsa_cht.h"
+#include "../src/dsa_ht.h"
+
+#define KEYS (1 << 20)
+#define OPS_TOTAL 2000000
+
+struct worker {
+	concurrent_ht_t *cht;
+	hash_table_t *ht;
+	pthread_mutex_t *lock;
+	unsigned int write_percent;
+	size_t ops;
+	uint64_t seed;
+};
+
+static void *run_cht(void *arg)
+{
+	struct worker *w = arg;
+	uint64_t found = 0;
+	for (size_t i = 0; i < w->ops; i++) {
+		uint64_t r = bench_rand(&w->seed);
+		intptr_t key = 1 + (intptr_t)(r % KEYS);
+		if (r % 100 < w->write_percent) {
+			/* writes replace a key: delete it and put it back */
+			if (delete_cht_item(w->cht, (void *)key, bench_compare_intptr) == 0) {
+				insert_cht(w->cht, (void *)key, bench_compare_intptr);
+			}
+		} else {
+			found += search_cht(w->cht, (void *)key, bench_compare_intptr) != NULL;
+		}
+	}
+	bench_consume(found);
+	return NULL;
+}
+
+static void *run_locked(void *arg)
+{
+	struct worker *w = arg;
+	uint64_t found = 0;
+	for (size_t i = 0; i < w->ops; i++) {
+		uint64_t r = bench_rand(&w->seed);
+		intptr_t key = 1 + (intptr_t)(r % KEYS);
+		pthread_mutex_lock(w->lock);
+		if (r % 100 < w->write_percent) {
+			if (delete_ht_item(w->ht, (void *)key, bench_compare_intptr) == 0) {
+				insert_ht(w->ht, (void *)key, bench_compare_intptr);
+			}
+		} else {
+			found += search_ht(w->ht, (void *)key, bench_compare_intptr) != NULL;
+		}
+		pthread_mutex_unlock(w->lock);
+	}
+	bench_consume(found);
+	return NULL;
+}
+
+static void run(const char *label, void *(*fn)(void *), size_t threads, unsigned int write_percent,
+		concurrent_ht_t *cht, hash_table_t *ht, pthread_mutex_t *lock)
+{
+	pthread_t tids[64];
+	struct worker workers[64];
+	char name[64];
+	double start = bench_now();
+
+	for (size_t i = 0; i < threads; i++) {
+		workers[i] = (struct worker){ cht, ht, lock, write_percent, OPS_TOTAL / threads, 0x9e3779b97f4a7c15u + i };
+		pthread_create(&tids[i], NULL, fn, &workers[i]);
+	}
+	for (size_t i = 0; i < threads; i++) {
+		pthread_join(tids[i], NULL);
+	}
+	snprintf(name, sizeof(name), "%s %2zu threads %u%% writes", label, threads, write_percent);
+	bench_report(name, OPS_TOTAL / threads * threads, bench_now() - start);
+}
+
+int main(void)
+{
+	static const size_t thread_counts[] = { 1, 2, 4, 8, 16, 32 };
+	static const unsigned int write_percents[] = { 0, 10 };
+	pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+	concurrent_ht_t *cht = create_cht(16, ht_hash_intptr, NULL);
+	hash_table_t *ht = create_ht_hash(KEYS * 2, ht_hash_intptr, NULL);
+
+	for (intptr_t key = 1; key <= KEYS; key++) {
+		insert_cht(cht, (void *)key, bench_compare_intptr);
+		insert_ht(ht, (void *)key, bench_compare_intptr);
+	}
+
+	for (size_t w = 0; w < sizeof(write_percents) / sizeof(write_percents[0]); w++) {
+		for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+			run("cht", run_cht, thread_counts[t], write_percents[w], cht, ht, &lock);
+			run("ht + mutex", run_locked, thread_counts[t], write_percents[w], cht, ht, &lock);
+		}
+	}
+
+	destroy_cht(&cht, bench_keep);
+	destroy_ht(&ht, bench_keep);
+	return 0;
+}
@@ -0,0 +1,147 @@
+/*
+ * Compare the cuckoo table against hash_table_t on insert, hit and miss throughput, and on the
+ * tail of single lookup latencies.
+ *
+ * gcc -O2 -Isrc bench/bench_cuckoo.c bench/bench_utils.c src/dsa_hash.c src/dsa_ht.c src/dsa_cuckoo.c -o bench_cuckoo
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "bench_utils.h"
+#include "../src/dsa_ht.h"
+#include "../src/dsa_cuckoo.h"
+
+#define KEYS 1000000
+#define TIMED_LOOKUPS 200000
+
+typedef struct table_ops {
+	const char *label;
+	void *(*create)(unsigned int flags);
+	int (*insert)(void *table, void *key);
+	bool (*search)(void *table, void *key);
+	void (*destroy)(void *table);
+	unsigned int flags;
+} table_ops_t;
+
+static void *ht_create(unsigned int flags)
+{
+	ht_options_t options = { .flags = flags, .hash = ht_hash_intptr };
+	return create_ht_ex(16, &options);
+}
+
+static int ht_insert(void *table, void *key)
+{
+	return insert_ht(table, key, bench_compare_intptr);
+}
+
+static bool ht_search(void *table, void *key)
+{
+	return search_ht(table, key, bench_compare_intptr) != NULL;
+}
+
+static void ht_destroy(void *table)
+{
+	hash_table_t *ht = table;
+	destroy_ht(&ht, bench_keep);
+}
+
+static void *cuckoo_create(unsigned int flags)
+{
+	(void)flags;
+	return create_cuckoo(16, ht_hash_intptr, NULL);
+}
+
+static int cuckoo_insert(void *table, void *key)
+{
+	return insert_cuckoo(table, key, bench_compare_intptr);
+}
+
+static bool cuckoo_search(void *table, void *key)
+{
+	return search_cuckoo(table, key, bench_compare_intptr) != NULL;
+}
+
+static void cuckoo_destroy(void *table)
+{
+	cuckoo_ht_t *ct = table;
+	destroy_cuckoo(&ct, bench_keep);
+}
+
+static int compare_double(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+static void run(const table_ops_t *ops, void **keys, void **misses, double *latencies)
+{
+	void *table = ops->create(ops->flags);
+	char name[64];
+	size_t found = 0;
+	double start;
+
+	start = bench_now();
+	for (size_t i = 0; i < KEYS; i++) {
+		ops->insert(table, keys[i]);
+	}
+	snprintf(name, sizeof(name), "%s insert", ops->label);
+	bench_report(name, KEYS, bench_now() - start);
+
+	start = bench_now();
+	for (size_t i = 0; i < KEYS; i++) {
+		found += ops->search(table, keys[i]);
+	}
+	snprintf(name, sizeof(name), "%s search hit", ops->label);
+	bench_report(name, KEYS, bench_now() - start);
+
+	start = bench_now();
+	for (size_t i = 0; i < KEYS; i++) {
+		found += ops->search(table, misses[i]);
+	}
+	snprintf(name, sizeof(name), "%s search miss", ops->label);
+	bench_report(name, KEYS, bench_now() - start);
+
+	/* Timer overhead is included in every sample, the same for each table */
+	for (size_t i = 0; i < TIMED_LOOKUPS; i++) {
+		void *key = (i % 2) ? keys[i * 5 % KEYS] : misses[i * 5 % KEYS];
+		start = bench_now();
+		found += ops->search(table, key);
+		latencies[i] = bench_now() - start;
+	}
+	qsort(latencies, TIMED_LOOKUPS, sizeof(double), compare_double);
+	printf("%-40s p50 %6.0f ns  p99 %6.0f ns  p99.9 %6.0f ns  max %8.0f ns\n", ops->label,
+	       latencies[TIMED_LOOKUPS / 2] * 1e9, latencies[TIMED_LOOKUPS * 99 / 100] * 1e9,
+	       latencies[TIMED_LOOKUPS * 999 / 1000] * 1e9, latencies[TIMED_LOOKUPS - 1] * 1e9);
+
+	bench_consume(found);
+	ops->destroy(table);
+}
+
+int main(void)
+{
+	const table_ops_t tables[] = {
+		{ "ht linear", ht_create, ht_insert, ht_search, ht_destroy, 0 },
+		{ "ht robin hood", ht_create, ht_insert, ht_search, ht_destroy, HT_ROBIN_HOOD },
+		{ "ht group probe", ht_create, ht_insert, ht_search, ht_destroy, HT_GROUP_PROBE },
+		{ "cuckoo", cuckoo_create, cuckoo_insert, cuckoo_search, cuckoo_destroy, 0 },
+	};
+	uint64_t state = 0x9e3779b97f4a7c15u;
+	void **keys = malloc(KEYS * sizeof(void *));
+	void **misses = malloc(KEYS * sizeof(void *));
+	double *latencies = malloc(TIMED_LOOKUPS * sizeof(double));
+
+	for (size_t i = 0; i < KEYS; i++) {
+		keys[i] = (void *)(uintptr_t)(bench_rand(&state) | 1);
+		misses[i] = (void *)(uintptr_t)(bench_rand(&state) & ~(uint64_t)1);
+	}
+
+	for (size_t t = 0; t < sizeof(tables) / sizeof(tables[0]); t++) {
+		run(&tables[t], keys, misses, latencies);
+	}
+
+	free(keys);
+	free(misses);
+	free(latencies);
+	return 0;
+}
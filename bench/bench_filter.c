@@ -0,0 +1,117 @@
+/*
+ * Lookups where most keys are absent: search_ht alone against a Bloom or cuckoo filter checked
+ * first with the hash from ht_hash_key, so a key is hashed once and only maybe-present keys reach
+ * search_ht_hashed. Also times bulk builds and single against batch filter queries.
+ *
+ * gcc -O2 -Isrc bench/bench_filter.c bench/bench_utils.c src/dsa_hash.c src/dsa_ht.c src/dsa_filter.c -o bench_filter
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_utils.h"
+#include "../src/dsa_ht.h"
+#include "../src/dsa_filter.h"
+
+#define KEYS 1000000
+#define LOOKUPS 4000000
+#define KEY_SIZE 24
+/* One lookup in HIT_EVERY is for a key in the table */
+#define HIT_EVERY 10
+
+int main(void)
+{
+	char *keys = malloc((size_t)KEYS * KEY_SIZE);
+	char *lookups = malloc((size_t)LOOKUPS * KEY_SIZE);
+	uint64_t *hashes = malloc(sizeof(uint64_t) * LOOKUPS);
+	bool *results = malloc(sizeof(bool) * LOOKUPS);
+	uint64_t state = 0x9e3779b97f4a7c15u;
+	hash_table_t *ht = create_ht(16);
+	bloom_filter_t *bf = create_bloom(KEYS, 10);
+	cfilter_t *cf = create_cfilter(KEYS);
+	size_t found = 0;
+	double start;
+
+	if (!keys || !lookups || !hashes || !results || !ht || !bf || !cf) {
+		return 1;
+	}
+	for (size_t i = 0; i < KEYS; i++) {
+		snprintf(keys + i * KEY_SIZE, KEY_SIZE, "key-%016llx", (unsigned long long)bench_rand(&state));
+		insert_ht(ht, keys + i * KEY_SIZE, bench_compare_str);
+	}
+	for (size_t i = 0; i < LOOKUPS; i++) {
+		if (i % HIT_EVERY == 0) {
+			memcpy(lookups + i * KEY_SIZE, keys + (bench_rand(&state) % KEYS) * KEY_SIZE, KEY_SIZE);
+		} else {
+			snprintf(lookups + i * KEY_SIZE, KEY_SIZE, "miss-%016llx", (unsigned long long)bench_rand(&state));
+		}
+	}
+
+	/* Bulk builds from the table's own hashes */
+	for (size_t i = 0; i < KEYS; i++) {
+		hashes[i] = ht_hash_key(ht, keys + i * KEY_SIZE);
+	}
+	start = bench_now();
+	insert_bloom_batch(bf, hashes, KEYS);
+	bench_report("bloom build", KEYS, bench_now() - start);
+	start = bench_now();
+	insert_cfilter_batch(cf, hashes, KEYS);
+	bench_report("cuckoo filter build", KEYS, bench_now() - start);
+
+	start = bench_now();
+	for (size_t i = 0; i < LOOKUPS; i++) {
+		found += search_ht(ht, lookups + i * KEY_SIZE, bench_compare_str) != NULL;
+	}
+	bench_report("search_ht", LOOKUPS, bench_now() - start);
+
+	start = bench_now();
+	for (size_t i = 0; i < LOOKUPS; i++) {
+		char *key = lookups + i * KEY_SIZE;
+		uint64_t hash = ht_hash_key(ht, key);
+		found += search_bloom(bf, hash) && search_ht_hashed(ht, hash, key, bench_compare_str);
+	}
+	bench_report("bloom + search_ht_hashed", LOOKUPS, bench_now() - start);
+
+	start = bench_now();
+	for (size_t i = 0; i < LOOKUPS; i++) {
+		char *key = lookups + i * KEY_SIZE;
+		uint64_t hash = ht_hash_key(ht, key);
+		found += search_cfilter(cf, hash) && search_ht_hashed(ht, hash, key, bench_compare_str);
+	}
+	bench_report("cuckoo filter + search_ht_hashed", LOOKUPS, bench_now() - start);
+
+	/* Filter queries alone, one at a time and prefetched in bulk */
+	for (size_t i = 0; i < LOOKUPS; i++) {
+		hashes[i] = ht_hash_key(ht, lookups + i * KEY_SIZE);
+	}
+	start = bench_now();
+	for (size_t i = 0; i < LOOKUPS; i++) {
+		found += search_bloom(bf, hashes[i]);
+	}
+	bench_report("bloom query", LOOKUPS, bench_now() - start);
+	start = bench_now();
+	found += search_bloom_batch(bf, hashes, LOOKUPS, results);
+	bench_report("bloom query batch", LOOKUPS, bench_now() - start);
+	start = bench_now();
+	for (size_t i = 0; i < LOOKUPS; i++) {
+		found += search_cfilter(cf, hashes[i]);
+	}
+	bench_report("cuckoo filter query", LOOKUPS, bench_now() - start);
+	start = bench_now();
+	found += search_cfilter_batch(cf, hashes, LOOKUPS, results);
+	bench_report("cuckoo filter query batch", LOOKUPS, bench_now() - start);
+
+	printf("%.2f%% bloom, %.4f%% cuckoo filter false positives, %zu KiB bloom, %zu KiB cuckoo filter\n",
+	       100.0 * (search_bloom_batch(bf, hashes, LOOKUPS, results) - LOOKUPS / HIT_EVERY) / LOOKUPS,
+	       100.0 * (search_cfilter_batch(cf, hashes, LOOKUPS, results) - LOOKUPS / HIT_EVERY) / LOOKUPS,
+	       bf->nblocks * sizeof(bloom_block_t) >> 10, cf->nbuckets * sizeof(cfilter_bucket_t) >> 10);
+
+	bench_consume(found);
+	destroy_ht(&ht, bench_keep);
+	destroy_bloom(&bf);
+	destroy_cfilter(&cf);
+	free(keys);
+	free(lookups);
+	free(hashes);
+	free(results);
+	return 0;
+}
@@ -0,0 +1,76 @@
+/*
+ * Compare FNV64 with the dsa_hash functions on short, medium and long keys.
+ *
+ * gcc -O2 -Isrc bench/bench_hash.c bench/bench_utils.c src/dsa_hash.c src/dsa_ht.c -o bench_hash
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_utils.h"
+#include "../src/dsa_hash.h"
+#include "../src/dsa_ht.h"
+
+#define KEYS 1024
+#define ROUNDS 2000
+
+static char *make_keys(size_t len, uint64_t *state)
+{
+	static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789/_-.";
+	char *keys = malloc(KEYS * (len + 1));
+	for (size_t k = 0; k < KEYS; k++) {
+		char *key = keys + k * (len + 1);
+		for (size_t i = 0; i < len; i++) {
+			key[i] = alphabet[bench_rand(state) % (sizeof(alphabet) - 1)];
+		}
+		key[len] = '\0';
+	}
+	return keys;
+}
+
+static void run(const char *label, size_t len)
+{
+	uint64_t state = 0x9e3779b97f4a7c15u;
+	char *keys = make_keys(len, &state);
+	uint64_t acc = 0;
+	double start;
+	char name[64];
+	size_t ops = (size_t)KEYS * ROUNDS;
+
+	start = bench_now();
+	for (size_t r = 0; r < ROUNDS; r++) {
+		for (size_t k = 0; k < KEYS; k++) {
+			acc += FNV64(keys + k * (len + 1));
+		}
+	}
+	snprintf(name, sizeof(name), "FNV64 %s (%zu B)", label, len);
+	bench_report(name, ops, bench_now() - start);
+
+	start = bench_now();
+	for (size_t r = 0; r < ROUNDS; r++) {
+		for (size_t k = 0; k < KEYS; k++) {
+			acc += dsa_hash_string(keys + k * (len + 1));
+		}
+	}
+	snprintf(name, sizeof(name), "dsa_hash_string %s (%zu B)", label, len);
+	bench_report(name, ops, bench_now() - start);
+
+	start = bench_now();
+	for (size_t r = 0; r < ROUNDS; r++) {
+		for (size_t k = 0; k < KEYS; k++) {
+			acc += dsa_hash64(keys + k * (len + 1), len);
+		}
+	}
+	snprintf(name, sizeof(name), "dsa_hash64 %s (%zu B)", label, len);
+	bench_report(name, ops, bench_now() - start);
+
+	bench_consume(acc);
+	free(keys);
+}
+
+int main(void)
+{
+	run("short", 8);
+	run("medium", 40);
+	run("long", 200);
+	return 0;
+}
@@ -0,0 +1,200 @@
+/*
+ * Compare hash table probing schemes on insert, hit, miss and delete workloads, walking a sparse
+ * table slot by slot against the used-slot iterator, and lookups after a peak has been deleted
+ * against lookups in a table that never grew. Bulk loads are timed with and without ht_reserve.
+ * Hits are looked up through copies of the keys in shuffled order, so a probe that reads the
+ * stored key misses the cache the way it would for keys spread over the heap. Seeded variants
+ * show the cost of HT_SEEDED_HASH; bench_ht_flood.c covers keys chosen to collide.
+ *
+ * gcc -O2 -Isrc bench/bench_ht.c bench/bench_utils.c src/dsa_hash.c src/dsa_ht.c -o bench_ht
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_utils.h"
+#include "../src/dsa_ht.h"
+
+#define KEYS 1000000
+#define KEY_SIZE 24
+#define SPARSE_CAPACITY (8u << 20)
+#define SPARSE_KEYS 10000
+
+static void run(const char *label, unsigned int flags, char *keys, char *hits, char *misses)
+{
+	ht_options_t options = { .flags = flags };
+	hash_table_t *ht = create_ht_ex(KEYS * 2, &options);
+	ht_stats_t stats;
+	char name[64];
+	double start;
+	size_t found = 0;
+
+	start = bench_now();
+	for (size_t i = 0; i < KEYS; i++) {
+		insert_ht(ht, keys + i * KEY_SIZE, bench_compare_str);
+	}
+	snprintf(name, sizeof(name), "%s insert", label);
+	bench_report(name, KEYS, bench_now() - start);
+	ht_stats(ht, &stats);
+	printf("%-40s max probe %zu, %.1f%% at home, %zu resizes in %.3f ms, %zu MiB\n", label, stats.max_displacement,
+	       100.0 * stats.probes[0] / stats.items, stats.resizes, stats.resize_time * 1e3, stats.bytes >> 20);
+
+	start = bench_now();
+	for (size_t i = 0; i < KEYS; i++) {
+		found += search_ht(ht, hits + i * KEY_SIZE, bench_compare_str) != NULL;
+	}
+	snprintf(name, sizeof(name), "%s search hit", label);
+	bench_report(name, KEYS, bench_now() - start);
+
+	start = bench_now();
+	for (size_t i = 0; i < KEYS; i++) {
+		found += search_ht(ht, misses + i * KEY_SIZE, bench_compare_str) != NULL;
+	}
+	snprintf(name, sizeof(name), "%s search miss", label);
+	bench_report(name, KEYS, bench_now() - start);
+
+	start = bench_now();
+	for (size_t i = 0; i < KEYS; i += 2) {
+		delete_ht_item(ht, keys + i * KEY_SIZE, bench_compare_str);
+	}
+	snprintf(name, sizeof(name), "%s delete", label);
+	bench_report(name, KEYS / 2, bench_now() - start);
+
+	bench_consume(found);
+	destroy_ht(&ht, bench_keep);
+}
+
+static void run_bulk_load(const char *label, bool reserve, char *keys)
+{
+	hash_table_t *ht = create_ht(16);
+	double start;
+
+	start = bench_now();
+	if (reserve) {
+		ht_reserve(ht, KEYS);
+	}
+	for (size_t i = 0; i < KEYS; i++) {
+		insert_ht(ht, keys + i * KEY_SIZE, bench_compare_str);
+	}
+	bench_report(label, KEYS, bench_now() - start);
+	destroy_ht(&ht, bench_keep);
+}
+
+static void run_walk(char *keys)
+{
+	hash_table_t *ht = create_ht(SPARSE_CAPACITY);
+	ht_iter_t iter;
+	ht_item_t *item = NULL;
+	size_t found = 0;
+	double start;
+
+	for (size_t i = 0; i < SPARSE_KEYS; i++) {
+		insert_ht(ht, keys + i * KEY_SIZE, bench_compare_str);
+	}
+
+	start = bench_now();
+	for (size_t i = 0; i < ht->capacity; i++) {
+		found += index_ht(ht, i)->has_item;
+	}
+	bench_report("sparse walk index_ht", SPARSE_KEYS, bench_now() - start);
+
+	start = bench_now();
+	ht_iter_init(ht, &iter);
+	while ((item = ht_iter_next(&iter))) {
+		found++;
+	}
+	bench_report("sparse walk iterator", SPARSE_KEYS, bench_now() - start);
+
+	start = bench_now();
+	ht_clear(ht, bench_keep);
+	bench_report("sparse clear", SPARSE_KEYS, bench_now() - start);
+
+	bench_consume(found);
+	destroy_ht(&ht, bench_keep);
+}
+
+static void run_peak(char *keys)
+{
+	hash_table_t *peak = create_ht(16);
+	hash_table_t *fresh = create_ht(16);
+	size_t found = 0;
+	size_t peak_capacity = 0;
+	double start;
+
+	for (size_t i = 0; i < KEYS; i++) {
+		insert_ht(peak, keys + i * KEY_SIZE, bench_compare_str);
+	}
+	peak_capacity = peak->capacity;
+	for (size_t i = SPARSE_KEYS; i < KEYS; i++) {
+		delete_ht_item(peak, keys + i * KEY_SIZE, bench_compare_str);
+	}
+	for (size_t i = 0; i < SPARSE_KEYS; i++) {
+		insert_ht(fresh, keys + i * KEY_SIZE, bench_compare_str);
+	}
+	printf("after peak: capacity %zu -> %zu (%zu MiB -> %zu KiB), fresh table capacity %zu\n", peak_capacity,
+	       peak->capacity, peak_capacity * sizeof(ht_item_t) >> 20, peak->capacity * sizeof(ht_item_t) >> 10,
+	       fresh->capacity);
+
+	start = bench_now();
+	for (size_t r = 0; r < KEYS / SPARSE_KEYS; r++) {
+		for (size_t i = 0; i < SPARSE_KEYS; i++) {
+			found += search_ht(peak, keys + i * KEY_SIZE, bench_compare_str) != NULL;
+		}
+	}
+	bench_report("search after peak", KEYS, bench_now() - start);
+
+	start = bench_now();
+	for (size_t r = 0; r < KEYS / SPARSE_KEYS; r++) {
+		for (size_t i = 0; i < SPARSE_KEYS; i++) {
+			found += search_ht(fresh, keys + i * KEY_SIZE, bench_compare_str) != NULL;
+		}
+	}
+	bench_report("search fresh", KEYS, bench_now() - start);
+
+	bench_consume(found);
+	destroy_ht(&peak, bench_keep);
+	destroy_ht(&fresh, bench_keep);
+}
+
+int main(void)
+{
+	uint64_t state = 0x9e3779b97f4a7c15u;
+	char *keys = malloc((size_t)KEYS * KEY_SIZE);
+	char *hits = malloc((size_t)KEYS * KEY_SIZE);
+	char *misses = malloc((size_t)KEYS * KEY_SIZE);
+
+	/* 16 byte keys, the longest that fit inline */
+	for (size_t i = 0; i < KEYS; i++) {
+		snprintf(keys + i * KEY_SIZE, KEY_SIZE, "k-%014llx", (unsigned long long)bench_rand(&state) >> 8);
+		snprintf(misses + i * KEY_SIZE, KEY_SIZE, "m-%014llx", (unsigned long long)bench_rand(&state) >> 8);
+	}
+	memcpy(hits, keys, (size_t)KEYS * KEY_SIZE);
+	for (size_t i = KEYS - 1; i > 0; i--) {
+		char swap[KEY_SIZE];
+		size_t j = bench_rand(&state) % (i + 1);
+		memcpy(swap, hits + i * KEY_SIZE, KEY_SIZE);
+		memcpy(hits + i * KEY_SIZE, hits + j * KEY_SIZE, KEY_SIZE);
+		memcpy(hits + j * KEY_SIZE, swap, KEY_SIZE);
+	}
+
+	run("linear", 0, keys, hits, misses);
+	run("robin hood", HT_ROBIN_HOOD, keys, hits, misses);
+	run("group probe", HT_GROUP_PROBE, keys, hits, misses);
+	run("linear pow2", HT_POW2_CAPACITY, keys, hits, misses);
+	run("robin hood pow2", HT_ROBIN_HOOD | HT_POW2_CAPACITY, keys, hits, misses);
+	run("group probe pow2", HT_GROUP_PROBE | HT_POW2_CAPACITY, keys, hits, misses);
+	run("linear inline", HT_INLINE_KEYS, keys, hits, misses);
+	run("robin hood inline", HT_ROBIN_HOOD | HT_INLINE_KEYS, keys, hits, misses);
+	run("group probe inline", HT_GROUP_PROBE | HT_INLINE_KEYS, keys, hits, misses);
+	run("linear seeded", HT_SEEDED_HASH, keys, hits, misses);
+	run("robin hood seeded", HT_ROBIN_HOOD | HT_SEEDED_HASH, keys, hits, misses);
+	run("group probe seeded", HT_GROUP_PROBE | HT_SEEDED_HASH, keys, hits, misses);
+	run_bulk_load("bulk load from 16", false, keys);
+	run_bulk_load("bulk load reserved", true, keys);
+	run_walk(keys);
+	run_peak(keys);
+
+	free(keys);
+	free(hits);
+	free(misses);
+	return 0;
+}
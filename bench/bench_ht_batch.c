@@ -0,0 +1,82 @@
+/*
+ * Batched, prefetching search/insert against one search_ht/insert_ht call per key, on a table
+ * much larger than the last level cache.
+ *
+ * gcc -O2 -Isrc bench/bench_ht_batch.c bench/bench_utils.c src/dsa_hash.c src/dsa_ht.c -o bench_ht_batch
+ * ./bench_ht_batch [keys]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "bench_utils.h"
+#include "../src/dsa_ht.h"
+
+#define DEFAULT_KEYS (4u << 20)
+#define BATCH 256
+
+static void run(const char *label, unsigned int flags, void **keys, void **lookups, size_t n)
+{
+	ht_options_t options = { .flags = flags, .hash = ht_hash_intptr };
+	hash_table_t *single = create_ht_ex(n * 2, &options);
+	hash_table_t *batched = create_ht_ex(n * 2, &options);
+	ht_item_t *results[BATCH];
+	char name[64];
+	size_t hits = 0;
+	double start;
+
+	start = bench_now();
+	for (size_t i = 0; i < n; i++) {
+		insert_ht(single, keys[i], bench_compare_intptr);
+	}
+	snprintf(name, sizeof(name), "%s insert single", label);
+	bench_report(name, n, bench_now() - start);
+
+	start = bench_now();
+	for (size_t i = 0; i < n; i += BATCH) {
+		insert_ht_batch(batched, keys + i, (n - i < BATCH) ? n - i : BATCH, bench_compare_intptr, NULL);
+	}
+	snprintf(name, sizeof(name), "%s insert batch", label);
+	bench_report(name, n, bench_now() - start);
+
+	start = bench_now();
+	for (size_t i = 0; i < n; i++) {
+		hits += search_ht(single, lookups[i], bench_compare_intptr) != NULL;
+	}
+	snprintf(name, sizeof(name), "%s search single", label);
+	bench_report(name, n, bench_now() - start);
+
+	start = bench_now();
+	for (size_t i = 0; i < n; i += BATCH) {
+		hits += search_ht_batch(batched, lookups + i, (n - i < BATCH) ? n - i : BATCH, bench_compare_intptr, results);
+	}
+	snprintf(name, sizeof(name), "%s search batch", label);
+	bench_report(name, n, bench_now() - start);
+
+	bench_consume(hits);
+	destroy_ht(&single, bench_keep);
+	destroy_ht(&batched, bench_keep);
+}
+
+int main(int argc, char **argv)
+{
+	size_t n = argc > 1 ? strtoull(argv[1], NULL, 10) : DEFAULT_KEYS;
+	uint64_t state = 0x9e3779b97f4a7c15u;
+	void **keys = malloc(n * sizeof(void *));
+	void **lookups = malloc(n * sizeof(void *));
+
+	for (size_t i = 0; i < n; i++) {
+		keys[i] = (void *)(uintptr_t)(bench_rand(&state) | 1);
+	}
+	/* half hits in random order, half misses */
+	for (size_t i = 0; i < n; i++) {
+		lookups[i] = (i % 2) ? keys[bench_rand(&state) % n] : (void *)(uintptr_t)(bench_rand(&state) | 1);
+	}
+
+	printf("%zu keys, %zu MiB of slots per table\n", n, n * 2 * sizeof(ht_item_t) >> 20);
+	run("linear", 0, keys, lookups, n);
+	run("group probe", HT_GROUP_PROBE, keys, lookups, n);
+
+	free(keys);
+	free(lookups);
+	return 0;
+}
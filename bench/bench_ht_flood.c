@@ -0,0 +1,99 @@
+/*
+ * Hash flooding: keys chosen offline so that the default string hash sends all of them to one slot
+ * of a table of known capacity, as an attacker who knows the hash function could. The same keys
+ * and a set of ordinary keys are loaded into default and HT_SEEDED_HASH tables, reporting
+ * throughput and the longest probe from ht_stats. Group probing picks its group from other hash
+ * bits, so only linear and Robin Hood tables are attacked here.
+ *
+ * gcc -O2 -Isrc bench/bench_ht_flood.c bench/bench_utils.c src/dsa_hash.c src/dsa_ht.c -o bench_ht_flood
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench_utils.h"
+#include "../src/dsa_ht.h"
+
+#define CAPACITY 16384
+#define KEYS 4000
+#define KEY_SIZE 24
+
+/* Keys whose unseeded hash lands in slot 0 of a CAPACITY slot table */
+static void make_colliding_keys(char *keys)
+{
+	uint64_t counter = 0;
+
+	for (size_t found = 0; found < KEYS; counter++) {
+		char *key = keys + found * KEY_SIZE;
+		snprintf(key, KEY_SIZE, "flood-%016llx", (unsigned long long)counter);
+		if (ht_hash_string(key, 0) % CAPACITY == 0) {
+			found++;
+		}
+	}
+}
+
+static void make_random_keys(char *keys)
+{
+	uint64_t state = 0x2545f4914f6cdd1du;
+
+	for (size_t i = 0; i < KEYS; i++) {
+		snprintf(keys + i * KEY_SIZE, KEY_SIZE, "key-%016llx", (unsigned long long)bench_rand(&state));
+	}
+}
+
+static void run(const char *label, unsigned int flags, char *keys)
+{
+	ht_options_t options = { .flags = flags };
+	hash_table_t *ht = create_ht_ex(CAPACITY, &options);
+	ht_stats_t stats;
+	char name[64];
+	double start;
+	size_t found = 0;
+
+	start = bench_now();
+	for (size_t i = 0; i < KEYS; i++) {
+		insert_ht(ht, keys + i * KEY_SIZE, bench_compare_str);
+	}
+	snprintf(name, sizeof(name), "%s insert", label);
+	bench_report(name, KEYS, bench_now() - start);
+
+	start = bench_now();
+	for (size_t i = 0; i < KEYS; i++) {
+		found += search_ht(ht, keys + i * KEY_SIZE, bench_compare_str) != NULL;
+	}
+	snprintf(name, sizeof(name), "%s search", label);
+	bench_report(name, KEYS, bench_now() - start);
+
+	ht_stats(ht, &stats);
+	printf("%-40s max probe %zu, %.1f%% at home, capacity %zu\n", label, stats.max_displacement,
+	       100.0 * stats.probes[0] / stats.items, stats.capacity);
+
+	bench_consume(found);
+	destroy_ht(&ht, bench_keep);
+}
+
+int main(void)
+{
+	char *colliding = malloc((size_t)KEYS * KEY_SIZE);
+	char *random = malloc((size_t)KEYS * KEY_SIZE);
+	double start;
+
+	if (!colliding || !random) {
+		return 1;
+	}
+	start = bench_now();
+	make_colliding_keys(colliding);
+	printf("found %d colliding keys in %.2f s\n", KEYS, bench_now() - start);
+	make_random_keys(random);
+
+	run("linear random", 0, random);
+	run("linear seeded random", HT_SEEDED_HASH, random);
+	run("linear flood", 0, colliding);
+	run("linear seeded flood", HT_SEEDED_HASH, colliding);
+	run("robin hood random", HT_ROBIN_HOOD, random);
+	run("robin hood seeded random", HT_ROBIN_HOOD | HT_SEEDED_HASH, random);
+	run("robin hood flood", HT_ROBIN_HOOD, colliding);
+	run("robin hood seeded flood", HT_ROBIN_HOOD | HT_SEEDED_HASH, colliding);
+
+	free(colliding);
+	free(random);
+	return 0;
+}
@@ -0,0 +1,137 @@
+/*
+ * A DSA_HT_DEFINE table of uint64_t keys against hash_table_t holding the same keys as pointers,
+ * on insert, hit, miss and delete. Both tables start small and grow, and are measured again when
+ * small enough to stay in cache.
+ *
+ * gcc -O2 -Isrc bench/bench_ht_typed.c bench/bench_utils.c src/dsa_hash.c src/dsa_ht.c -o bench_ht_typed
+ * ./bench_ht_typed [keys]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "bench_utils.h"
+#include "../src/dsa_ht.h"
+#include "../src/dsa_ht_typed.h"
+
+#define DEFAULT_KEYS (4u << 20)
+#define SMALL_KEYS (16u << 10)
+
+DSA_HT_DEFINE(u64map, uint64_t, uint64_t)
+
+static void report(const char *label, const char *op, size_t n, double start)
+{
+	char name[64];
+
+	snprintf(name, sizeof(name), "%s %s", label, op);
+	bench_report(name, n, bench_now() - start);
+}
+
+static void run_typed(const char *label, const uint64_t *keys, const uint64_t *lookups, size_t n, size_t rounds)
+{
+	u64map_t *h = create_u64map(0);
+	uint64_t sum = 0;
+	double start;
+
+	start = bench_now();
+	for (size_t i = 0; i < n; i++) {
+		u64map_put(h, keys[i], keys[i]);
+	}
+	report(label, "insert", n, start);
+
+	start = bench_now();
+	for (size_t r = 0; r < rounds; r++) {
+		for (size_t i = 0; i < n; i++) {
+			sum += *u64map_get(h, lookups[i]);
+		}
+	}
+	report(label, "search hit", n * rounds, start);
+
+	start = bench_now();
+	for (size_t r = 0; r < rounds; r++) {
+		for (size_t i = 0; i < n; i++) {
+			sum += u64map_get(h, ~lookups[i]) != NULL;
+		}
+	}
+	report(label, "search miss", n * rounds, start);
+
+	start = bench_now();
+	for (size_t i = 0; i < n; i++) {
+		u64map_delete(h, keys[i]);
+	}
+	report(label, "delete", n, start);
+
+	bench_consume(sum);
+	destroy_u64map(&h);
+}
+
+static void run_generic(const char *label, const uint64_t *keys, const uint64_t *lookups, size_t n, size_t rounds)
+{
+	hash_table_t *ht = create_ht_hash(16, ht_hash_intptr, NULL);
+	uint64_t sum = 0;
+	double start;
+
+	start = bench_now();
+	for (size_t i = 0; i < n; i++) {
+		ht_put(ht, (void *)(uintptr_t)keys[i], (void *)(uintptr_t)keys[i], bench_compare_intptr);
+	}
+	report(label, "insert", n, start);
+
+	start = bench_now();
+	for (size_t r = 0; r < rounds; r++) {
+		for (size_t i = 0; i < n; i++) {
+			sum += (uintptr_t)ht_get(ht, (void *)(uintptr_t)lookups[i], bench_compare_intptr);
+		}
+	}
+	report(label, "search hit", n * rounds, start);
+
+	start = bench_now();
+	for (size_t r = 0; r < rounds; r++) {
+		for (size_t i = 0; i < n; i++) {
+			sum += search_ht(ht, (void *)(uintptr_t)~lookups[i], bench_compare_intptr) != NULL;
+		}
+	}
+	report(label, "search miss", n * rounds, start);
+
+	start = bench_now();
+	for (size_t i = 0; i < n; i++) {
+		delete_ht_item(ht, (void *)(uintptr_t)keys[i], bench_compare_intptr);
+	}
+	report(label, "delete", n, start);
+
+	bench_consume(sum);
+	destroy_ht(&ht, bench_keep);
+}
+
+int main(int argc, char **argv)
+{
+	size_t n = argc > 1 ? strtoull(argv[1], NULL, 0) : DEFAULT_KEYS;
+	uint64_t *keys = malloc(sizeof(uint64_t) * n);
+	uint64_t *lookups = malloc(sizeof(uint64_t) * n);
+	uint64_t state = 0x9e3779b97f4a7c15u;
+
+	if (!keys || !lookups || n < SMALL_KEYS) {
+		return 1;
+	}
+	/* Odd keys, so no key is 0 and the complement of a key is never a key */
+	for (size_t i = 0; i < n; i++) {
+		keys[i] = bench_rand(&state) | 1;
+		lookups[i] = keys[i];
+	}
+	for (size_t i = n - 1; i > 0; i--) {
+		size_t j = bench_rand(&state) % (i + 1);
+		uint64_t swap = lookups[i];
+		lookups[i] = lookups[j];
+		lookups[j] = swap;
+	}
+
+	run_typed("typed", keys, lookups, n, 1);
+	run_generic("hash_table_t", keys, lookups, n, 1);
+
+	/* The first SMALL_KEYS keys in shuffled order, looked up many times while in cache */
+	run_typed("typed small", lookups, lookups, SMALL_KEYS, 100);
+	run_generic("hash_table_t small", lookups, lookups, SMALL_KEYS, 100);
+
+	free(keys);
+	free(lookups);
+	return 0;
+}
@@ -0,0 +1,140 @@
+/*
+ * Jobs ordered by earliest deadline, then heaviest weight, in three queues: pqueue_t with both
+ * packed into the size_t priority, pqueue_t with a comparator on the job and PQ_FIFO, and a
+ * DSA_PQ_DEFINE queue of the jobs themselves. Each is filled and emptied, then held at its size
+ * with every pop followed by a push of a later deadline.
+ *
+ * gcc -O2 -Isrc bench/bench_pq_typed.c bench/bench_utils.c src/dsa_pqueue.c -o bench_pq_typed
+ * ./bench_pq_typed [jobs]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_utils.h"
+#include "../src/dsa_pqueue.h"
+#include "../src/dsa_pq_typed.h"
+
+#define DEFAULT_JOBS 1000000
+#define HOLD_OPS 4000000
+
+typedef struct job {
+	uint32_t deadline;
+	uint32_t weight;
+} job_t;
+
+#define JOB_CMP(a, b) \
+	((a).deadline != (b).deadline ? DSA_PQ_TYPED_MIN((a).deadline, (b).deadline) : DSA_PQ_TYPED_MAX((a).weight, (b).weight))
+
+DSA_PQ_DEFINE(jobq, job_t, JOB_CMP)
+
+static int compare_job(const pqueue_element_t *a, const pqueue_element_t *b)
+{
+	const job_t *x = a->data;
+	const job_t *y = b->data;
+	return JOB_CMP(*x, *y);
+}
+
+/* Earlier deadline in the high bits, heavier weight as a lower number in the low bits */
+static size_t pack(const job_t *job)
+{
+	return (size_t)job->deadline << 32 | (UINT32_MAX - job->weight);
+}
+
+static void next_job(job_t *job, uint64_t *state)
+{
+	job->deadline += bench_rand(state) >> 52;
+	job->weight = bench_rand(state) & 7;
+}
+
+static void run_pqueue(const char *label, const pqueue_options_t *options, job_t *jobs, size_t n)
+{
+	pqueue_t *pq = create_pqueue_ex(n, options);
+	uint64_t state = 0x2545f4914f6cdd1du;
+	uint64_t sum = 0;
+	char name[64];
+	double start;
+	job_t *job = NULL;
+
+	start = bench_now();
+	for (size_t i = 0; i < n; i++) {
+		enpqueue(pq, &jobs[i], pack(&jobs[i]));
+	}
+	while (pq->elements) {
+		sum += ((job_t *)depqueue(pq))->weight;
+	}
+	snprintf(name, sizeof(name), "%s fill and drain", label);
+	bench_report(name, n * 2, bench_now() - start);
+
+	for (size_t i = 0; i < n; i++) {
+		enpqueue(pq, &jobs[i], pack(&jobs[i]));
+	}
+	start = bench_now();
+	for (size_t i = 0; i < HOLD_OPS; i++) {
+		job = depqueue(pq);
+		next_job(job, &state);
+		enpqueue(pq, job, pack(job));
+	}
+	snprintf(name, sizeof(name), "%s hold", label);
+	bench_report(name, HOLD_OPS, bench_now() - start);
+	bench_consume(sum);
+	destroy_pqueue(&pq);
+}
+
+static void run_typed(job_t *jobs, size_t n)
+{
+	jobq_t *q = create_jobq(n);
+	uint64_t state = 0x2545f4914f6cdd1du;
+	uint64_t sum = 0;
+	job_t job = { 0 };
+	double start;
+
+	start = bench_now();
+	for (size_t i = 0; i < n; i++) {
+		jobq_push(q, jobs[i]);
+	}
+	while (jobq_pop(q, &job) == 0) {
+		sum += job.weight;
+	}
+	bench_report("DSA_PQ_DEFINE fill and drain", n * 2, bench_now() - start);
+
+	for (size_t i = 0; i < n; i++) {
+		jobq_push(q, jobs[i]);
+	}
+	start = bench_now();
+	for (size_t i = 0; i < HOLD_OPS; i++) {
+		jobq_pop(q, &job);
+		next_job(&job, &state);
+		jobq_push(q, job);
+	}
+	bench_report("DSA_PQ_DEFINE hold", HOLD_OPS, bench_now() - start);
+	bench_consume(sum);
+	destroy_jobq(&q);
+}
+
+int main(int argc, char **argv)
+{
+	size_t n = argc > 1 ? strtoull(argv[1], NULL, 0) : DEFAULT_JOBS;
+	job_t *jobs = malloc(sizeof(job_t) * n);
+	job_t *copy = malloc(sizeof(job_t) * n);
+	pqueue_options_t compare = { .flags = PQ_FIFO, .compare = compare_job };
+	uint64_t state = 0x9e3779b97f4a7c15u;
+
+	if (!jobs || !copy) {
+		return 1;
+	}
+	for (size_t i = 0; i < n; i++) {
+		jobs[i].deadline = bench_rand(&state) >> 40;
+		jobs[i].weight = bench_rand(&state) & 7;
+	}
+
+	/* The hold loops change the jobs they pop, so every queue starts from a copy */
+	memcpy(copy, jobs, sizeof(job_t) * n);
+	run_pqueue("pqueue_t packed priority", NULL, copy, n);
+	memcpy(copy, jobs, sizeof(job_t) * n);
+	run_pqueue("pqueue_t comparator + PQ_FIFO", &compare, copy, n);
+	run_typed(jobs, n);
+
+	free(jobs);
+	free(copy);
+	return 0;
+}
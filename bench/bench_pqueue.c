@@ -0,0 +1,141 @@
+/*
+ * Dequeue throughput of pqueue_t from 1e3 to 1e7 elements, with the default sift-down and with
+ * PQ_BOTTOM_UP. The queue is filled with random priorities and then emptied. The reinsertion loop
+ * depqueue used before is kept below as a baseline, timed only on the smaller sizes since every
+ * dequeue enqueues most of the heap again.
+ *
+ * Timer cancellation on a queue of CANCEL_TIMERS elements: pq_remove by handle against finding the
+ * timer and draining the queue into a new one without it.
+ *
+ * gcc -O2 -Isrc bench/bench_pqueue.c bench/bench_utils.c src/dsa_pqueue.c -o bench_pqueue
+ * ./bench_pqueue [max elements]
+ */
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench_utils.h"
+#include "../src/dsa_pqueue.h"
+
+#define DEFAULT_MAX 10000000
+#define REINSERT_MAX 10000
+#define CANCEL_TIMERS 100000
+#define CANCELS 10000
+#define DRAIN_CANCELS 20
+
+/* The former depqueue: the smaller child moves up along one path, then every element after the hole is enqueued again */
+static void *depqueue_reinsert(pqueue_t *pq)
+{
+	void *popped = pq->array[0].data;
+	size_t child = 1;
+	size_t parent = 0;
+	size_t size = pq->elements;
+
+	if (pq->elements == 1) {
+		pq->elements = 0;
+		return popped;
+	}
+	while (child <= pq->elements - 1) {
+		if (child + 1 > pq->elements - 1 || pq->array[child].priority < pq->array[child + 1].priority) {
+			pq->array[parent] = pq->array[child];
+			parent = child;
+		} else {
+			pq->array[parent] = pq->array[child + 1];
+			parent = child + 1;
+		}
+		child = 2 * parent + 1;
+	}
+	for (size_t current = parent + 1; current != size; current++) {
+		pq->elements = current - 1;
+		enpqueue(pq, pq->array[current].data, pq->array[current].priority);
+	}
+	pq->elements = size - 1;
+	return popped;
+}
+
+static void run(const char *label, unsigned int flags, bool reinsert, const size_t *priorities, size_t n)
+{
+	pqueue_options_t options = { .flags = flags };
+	pqueue_t *pq = create_pqueue_ex(n, &options);
+	uint64_t sum = 0;
+	char name[64];
+	double start;
+
+	for (size_t i = 0; i < n; i++) {
+		enpqueue(pq, (void *)priorities[i], priorities[i]);
+	}
+	start = bench_now();
+	for (size_t i = 0; i < n; i++) {
+		sum += (uintptr_t)(reinsert ? depqueue_reinsert(pq) : depqueue(pq));
+	}
+	snprintf(name, sizeof(name), "%s %zu", label, n);
+	bench_report(name, n, bench_now() - start);
+	bench_consume(sum);
+	destroy_pqueue(&pq);
+}
+
+static void run_cancel(const size_t *priorities)
+{
+	pqueue_options_t options = { .flags = PQ_INDEXED };
+	pqueue_t *pq = create_pqueue_ex(CANCEL_TIMERS, &options);
+	pq_handle_t *handles = malloc(sizeof(pq_handle_t) * CANCEL_TIMERS);
+	uint64_t sum = 0;
+	double start;
+
+	for (size_t i = 0; i < CANCEL_TIMERS; i++) {
+		handles[i] = enpqueue_handle(pq, (void *)i, priorities[i]);
+	}
+	start = bench_now();
+	for (size_t i = 0; i < CANCELS; i++) {
+		sum += (uintptr_t)pq_remove(pq, handles[i * (CANCEL_TIMERS / CANCELS)]);
+	}
+	bench_report("cancel pq_remove", CANCELS, bench_now() - start);
+	destroy_pqueue(&pq);
+
+	pq = create_pqueue(CANCEL_TIMERS);
+	for (size_t i = 0; i < CANCEL_TIMERS; i++) {
+		enpqueue(pq, (void *)i, priorities[i]);
+	}
+	start = bench_now();
+	for (size_t i = 0; i < DRAIN_CANCELS; i++) {
+		void *cancel = (void *)(i * (CANCEL_TIMERS / CANCELS));
+		pqueue_t *rebuilt = create_pqueue(CANCEL_TIMERS);
+		sum += search_pqueue(pq, cancel) != NULL;
+		while (pq->elements) {
+			size_t priority = pq->array[0].priority;
+			void *data = depqueue(pq);
+			if (data != cancel) {
+				enpqueue(rebuilt, data, priority);
+			}
+		}
+		destroy_pqueue(&pq);
+		pq = rebuilt;
+	}
+	bench_report("cancel drain and rebuild", DRAIN_CANCELS, bench_now() - start);
+	bench_consume(sum);
+	destroy_pqueue(&pq);
+	free(handles);
+}
+
+int main(int argc, char **argv)
+{
+	size_t max = argc > 1 ? strtoull(argv[1], NULL, 0) : DEFAULT_MAX;
+	size_t *priorities = malloc(sizeof(size_t) * max);
+	uint64_t state = 0x9e3779b97f4a7c15u;
+
+	if (!priorities || max < CANCEL_TIMERS) {
+		return 1;
+	}
+	for (size_t i = 0; i < max; i++) {
+		priorities[i] = bench_rand(&state) >> 16;
+	}
+	for (size_t n = 1000; n <= max; n *= 10) {
+		run("depqueue", 0, false, priorities, n);
+		run("depqueue PQ_BOTTOM_UP", PQ_BOTTOM_UP, false, priorities, n);
+		if (n <= REINSERT_MAX) {
+			run("depqueue reinsertion", 0, true, priorities, n);
+		}
+	}
+	run_cancel(priorities);
+	free(priorities);
+	return 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * Binary, 4-ary and 8-ary pqueue_t on push-heavy, pop-heavy and mixed workloads, with a heap
+ * small enough for the caches and one much larger. Push fills an empty queue, pop empties a full
+ * one, and mixed holds the queue at its size, each dequeue followed by an enqueue of a later
+ * priority as a timer queue does.
+ *
+ * gcc -O2 -Isrc bench/bench_pqueue_arity.c bench/bench_utils.c src/dsa_pqueue.c -o bench_pqueue_arity
+ * ./bench_pqueue_arity [large elements]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench_utils.h"
+#include "../src/dsa_pqueue.h"
+
+#define SMALL 10000
+#define DEFAULT_LARGE 4000000
+#define SMALL_ROUNDS 100
+
+static void report(unsigned int arity, const char *op, size_t n, size_t ops, double seconds)
+{
+	char name[64];
+
+	snprintf(name, sizeof(name), "%u-ary %s %zu", arity, op, n);
+	bench_report(name, ops, seconds);
+}
+
+static void run(unsigned int arity, const size_t *priorities, size_t n, size_t rounds)
+{
+	pqueue_options_t options = { .arity = arity };
+	pqueue_t *pq = create_pqueue_ex(n, &options);
+	uint64_t state = 0x2545f4914f6cdd1du;
+	uint64_t sum = 0;
+	size_t priority = 0;
+	double push = 0;
+	double pop = 0;
+	double start;
+
+	for (size_t r = 0; r < rounds; r++) {
+		start = bench_now();
+		for (size_t i = 0; i < n; i++) {
+			enpqueue(pq, (void *)priorities[i], priorities[i]);
+		}
+		push += bench_now() - start;
+		start = bench_now();
+		for (size_t i = 0; i < n; i++) {
+			sum += (uintptr_t)depqueue(pq);
+		}
+		pop += bench_now() - start;
+	}
+	report(arity, "push", n, n * rounds, push);
+	report(arity, "pop", n, n * rounds, pop);
+
+	for (size_t i = 0; i < n; i++) {
+		enpqueue(pq, (void *)priorities[i], priorities[i]);
+	}
+	start = bench_now();
+	for (size_t i = 0; i < n * rounds; i++) {
+		priority = pq->array[0].priority;
+		sum += (uintptr_t)depqueue(pq);
+		priority += bench_rand(&state) >> 40;
+		enpqueue(pq, (void *)priority, priority);
+	}
+	report(arity, "mixed", n, n * rounds, bench_now() - start);
+
+	bench_consume(sum);
+	destroy_pqueue(&pq);
+}
+
+int main(int argc, char **argv)
+{
+	size_t large = argc > 1 ? strtoull(argv[1], NULL, 0) : DEFAULT_LARGE;
+	size_t *priorities = malloc(sizeof(size_t) * large);
+	uint64_t state = 0x9e3779b97f4a7c15u;
+
+	if (!priorities || large < SMALL) {
+		return 1;
+	}
+	for (size_t i = 0; i < large; i++) {
+		priorities[i] = bench_rand(&state) >> 16;
+	}
+	for (unsigned int arity = 2; arity <= 8; arity *= 2) {
+		run(arity, priorities, SMALL, SMALL_ROUNDS);
+	}
+	for (unsigned int arity = 2; arity <= 8; arity *= 2) {
+		run(arity, priorities, large, 1);
+	}
+	free(priorities);
+	return 0;
+}
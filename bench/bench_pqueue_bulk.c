@@ -0,0 +1,70 @@
+/*
+ * Loading a pqueue_t with 5M jobs: one enpqueue per job into a small queue, enpqueue_batch, and
+ * create_pqueue_from_array, then emptying it with depqueue against depqueue_n in chunks.
+ *
+ * gcc -O2 -Isrc bench/bench_pqueue_bulk.c bench/bench_utils.c src/dsa_pqueue.c -o bench_pqueue_bulk
+ * ./bench_pqueue_bulk [jobs]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench_utils.h"
+#include "../src/dsa_pqueue.h"
+
+#define DEFAULT_JOBS 5000000
+#define CHUNK 1024
+
+int main(int argc, char **argv)
+{
+	size_t n = argc > 1 ? strtoull(argv[1], NULL, 0) : DEFAULT_JOBS;
+	pqueue_element_t *jobs = malloc(sizeof(pqueue_element_t) * n);
+	void **popped = malloc(sizeof(void *) * CHUNK);
+	uint64_t state = 0x9e3779b97f4a7c15u;
+	uint64_t sum = 0;
+	pqueue_t *pq = NULL;
+	double start;
+
+	if (!jobs || !popped) {
+		return 1;
+	}
+	for (size_t i = 0; i < n; i++) {
+		jobs[i].priority = bench_rand(&state) >> 16;
+		jobs[i].data = (void *)i;
+	}
+
+	start = bench_now();
+	pq = create_pqueue(16);
+	for (size_t i = 0; i < n; i++) {
+		enpqueue(pq, jobs[i].data, jobs[i].priority);
+	}
+	bench_report("load enpqueue", n, bench_now() - start);
+	start = bench_now();
+	while (pq->elements) {
+		sum += (uintptr_t)depqueue(pq);
+	}
+	bench_report("drain depqueue", n, bench_now() - start);
+	destroy_pqueue(&pq);
+
+	start = bench_now();
+	pq = create_pqueue(16);
+	enpqueue_batch(pq, jobs, n);
+	bench_report("load enpqueue_batch", n, bench_now() - start);
+	destroy_pqueue(&pq);
+
+	start = bench_now();
+	pq = create_pqueue_from_array(jobs, n, NULL);
+	bench_report("load create_pqueue_from_array", n, bench_now() - start);
+	start = bench_now();
+	for (size_t got = CHUNK; got == CHUNK;) {
+		got = depqueue_n(pq, popped, CHUNK);
+		for (size_t i = 0; i < got; i++) {
+			sum += (uintptr_t)popped[i];
+		}
+	}
+	bench_report("drain depqueue_n", n, bench_now() - start);
+	destroy_pqueue(&pq);
+
+	bench_consume(sum);
+	free(jobs);
+	free(popped);
+	return 0;
+}
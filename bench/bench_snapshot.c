@@ -0,0 +1,99 @@
+/*
+ * Restart cost: rebuilding a hash_table_t with ht_put against opening a snapshot of it, with and
+ * without checking the checksum, then lookup throughput of the mapped snapshot against the table.
+ *
+ * gcc -O2 -Isrc bench/bench_snapshot.c bench/bench_utils.c src/dsa_hash.c src/dsa_ht.c src/dsa_snapshot.c -o bench_snapshot
+ * ./bench_snapshot [keys] [path]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "bench_utils.h"
+#include "../src/dsa_snapshot.h"
+
+#define DEFAULT_KEYS (2u << 20)
+#define KEY_SIZE 24
+
+static size_t value_bytes(const void *data, const void **bytes)
+{
+	*bytes = data;
+	return sizeof(uint64_t);
+}
+
+int main(int argc, char **argv)
+{
+	size_t n = argc > 1 ? strtoull(argv[1], NULL, 0) : DEFAULT_KEYS;
+	const char *path = argc > 2 ? argv[2] : "/tmp/bench_snapshot.dsa";
+	char *keys = malloc(n * KEY_SIZE);
+	uint64_t *values = malloc(n * sizeof(uint64_t));
+	size_t *order = malloc(n * sizeof(size_t));
+	uint64_t state = 0x9e3779b97f4a7c15u;
+	hash_table_t *ht = NULL;
+	snapshot_t *snap = NULL;
+	uint64_t sum = 0;
+	double start;
+
+	if (!keys || !values || !order) {
+		return 1;
+	}
+	for (size_t i = 0; i < n; i++) {
+		snprintf(keys + i * KEY_SIZE, KEY_SIZE, "key-%016llx", (unsigned long long)bench_rand(&state));
+		values[i] = i;
+		order[i] = i;
+	}
+	for (size_t i = n - 1; i > 0; i--) {
+		size_t j = bench_rand(&state) % (i + 1);
+		size_t swap = order[i];
+		order[i] = order[j];
+		order[j] = swap;
+	}
+
+	start = bench_now();
+	ht = create_ht(16);
+	for (size_t i = 0; i < n; i++) {
+		ht_put(ht, keys + i * KEY_SIZE, &values[i], bench_compare_str);
+	}
+	bench_report("rebuild with ht_put", n, bench_now() - start);
+
+	start = bench_now();
+	if (save_ht_snapshot(ht, path, NULL, value_bytes) == -1) {
+		return 1;
+	}
+	bench_report("save_ht_snapshot", n, bench_now() - start);
+
+	start = bench_now();
+	snap = open_snapshot(path, false);
+	printf("%-40s %10.3f ms\n", "open_snapshot", (bench_now() - start) * 1e3);
+	close_snapshot(&snap);
+	start = bench_now();
+	snap = open_snapshot(path, true);
+	printf("%-40s %10.3f ms, %llu MiB\n", "open_snapshot verified", (bench_now() - start) * 1e3,
+	       (unsigned long long)(snap->size >> 20));
+
+	start = bench_now();
+	for (size_t i = 0; i < n; i++) {
+		char *key = keys + order[i] * KEY_SIZE;
+		sum += *(uint64_t *)ht_get(ht, key, bench_compare_str);
+	}
+	bench_report("hash_table_t lookup", n, bench_now() - start);
+
+	start = bench_now();
+	for (size_t i = 0; i < n; i++) {
+		char *key = keys + order[i] * KEY_SIZE;
+		const void *value = search_snapshot(snap, key, strlen(key), NULL);
+		uint64_t v;
+		memcpy(&v, value, sizeof(v));
+		sum += v;
+	}
+	bench_report("snapshot lookup", n, bench_now() - start);
+
+	bench_consume(sum);
+	close_snapshot(&snap);
+	destroy_ht(&ht, bench_keep);
+	unlink(path);
+	free(keys);
+	free(values);
+	free(order);
+	return 0;
+}
@@ -0,0 +1,49 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "bench_utils.h"
+
+static volatile uint64_t sink;
+
+double bench_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void bench_report(const char *name, size_t ops, double seconds)
+{
+	printf("%-40s %12zu ops %10.3f ms %10.2f Mops/s %8.2f ns/op\n", name, ops, seconds * 1e3,
+	       ops / seconds / 1e6, seconds * 1e9 / ops);
+}
+
+uint64_t bench_rand(uint64_t *state)
+{
+	uint64_t x = *state;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	*state = x;
+	return x * 0x2545f4914f6cdd1du;
+}
+
+void bench_consume(uint64_t value)
+{
+	sink ^= value;
+}
+
+int bench_compare_str(void *a, void *b)
+{
+	return strcmp((char *)a, (char *)b);
+}
+
+int bench_compare_intptr(void *a, void *b)
+{
+	return a != b;
+}
+
+void bench_keep(void *data)
+{
+	(void)data;
+}
@@ -0,0 +1,63 @@
+#ifndef BENCH_UTILS_H
+#define BENCH_UTILS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Monotonic wall clock in seconds.
+ * 
+ * @return (double): Seconds since an arbitrary fixed point.
+ */
+double bench_now(void);
+
+/**
+ * @brief Print one result line: name, operations, elapsed time and throughput.
+ * 
+ * @param name (const char *): Label for the measurement.
+ * @param ops (size_t): Number of operations performed.
+ * @param seconds (double): Elapsed time.
+ */
+void bench_report(const char *name, size_t ops, double seconds);
+
+/**
+ * @brief Fast deterministic pseudo-random numbers (xorshift64*).
+ * 
+ * @param state (uint64_t *): Generator state, must not be 0.
+ * @return (uint64_t): Next pseudo-random number.
+ */
+uint64_t bench_rand(uint64_t *state);
+
+/**
+ * @brief Keep the compiler from discarding a computed value.
+ * 
+ * @param value (uint64_t): Value to consume.
+ */
+void bench_consume(uint64_t value);
+
+/**
+ * @brief Compare two NUL terminated string keys.
+ * 
+ * @param a (void *): First key.
+ * @param b (void *): Second key.
+ * @return (int): 0 if the strings are equal, nonzero otherwise.
+ */
+int bench_compare_str(void *a, void *b);
+
+/**
+ * @brief Compare two integer keys stored in the pointers themselves.
+ * 
+ * @param a (void *): First key.
+ * @param b (void *): Second key.
+ * @return (int): 0 if the keys are equal, 1 otherwise.
+ */
+int bench_compare_intptr(void *a, void *b);
+
+/**
+ * @brief Destruction callback for keys the benchmark owns elsewhere, it frees nothing.
+ * 
+ * @param data (void *): Key being destroyed.
+ */
+void bench_keep(void *data);
+
+#endif // BENCH_UTILS_H
@@ -0,0 +1,331 @@
+#include <stdlib.h>
+#include "dsa_cache.h"
+
+/* Remembered keys are looked up by hash alone */
+static int compare_hash(void *a, void *b)
+{
+	return a != b;
+}
+
+static void keep(void *data)
+{
+	(void)data;
+}
+
+static size_t resident(cache_t *cache)
+{
+	return cache->recent->nodes + cache->frequent->nodes;
+}
+
+/* Move an entry to the head of a list, the list it is in or another one */
+static void touch(cache_entry_t *entry, dll_t *list)
+{
+	dll_unlink(entry->list, entry->node);
+	dll_link_front(list, entry->node);
+	entry->list = list;
+}
+
+static void free_entry(cache_entry_t *entry)
+{
+	free(entry->node);
+	free(entry);
+}
+
+static void forget(cache_t *cache, cache_entry_t *ghost)
+{
+	delete_ht_item(cache->ghosts, (void *)(uintptr_t)ghost->hash, compare_hash);
+	dll_unlink(ghost->list, ghost->node);
+	free_entry(ghost);
+}
+
+/* Remember the hash of an evicted key in a ghost list, dropping an older key with the same hash */
+static void remember(cache_t *cache, uint64_t hash, dll_t *list)
+{
+	cache_entry_t *ghost = ht_get(cache->ghosts, (void *)(uintptr_t)hash, compare_hash);
+
+	if (ghost) {
+		forget(cache, ghost);
+	}
+	ghost = calloc(1, sizeof(cache_entry_t));
+	if (!ghost) {
+		return;
+	}
+	ghost->node = dll_create_node(ghost);
+	if (!ghost->node || ht_put(cache->ghosts, (void *)(uintptr_t)hash, ghost, compare_hash) == -1) {
+		free_entry(ghost);
+		return;
+	}
+	ghost->hash = hash;
+	ghost->list = list;
+	dll_link_front(list, ghost->node);
+}
+
+/* Evict the least recently used entry of a list, remembering its key in `ghosts` for ARC */
+static void evict_lru(cache_t *cache, dll_t *list, dll_t *ghosts)
+{
+	cache_entry_t *entry = list->tail->data;
+
+	dll_unlink(list, entry->node);
+	delete_ht_item(cache->table, entry->key, cache->compare);
+	if (ghosts) {
+		remember(cache, entry->hash, ghosts);
+	}
+	cache->evictions++;
+	if (cache->evict) {
+		cache->evict(entry->key, entry->value, cache->evict_ctx);
+	}
+	free_entry(entry);
+}
+
+/*
+ * ARC REPLACE: evict from `recent` while it holds more than its target share, or exactly its
+ * target when the key being added was evicted from `frequent`, and from `frequent` otherwise.
+ */
+static void replace(cache_t *cache, bool frequent_ghost)
+{
+	size_t recent = cache->recent->nodes;
+
+	if (resident(cache) < cache->capacity) {
+		return;
+	}
+	if (recent && ((frequent_ghost && recent == cache->target) || recent > cache->target ||
+		       !cache->frequent->nodes)) {
+		evict_lru(cache, cache->recent, cache->recent_ghosts);
+	} else {
+		evict_lru(cache, cache->frequent, cache->frequent_ghosts);
+	}
+}
+
+/* Make room for a key that is neither cached nor remembered */
+static void make_room_arc(cache_t *cache)
+{
+	size_t recent_total = cache->recent->nodes + cache->recent_ghosts->nodes;
+	size_t total = recent_total + cache->frequent->nodes + cache->frequent_ghosts->nodes;
+
+	if (recent_total >= cache->capacity) {
+		if (cache->recent->nodes < cache->capacity) {
+			forget(cache, cache->recent_ghosts->tail->data);
+			replace(cache, false);
+		} else {
+			evict_lru(cache, cache->recent, NULL);
+		}
+	} else if (total >= cache->capacity) {
+		if (total >= 2 * cache->capacity) {
+			forget(cache, cache->frequent_ghosts->tail->data);
+		}
+		replace(cache, false);
+	}
+}
+
+/*
+ * Make room for a key remembered in a ghost list and return the list it goes to. A key evicted
+ * from `recent` grows the target for `recent`, one evicted from `frequent` shrinks it, in steps
+ * as large as the other ghost list is compared to its own.
+ */
+static dll_t *make_room_ghost(cache_t *cache, cache_entry_t *ghost)
+{
+	size_t recent = cache->recent_ghosts->nodes;
+	size_t frequent = cache->frequent_ghosts->nodes;
+	bool frequent_ghost = ghost->list == cache->frequent_ghosts;
+	size_t step = 0;
+
+	if (!frequent_ghost) {
+		step = frequent > recent ? frequent / recent : 1;
+		cache->target = cache->target + step < cache->capacity ? cache->target + step : cache->capacity;
+	} else {
+		step = recent > frequent ? recent / frequent : 1;
+		cache->target = cache->target > step ? cache->target - step : 0;
+	}
+	forget(cache, ghost);
+	replace(cache, frequent_ghost);
+	return cache->frequent;
+}
+
+cache_t *create_cache(size_t capacity, int (*compare)(void *a, void *b), const cache_options_t *options)
+{
+	cache_options_t defaults = { .policy = CACHE_LRU };
+	cache_t *cache = NULL;
+
+	if (capacity == 0 || compare == NULL) {
+		goto ret;
+	}
+	if (options == NULL) {
+		options = &defaults;
+	}
+	cache = calloc(1, sizeof(cache_t));
+	if (!cache) {
+		goto ret;
+	}
+
+	cache->table = create_ht_hash(16, options->hash, options->key_len);
+	cache->recent = dll_create();
+	cache->frequent = dll_create();
+	cache->recent_ghosts = dll_create();
+	cache->frequent_ghosts = dll_create();
+	if (options->policy == CACHE_ARC) {
+		cache->ghosts = create_ht_hash(16, ht_hash_intptr, NULL);
+	}
+	if (!cache->table || !cache->recent || !cache->frequent || !cache->recent_ghosts ||
+	    !cache->frequent_ghosts || (options->policy == CACHE_ARC && !cache->ghosts)) {
+		destroy_cache(&cache, NULL);
+		goto ret;
+	}
+	/* Sized once, so a full cache never resizes its tables */
+	if (ht_reserve(cache->table, capacity) == -1 ||
+	    (cache->ghosts && ht_reserve(cache->ghosts, capacity) == -1)) {
+		destroy_cache(&cache, NULL);
+		goto ret;
+	}
+
+	cache->capacity = capacity;
+	cache->target = 0;
+	cache->policy = options->policy;
+	cache->compare = compare;
+	cache->evict = options->evict;
+	cache->evict_ctx = options->evict_ctx;
+
+ret:
+	return cache;
+}
+
+static void destroy_list(dll_t **list, void (*destroy)(void *key, void *value))
+{
+	dll_node_t *node = NULL;
+	cache_entry_t *entry = NULL;
+
+	if (*list == NULL) {
+		return;
+	}
+	while ((node = (*list)->head)) {
+		entry = node->data;
+		if (destroy && entry->key) {
+			destroy(entry->key, entry->value);
+		}
+		dll_unlink(*list, node);
+		free_entry(entry);
+	}
+	free(*list);
+	*list = NULL;
+}
+
+void destroy_cache(cache_t **cache, void (*destroy)(void *key, void *value))
+{
+	if (*cache == NULL) {
+		return;
+	}
+	destroy_list(&(*cache)->recent, destroy);
+	destroy_list(&(*cache)->frequent, destroy);
+	destroy_list(&(*cache)->recent_ghosts, NULL);
+	destroy_list(&(*cache)->frequent_ghosts, NULL);
+	if ((*cache)->table) {
+		destroy_ht(&(*cache)->table, keep);
+	}
+	if ((*cache)->ghosts) {
+		destroy_ht(&(*cache)->ghosts, keep);
+	}
+
+	free(*cache);
+	*cache = NULL;
+}
+
+void *cache_get(cache_t *cache, void *key)
+{
+	ht_item_t *item = NULL;
+	cache_entry_t *entry = NULL;
+
+	if (cache == NULL) {
+		return NULL;
+	}
+	item = search_ht(cache->table, key, cache->compare);
+	if (!item) {
+		cache->misses++;
+		return NULL;
+	}
+	cache->hits++;
+
+	entry = item->value;
+	touch(entry, cache->policy == CACHE_ARC ? cache->frequent : cache->recent);
+	return entry->value;
+}
+
+int cache_put(cache_t *cache, void *key, void *value)
+{
+	int ret_val = -1;
+	uint64_t hash = 0;
+	ht_item_t *item = NULL;
+	cache_entry_t *entry = NULL;
+	cache_entry_t *ghost = NULL;
+	dll_t *list = NULL;
+
+	if (cache == NULL) {
+		goto ret;
+	}
+	hash = ht_hash_key(cache->table, key);
+
+	/* Already cached */
+	item = search_ht_hashed(cache->table, hash, key, cache->compare);
+	if (item) {
+		entry = item->value;
+		entry->value = value;
+		touch(entry, cache->policy == CACHE_ARC ? cache->frequent : cache->recent);
+		ret_val = 0;
+		goto ret;
+	}
+
+	if (cache->policy == CACHE_LRU) {
+		if (cache->recent->nodes >= cache->capacity) {
+			evict_lru(cache, cache->recent, NULL);
+		}
+		list = cache->recent;
+	} else {
+		ghost = ht_get(cache->ghosts, (void *)(uintptr_t)hash, compare_hash);
+		if (ghost) {
+			list = make_room_ghost(cache, ghost);
+		} else {
+			make_room_arc(cache);
+			list = cache->recent;
+		}
+	}
+
+	entry = calloc(1, sizeof(cache_entry_t));
+	if (!entry) {
+		goto ret;
+	}
+	entry->node = dll_create_node(entry);
+	if (!entry->node || ht_put(cache->table, key, entry, cache->compare) == -1) {
+		free_entry(entry);
+		goto ret;
+	}
+	entry->key = key;
+	entry->value = value;
+	entry->hash = hash;
+	entry->list = list;
+	dll_link_front(list, entry->node);
+
+	ret_val = 0;
+ret:
+	return ret_val;
+}
+
+int cache_remove(cache_t *cache, void *key)
+{
+	int ret_val = -1;
+	ht_item_t *item = NULL;
+	cache_entry_t *entry = NULL;
+
+	if (cache == NULL) {
+		goto ret;
+	}
+	item = search_ht(cache->table, key, cache->compare);
+	if (!item) {
+		goto ret;
+	}
+	entry = item->value;
+	dll_unlink(entry->list, entry->node);
+	delete_ht_item(cache->table, entry->key, cache->compare);
+	free_entry(entry);
+
+	ret_val = 0;
+ret:
+	return ret_val;
+}
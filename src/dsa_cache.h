@@ -0,0 +1,180 @@
+#ifndef DSA_CACHE_H
+#define DSA_CACHE_H
+
+/**
+ * @file dsa_cache.h
+ * @author ajester (alex.m.jester.mil@army.mil)
+ * @brief Bounded Cache Library.
+ * @version 0.1
+ * @date 2021-10-26
+ *
+ * @details Bounded Cache - A key/value map holding at most `capacity` entries. A `hash_table_t`
+ * maps every key to its entry, and the entry points at its node in a `dll_t` recency list, so
+ * hits, inserts and evictions are O(1) and never search a list.
+ *
+ * LRU - One recency list, the least recently used entry is evicted.
+ *
+ * ARC - Adaptive Replacement Cache. Entries seen once and entries seen again are kept in
+ * separate lists, and the hashes of keys recently evicted from each are remembered. A miss on a
+ * remembered key shifts space towards the list that evicted it, so a scan over many new keys
+ * cannot push out entries that are used repeatedly.
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "dsa_dll.h"
+#include "dsa_ht.h"
+
+/**
+ * @brief Replacement policy of a cache.
+ *
+ * @property CACHE_LRU: Evict the least recently used entry.
+ * @property CACHE_ARC: Adaptive Replacement Cache, balancing recency and frequency.
+ *
+ * @typedef cache_policy_t
+ *
+ */
+typedef enum cache_policy {
+	CACHE_LRU,
+	CACHE_ARC,
+} cache_policy_t;
+
+/**
+ * @brief Called with the key and value of every entry a cache evicts to make room.
+ *
+ * @typedef cache_evict_fn
+ *
+ */
+typedef void (*cache_evict_fn)(void *key, void *value, void *ctx);
+
+/**
+ * @brief Cache Creation Options
+ *
+ * @property policy (cache_policy_t): Replacement policy, CACHE_LRU by default.
+ * @property hash (ht_hash_fn): Hash function for keys, NULL for `ht_hash_string`.
+ * @property key_len (ht_key_len_fn): Optional key length callback passed through to `hash`.
+ * @property evict (cache_evict_fn): Optional callback for evicted entries.
+ * @property evict_ctx (void *): User context passed to `evict`.
+ *
+ * @typedef cache_options_t
+ *
+ */
+typedef struct cache_options {
+	cache_policy_t policy;
+	ht_hash_fn hash;
+	ht_key_len_fn key_len;
+	cache_evict_fn evict;
+	void *evict_ctx;
+} cache_options_t;
+
+/**
+ * @brief Cache Entry, the data of its recency list node.
+ *
+ * @property key (void *): Key of the entry, NULL for a remembered ARC key.
+ * @property value (void *): Value of the entry.
+ * @property hash (uint64_t): Hash of the key in the cache's table.
+ * @property node (dll_node_t *): Node of the entry in `list`.
+ * @property list (dll_t *): Recency list holding the entry.
+ *
+ * @typedef cache_entry_t
+ *
+ */
+typedef struct cache_entry {
+	void *key;
+	void *value;
+	uint64_t hash;
+	dll_node_t *node;
+	dll_t *list;
+} cache_entry_t;
+
+/**
+ * @brief Cache Structure
+ *
+ * @property table (hash_table_t *): Maps keys to their entries.
+ * @property ghosts (hash_table_t *): Maps key hashes to remembered ARC keys, NULL for LRU.
+ * @property recent (dll_t *): Entries seen once, most recent at the head. The only list for LRU.
+ * @property frequent (dll_t *): ARC entries seen at least twice.
+ * @property recent_ghosts (dll_t *): Hashes of keys ARC evicted from `recent`.
+ * @property frequent_ghosts (dll_t *): Hashes of keys ARC evicted from `frequent`.
+ * @property capacity (size_t): Maximum number of entries.
+ * @property target (size_t): Number of entries ARC aims to keep in `recent`.
+ * @property policy (cache_policy_t): Replacement policy.
+ * @property compare : User-defined comparison function for keys.
+ * @property evict (cache_evict_fn): Callback for evicted entries, may be NULL.
+ * @property evict_ctx (void *): User context passed to `evict`.
+ * @property hits (size_t): Lookups that found their key.
+ * @property misses (size_t): Lookups that did not.
+ * @property evictions (size_t): Entries evicted to make room.
+ *
+ * @typedef cache_t
+ *
+ */
+typedef struct cache {
+	hash_table_t *table;
+	hash_table_t *ghosts;
+	dll_t *recent;
+	dll_t *frequent;
+	dll_t *recent_ghosts;
+	dll_t *frequent_ghosts;
+	size_t capacity;
+	size_t target;
+	cache_policy_t policy;
+	int (*compare)(void *a, void *b);
+	cache_evict_fn evict;
+	void *evict_ctx;
+	size_t hits;
+	size_t misses;
+	size_t evictions;
+} cache_t;
+
+/**
+ * @brief Create a cache object.
+ *
+ * @param capacity (size_t): Maximum number of entries, at least 1.
+ * @param compare : User-defined comparison function for keys that must return an int.
+ * @param options (const cache_options_t *): Creation options, NULL for an LRU cache of string keys.
+ * @return (cache_t *): Pointer to cache structure, NULL on failure.
+ */
+cache_t *create_cache(size_t capacity, int (*compare)(void *a, void *b), const cache_options_t *options);
+
+/**
+ * @brief Destroy a cache object. The eviction callback is not called.
+ *
+ * @param cache (cache_t **): Double Pointer to cache structure.
+ * @param destroy : Optional user-defined destruction function for the key and value of each entry.
+ */
+void destroy_cache(cache_t **cache, void (*destroy)(void *key, void *value));
+
+/**
+ * @brief Look up the value of a key, marking the entry as used.
+ *
+ * @param cache (cache_t *): Pointer to cache structure.
+ * @param key (void *): Key to look up.
+ * @return (void *): Value of the key, NULL if it is not cached.
+ */
+void *cache_get(cache_t *cache, void *key);
+
+/**
+ * @brief Cache a value for a key, evicting an entry if the cache is full. The value of a key
+ * already cached is replaced without calling the eviction callback.
+ *
+ * @param cache (cache_t *): Pointer to cache structure.
+ * @param key (void *): Key to cache, which must stay valid while it is cached.
+ * @param value (void *): Value to cache.
+ * @return (int): 0 on success, -1 on failure.
+ */
+int cache_put(cache_t *cache, void *key, void *value);
+
+/**
+ * @brief Remove a key from a cache without calling the eviction callback.
+ *
+ * @param cache (cache_t *): Pointer to cache structure.
+ * @param key (void *): Key to remove.
+ * @return (int): 0 on successful removal, -1 if the key is not cached.
+ */
+int cache_remove(cache_t *cache, void *key);
+
+#endif // DSA_CACHE_H
@@ -0,0 +1,543 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "dsa_cht.h"
+
+/* Upper bound on writer locks per table */
+#define CHT_MAX_STRIPES 64
+/* Buckets a thread claims at a time while helping a resize */
+#define CHT_TRANSFER_CHUNK 64
+/* Retired entries between attempts to advance the epoch and reclaim memory */
+#define CHT_RECLAIM_EVERY 64
+
+/**
+ * Epoch based reclamation. Each thread owns a record publishing the epoch it entered the table in,
+ * or 0 while outside. Memory retired in epoch `e` is freed once the global epoch reaches `e + 2`,
+ * at which point every thread that could have seen it has left.
+ */
+typedef struct thread_record {
+	atomic_bool in_use;
+	atomic_uint_fast64_t state;
+} thread_record_t;
+
+static thread_record_t records[CHT_MAX_THREADS];
+static atomic_uint_fast64_t global_epoch = 1;
+static _Thread_local thread_record_t *self;
+static pthread_key_t record_key;
+static pthread_once_t record_once = PTHREAD_ONCE_INIT;
+
+/* Forwarding marker left in a bucket once its nodes live in the next bucket array */
+static cht_node_t moved;
+#define MOVED (&moved)
+
+static void release_record(void *record)
+{
+	thread_record_t *rec = record;
+	atomic_store(&rec->state, 0);
+	atomic_store(&rec->in_use, false);
+}
+
+static void create_record_key(void)
+{
+	pthread_key_create(&record_key, release_record);
+}
+
+static thread_record_t *claim_record(void)
+{
+	bool expected = false;
+
+	if (self) {
+		return self;
+	}
+	pthread_once(&record_once, create_record_key);
+	for (size_t i = 0; i < CHT_MAX_THREADS; i++) {
+		expected = false;
+		if (atomic_compare_exchange_strong(&records[i].in_use, &expected, true)) {
+			self = &records[i];
+			pthread_setspecific(record_key, self);
+			break;
+		}
+	}
+	return self;
+}
+
+/* Announce that the calling thread may start reading table memory */
+static thread_record_t *enter(void)
+{
+	thread_record_t *rec = claim_record();
+	if (rec) {
+		atomic_store(&rec->state, (atomic_load(&global_epoch) << 1) | 1);
+		atomic_thread_fence(memory_order_seq_cst);
+	}
+	return rec;
+}
+
+static void leave(thread_record_t *rec)
+{
+	atomic_store_explicit(&rec->state, 0, memory_order_release);
+}
+
+/* Move the global epoch forward if every thread inside a table has seen the current one */
+static void try_advance(void)
+{
+	uint_fast64_t epoch = atomic_load(&global_epoch);
+	uint_fast64_t state = 0;
+
+	for (size_t i = 0; i < CHT_MAX_THREADS; i++) {
+		if (!atomic_load(&records[i].in_use)) {
+			continue;
+		}
+		state = atomic_load(&records[i].state);
+		if ((state & 1) && (state >> 1) != epoch) {
+			return;
+		}
+	}
+	atomic_compare_exchange_strong(&global_epoch, &epoch, epoch + 1);
+}
+
+/* Free a whole limbo list. Caller holds retired_lock */
+static void release_list(concurrent_ht_t *cht, size_t list)
+{
+	cht_retired_t *entry = NULL;
+
+	while ((entry = cht->retired[list])) {
+		cht->retired[list] = entry->next;
+		entry->release(entry->ptr);
+		free(entry);
+		cht->retired_count--;
+	}
+}
+
+/* Free every limbo list that no thread can reach any more. Caller holds retired_lock */
+static void reclaim(concurrent_ht_t *cht)
+{
+	uint_fast64_t epoch = atomic_load(&global_epoch);
+
+	for (size_t list = 0; list < CHT_LIMBO_LISTS; list++) {
+		if (cht->retired[list] && cht->retired_epoch[list] + 2 <= epoch) {
+			release_list(cht, list);
+		}
+	}
+}
+
+static void retire(concurrent_ht_t *cht, void *ptr, void (*release)(void *ptr))
+{
+	cht_retired_t *entry = malloc(sizeof(cht_retired_t));
+	uint_fast64_t epoch = 0;
+	size_t list = 0;
+
+	if (!entry) {
+		/* Nothing can track the memory any more, so it is leaked rather than freed early */
+		perror("retire");
+		return;
+	}
+	pthread_mutex_lock(&cht->retired_lock);
+	epoch = atomic_load(&global_epoch);
+	list = epoch % CHT_LIMBO_LISTS;
+	/* A list last filled three or more epochs ago is already safe to free */
+	if (cht->retired_epoch[list] != epoch) {
+		release_list(cht, list);
+		cht->retired_epoch[list] = epoch;
+	}
+	entry->ptr = ptr;
+	entry->release = release;
+	entry->next = cht->retired[list];
+	cht->retired[list] = entry;
+	if (++cht->retired_count % CHT_RECLAIM_EVERY == 0) {
+		try_advance();
+		reclaim(cht);
+	}
+	pthread_mutex_unlock(&cht->retired_lock);
+}
+
+static void free_chain(void *ptr)
+{
+	cht_node_t *node = ptr;
+	cht_node_t *next = NULL;
+
+	while (node) {
+		next = atomic_load_explicit(&node->next, memory_order_relaxed);
+		free(node);
+		node = next;
+	}
+}
+
+static uint64_t hash_key(concurrent_ht_t *cht, void *data)
+{
+	size_t len = cht->key_len ? cht->key_len(data) : 0;
+	return cht->hash(data, len);
+}
+
+/* Bucket heads are allocated together with the table header so a table is retired in one piece */
+static cht_table_t *create_table(size_t capacity)
+{
+	cht_table_t *table = calloc(1, sizeof(cht_table_t) + capacity * sizeof(_Atomic(cht_node_t *)));
+	if (table) {
+		table->capacity = capacity;
+		table->buckets = (_Atomic(cht_node_t *) *)(table + 1);
+		for (size_t i = 0; i < capacity; i++) {
+			atomic_init(&table->buckets[i], NULL);
+		}
+	}
+	return table;
+}
+
+static pthread_mutex_t *stripe(concurrent_ht_t *cht, size_t bucket)
+{
+	return &cht->stripes[bucket & (cht->nstripes - 1)];
+}
+
+/**
+ * Copy one bucket into the next table and leave a forwarding marker. Readers may still be
+ * walking the old chain, so its nodes are copied rather than relinked and retired afterwards.
+ * Old bucket `b` maps onto new buckets `b` and `b + capacity`, which share its stripe.
+ *
+ * @return (int) 1 if this call moved the bucket, 0 if it had already moved, -1 if a copy could
+ * not be allocated. The bucket then stays in the old table, where readers and writers keep
+ * finding it, until a retry moves it.
+ */
+static int transfer_bucket(concurrent_ht_t *cht, cht_table_t *table, cht_table_t *next, size_t bucket)
+{
+	int ret_val = -1;
+	pthread_mutex_t *lock = stripe(cht, bucket);
+	cht_node_t *chain = NULL;
+	cht_node_t *node = NULL;
+	cht_node_t *copy = NULL;
+	cht_node_t *split[2] = { NULL, NULL };
+	size_t half = 0;
+
+	pthread_mutex_lock(lock);
+	chain = atomic_load_explicit(&table->buckets[bucket], memory_order_relaxed);
+	/* A retry may have reached the bucket before the thread whose chunk holds it */
+	if (chain == MOVED) {
+		pthread_mutex_unlock(lock);
+		ret_val = 0;
+		goto ret;
+	}
+	/* Both halves are built privately, so a failed copy leaves nothing behind in the next table */
+	for (node = chain; node; node = atomic_load_explicit(&node->next, memory_order_relaxed)) {
+		copy = cht->node_alloc(sizeof(cht_node_t));
+		if (!copy) {
+			free_chain(split[0]);
+			free_chain(split[1]);
+			pthread_mutex_unlock(lock);
+			goto ret;
+		}
+		half = (node->hash & table->capacity) != 0;
+		copy->hash = node->hash;
+		copy->data = node->data;
+		atomic_init(&copy->next, split[half]);
+		split[half] = copy;
+	}
+	atomic_store_explicit(&next->buckets[bucket], split[0], memory_order_release);
+	atomic_store_explicit(&next->buckets[bucket + table->capacity], split[1], memory_order_release);
+	atomic_store_explicit(&table->buckets[bucket], MOVED, memory_order_release);
+	pthread_mutex_unlock(lock);
+
+	if (chain) {
+		retire(cht, chain, free_chain);
+	}
+
+	ret_val = 1;
+ret:
+	return ret_val;
+}
+
+/* Move buckets start to end, counting the ones that failed so they are retried */
+static size_t transfer_range(concurrent_ht_t *cht, cht_table_t *table, cht_table_t *next, size_t start, size_t end)
+{
+	size_t moved_buckets = 0;
+	int moved = 0;
+
+	for (size_t bucket = start; bucket < end; bucket++) {
+		moved = transfer_bucket(cht, table, next, bucket);
+		if (moved == -1) {
+			atomic_fetch_add(&table->failed, 1);
+		} else {
+			moved_buckets += moved;
+		}
+	}
+	return moved_buckets;
+}
+
+/* Count moved buckets. The thread moving the last one publishes the new table */
+static void finish_transfer(concurrent_ht_t *cht, cht_table_t *table, cht_table_t *next, size_t moved_buckets)
+{
+	if (moved_buckets &&
+	    atomic_fetch_add(&table->transferred, moved_buckets) + moved_buckets == table->capacity) {
+		atomic_store_explicit(&cht->table, next, memory_order_release);
+		retire(cht, table, free);
+	}
+}
+
+/**
+ * Claim and move chunks of buckets until the whole resize has been handed out. Buckets that
+ * failed to move are queued again: one writer at a time sweeps the table for them, so a resize
+ * interrupted by an allocation failure still completes once memory is available.
+ */
+static void help_transfer(concurrent_ht_t *cht, cht_table_t *table)
+{
+	cht_table_t *next = atomic_load_explicit(&table->next, memory_order_acquire);
+	size_t start = 0;
+	size_t end = 0;
+
+	if (!next) {
+		return;
+	}
+
+	while ((start = atomic_fetch_add(&table->transfer_index, CHT_TRANSFER_CHUNK)) < table->capacity) {
+		end = start + CHT_TRANSFER_CHUNK < table->capacity ? start + CHT_TRANSFER_CHUNK : table->capacity;
+		finish_transfer(cht, table, next, transfer_range(cht, table, next, start, end));
+	}
+
+	if (atomic_load(&table->failed) && pthread_mutex_trylock(&cht->resize_lock) == 0) {
+		/* The table is only retired once every bucket has moved, so it is still ours to sweep */
+		if (atomic_exchange(&table->failed, 0)) {
+			finish_transfer(cht, table, next, transfer_range(cht, table, next, 0, table->capacity));
+		}
+		pthread_mutex_unlock(&cht->resize_lock);
+	}
+}
+
+static void start_resize(concurrent_ht_t *cht, cht_table_t *table)
+{
+	cht_table_t *next = NULL;
+
+	pthread_mutex_lock(&cht->resize_lock);
+	if (atomic_load(&cht->table) == table && !atomic_load(&table->next)) {
+		next = create_table(table->capacity * 2);
+		if (next) {
+			atomic_store_explicit(&table->next, next, memory_order_release);
+		}
+	}
+	pthread_mutex_unlock(&cht->resize_lock);
+}
+
+/**
+ * Lock the stripe of the bucket `hash` maps to in the newest table that still owns it. Writers
+ * that run into a moved bucket help the resize along before following it to the next table.
+ *
+ * @return (cht_table_t *) Table whose bucket is locked in `*lock`.
+ */
+static cht_table_t *lock_bucket(concurrent_ht_t *cht, uint64_t hash, pthread_mutex_t **lock)
+{
+	cht_table_t *table = atomic_load_explicit(&cht->table, memory_order_acquire);
+	cht_table_t *next = NULL;
+	size_t bucket = 0;
+
+	for (;;) {
+		bucket = hash & (table->capacity - 1);
+		*lock = stripe(cht, bucket);
+		pthread_mutex_lock(*lock);
+		if (atomic_load_explicit(&table->buckets[bucket], memory_order_relaxed) != MOVED) {
+			return table;
+		}
+		pthread_mutex_unlock(*lock);
+		next = atomic_load_explicit(&table->next, memory_order_acquire);
+		help_transfer(cht, table);
+		table = next;
+	}
+}
+
+concurrent_ht_t *create_cht(size_t capacity, ht_hash_fn hash, ht_key_len_fn key_len)
+{
+	size_t buckets = 16;
+	concurrent_ht_t *cht = calloc(1, sizeof(concurrent_ht_t));
+	if (!cht) {
+		goto ret;
+	}
+
+	while (buckets < capacity) {
+		buckets *= 2;
+	}
+	/* Stripes never outnumber buckets, so a stripe covers a bucket and everything it splits into */
+	cht->nstripes = buckets < CHT_MAX_STRIPES ? buckets : CHT_MAX_STRIPES;
+	cht->stripes = calloc(cht->nstripes, sizeof(pthread_mutex_t));
+	cht_table_t *table = create_table(buckets);
+	if (!cht->stripes || !table) {
+		free(cht->stripes);
+		free(table);
+		free(cht);
+		cht = NULL;
+		goto ret;
+	}
+	for (size_t i = 0; i < cht->nstripes; i++) {
+		pthread_mutex_init(&cht->stripes[i], NULL);
+	}
+	pthread_mutex_init(&cht->resize_lock, NULL);
+	pthread_mutex_init(&cht->retired_lock, NULL);
+	atomic_init(&cht->table, table);
+	atomic_init(&cht->items, 0);
+	cht->load_factor = 0.75;
+	cht->hash = hash ? hash : ht_hash_string;
+	cht->key_len = key_len;
+	cht->node_alloc = malloc;
+
+ret:
+	return cht;
+}
+
+void destroy_cht(concurrent_ht_t **cht, void (*destroy)(void *))
+{
+	cht_table_t *table = NULL;
+	cht_table_t *next = NULL;
+	cht_node_t *node = NULL;
+
+	if (*cht == NULL) {
+		return;
+	}
+
+	/* Items of an unfinished resize are split between the table and its successor */
+	table = atomic_load(&(*cht)->table);
+	while (table) {
+		for (size_t i = 0; i < table->capacity; i++) {
+			node = atomic_load(&table->buckets[i]);
+			if (node == MOVED) {
+				continue;
+			}
+			for (cht_node_t *n = node; n; n = atomic_load(&n->next)) {
+				destroy(n->data);
+			}
+			free_chain(node);
+		}
+		next = atomic_load(&table->next);
+		free(table);
+		table = next;
+	}
+
+	for (size_t list = 0; list < CHT_LIMBO_LISTS; list++) {
+		release_list(*cht, list);
+	}
+
+	for (size_t i = 0; i < (*cht)->nstripes; i++) {
+		pthread_mutex_destroy(&(*cht)->stripes[i]);
+	}
+	pthread_mutex_destroy(&(*cht)->resize_lock);
+	pthread_mutex_destroy(&(*cht)->retired_lock);
+	free((*cht)->stripes);
+	free(*cht);
+	*cht = NULL;
+}
+
+int insert_cht(concurrent_ht_t *cht, void *data, int (*compare)(void *a, void *b))
+{
+	int ret_val = -1;
+	thread_record_t *rec = NULL;
+	pthread_mutex_t *lock = NULL;
+	cht_table_t *table = NULL;
+	cht_node_t *head = NULL;
+	cht_node_t *node = NULL;
+
+	if (cht == NULL || !(rec = enter())) {
+		goto ret;
+	}
+
+	uint64_t hash = hash_key(cht, data);
+	table = lock_bucket(cht, hash, &lock);
+	_Atomic(cht_node_t *) *bucket = &table->buckets[hash & (table->capacity - 1)];
+
+	/* Item already exists */
+	head = atomic_load_explicit(bucket, memory_order_relaxed);
+	for (node = head; node; node = atomic_load_explicit(&node->next, memory_order_relaxed)) {
+		if (node->hash == hash && compare(node->data, data) == 0) {
+			pthread_mutex_unlock(lock);
+			goto leave;
+		}
+	}
+
+	node = cht->node_alloc(sizeof(cht_node_t));
+	if (!node) {
+		pthread_mutex_unlock(lock);
+		goto leave;
+	}
+	node->hash = hash;
+	node->data = data;
+	atomic_init(&node->next, head);
+	/* Publish the fully built node to lock-free readers */
+	atomic_store_explicit(bucket, node, memory_order_release);
+	pthread_mutex_unlock(lock);
+
+	if (atomic_fetch_add(&cht->items, 1) + 1 > table->capacity * cht->load_factor) {
+		start_resize(cht, table);
+	}
+	/* Every writer that sees a resize in progress moves part of it */
+	table = atomic_load_explicit(&cht->table, memory_order_acquire);
+	help_transfer(cht, table);
+
+	ret_val = 0;
+leave:
+	leave(rec);
+ret:
+	return ret_val;
+}
+
+void *search_cht(concurrent_ht_t *cht, void *data, int (*compare)(void *a, void *b))
+{
+	void *found = NULL;
+	thread_record_t *rec = NULL;
+	cht_table_t *table = NULL;
+	cht_node_t *node = NULL;
+
+	if (cht == NULL || !(rec = enter())) {
+		goto ret;
+	}
+
+	uint64_t hash = hash_key(cht, data);
+	table = atomic_load_explicit(&cht->table, memory_order_acquire);
+	node = atomic_load_explicit(&table->buckets[hash & (table->capacity - 1)], memory_order_acquire);
+
+	/* Follow forwarding markers into the table the bucket was moved to */
+	while (node == MOVED) {
+		table = atomic_load_explicit(&table->next, memory_order_acquire);
+		node = atomic_load_explicit(&table->buckets[hash & (table->capacity - 1)], memory_order_acquire);
+	}
+
+	for (; node; node = atomic_load_explicit(&node->next, memory_order_acquire)) {
+		if (node->hash == hash && compare(node->data, data) == 0) {
+			found = node->data;
+			break;
+		}
+	}
+
+	leave(rec);
+ret:
+	return found;
+}
+
+int delete_cht_item(concurrent_ht_t *cht, void *data, int (*compare)(void *a, void *b))
+{
+	int ret_val = -1;
+	thread_record_t *rec = NULL;
+	pthread_mutex_t *lock = NULL;
+	cht_table_t *table = NULL;
+	cht_node_t *node = NULL;
+
+	if (cht == NULL || !(rec = enter())) {
+		goto ret;
+	}
+
+	uint64_t hash = hash_key(cht, data);
+	table = lock_bucket(cht, hash, &lock);
+	_Atomic(cht_node_t *) *link = &table->buckets[hash & (table->capacity - 1)];
+
+	while ((node = atomic_load_explicit(link, memory_order_relaxed))) {
+		if (node->hash == hash && compare(node->data, data) == 0) {
+			/* Readers already on the node still find its successor */
+			atomic_store_explicit(link, atomic_load_explicit(&node->next, memory_order_relaxed),
+					      memory_order_release);
+			ret_val = 0;
+			break;
+		}
+		link = &node->next;
+	}
+	pthread_mutex_unlock(lock);
+
+	if (ret_val == 0) {
+		atomic_fetch_sub(&cht->items, 1);
+		retire(cht, node, free);
+	}
+
+	leave(rec);
+ret:
+	return ret_val;
+}
@@ -0,0 +1,175 @@
+#ifndef DSA_CHT_H
+#define DSA_CHT_H
+
+/**
+ * @file dsa_cht.h
+ * @author ajester (alex.m.jester.mil@army.mil)
+ * @brief Concurrent Hash Table Library.
+ * @version 0.1
+ * @date 2021-10-26
+ *
+ * @details Concurrent Hash Table (CHT) - A thread safe Set ADT with the same insert, search and
+ * delete semantics as `hash_table_t`. Readers never take a lock. Writers lock one stripe of
+ * buckets, and a resize is shared between all writers that run into it, each moving a chunk of
+ * buckets. Removed nodes and retired bucket arrays are freed through epoch based reclamation once
+ * no thread can still be reading them.
+ *
+ * Every thread that uses a table holds one of CHT_MAX_THREADS reclamation records, shared by all
+ * tables, from its first operation until it exits. While all of them are held, operations from
+ * any other thread fail: `insert_cht` and `delete_cht_item` return -1 and `search_cht` returns
+ * NULL, as if the data were absent.
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "dsa_ht.h"
+
+/* Live threads that can use concurrent tables, a thread keeps its slot until it exits */
+#define CHT_MAX_THREADS 256
+/* Retired memory is kept in one list per epoch modulo this count */
+#define CHT_LIMBO_LISTS 3
+
+/**
+ * @brief Concurrent Hash Table Node
+ *
+ * @property hash (uint64_t): Full 64 bit hash of data.
+ * @property data (void *): Data stored in the table.
+ * @property next (struct cht_node *): Next node in the bucket.
+ *
+ * @typedef cht_node_t
+ *
+ */
+typedef struct cht_node {
+	uint64_t hash;
+	void *data;
+	_Atomic(struct cht_node *) next;
+} cht_node_t;
+
+/**
+ * @brief Concurrent Hash Table Bucket Array
+ *
+ * @property capacity (size_t): Number of buckets, always a power of two.
+ * @property buckets (cht_node_t **): Bucket heads. A moved bucket holds a forwarding marker.
+ * @property next (struct cht_table *): Bucket array being filled by a resize, NULL otherwise.
+ * @property transfer_index (size_t): Next bucket to hand out to a thread helping the resize.
+ * @property transferred (size_t): Number of buckets moved to `next`.
+ * @property failed (size_t): Buckets that could not be moved and wait for a retry.
+ *
+ * @typedef cht_table_t
+ *
+ */
+typedef struct cht_table {
+	size_t capacity;
+	_Atomic(cht_node_t *) *buckets;
+	_Atomic(struct cht_table *) next;
+	atomic_size_t transfer_index;
+	atomic_size_t transferred;
+	atomic_size_t failed;
+} cht_table_t;
+
+/**
+ * @brief Retired memory waiting for every reader to leave.
+ *
+ * @property ptr (void *): Memory to free.
+ * @property release : Function that frees `ptr`.
+ * @property next (struct cht_retired *): Next retired entry.
+ *
+ * @typedef cht_retired_t
+ *
+ */
+typedef struct cht_retired {
+	void *ptr;
+	void (*release)(void *ptr);
+	struct cht_retired *next;
+} cht_retired_t;
+
+/**
+ * @brief Concurrent Hash Table Structure
+ *
+ * @property table (cht_table_t *): Current bucket array.
+ * @property items (size_t): Number of items in the table.
+ * @property load_factor (double): Items per bucket that start a resize.
+ * @property stripes (pthread_mutex_t *): Writer locks, bucket `b` is guarded by `stripes[b % nstripes]`.
+ * @property nstripes (size_t): Number of writer locks, a power of two no larger than the initial capacity.
+ * @property resize_lock (pthread_mutex_t): Serialises starting a resize.
+ * @property retired (cht_retired_t *[]): Memory waiting to be reclaimed, one list per epoch.
+ * @property retired_epoch (uint64_t []): Epoch each list in `retired` was filled in.
+ * @property retired_count (size_t): Total length of the `retired` lists.
+ * @property retired_lock (pthread_mutex_t): Guards the retired list. Only writers retire memory.
+ * @property hash (ht_hash_fn): Hash function applied to every key.
+ * @property key_len (ht_key_len_fn): Key length callback, NULL if the hash function finds the length itself.
+ * @property node_alloc : Allocates nodes, `malloc` unless replaced. Nodes are released with `free`.
+ *
+ * @typedef concurrent_ht_t
+ *
+ */
+typedef struct concurrent_hash_table {
+	_Atomic(cht_table_t *) table;
+	atomic_size_t items;
+	double load_factor;
+	pthread_mutex_t *stripes;
+	size_t nstripes;
+	pthread_mutex_t resize_lock;
+	cht_retired_t *retired[CHT_LIMBO_LISTS];
+	uint64_t retired_epoch[CHT_LIMBO_LISTS];
+	size_t retired_count;
+	pthread_mutex_t retired_lock;
+	ht_hash_fn hash;
+	ht_key_len_fn key_len;
+	void *(*node_alloc)(size_t size);
+} concurrent_ht_t;
+
+/**
+ * @brief Create a concurrent hash table object.
+ *
+ * @param capacity (size_t): Initial number of buckets, rounded up to a power of two.
+ * @param hash (ht_hash_fn): Hash function for keys, NULL for `ht_hash_string`.
+ * @param key_len (ht_key_len_fn): Optional key length callback passed through to `hash`.
+ * @return (concurrent_ht_t *): Pointer to concurrent hash table structure, NULL on failure.
+ */
+concurrent_ht_t *create_cht(size_t capacity, ht_hash_fn hash, ht_key_len_fn key_len);
+
+/**
+ * @brief Destroy a concurrent hash table object. No other thread may be using the table.
+ *
+ * @param cht (concurrent_ht_t **): Double Pointer to concurrent hash table structure.
+ * @param destroy : User-defined destruction function to be performed on each item's data.
+ */
+void destroy_cht(concurrent_ht_t **cht, void (*destroy)(void *));
+
+/**
+ * @brief Insert data into a concurrent hash table.
+ *
+ * @param cht (concurrent_ht_t *): Pointer to concurrent hash table structure.
+ * @param data (void *): Pointer to data that will be inserted.
+ * @param compare : User-defined comparison function that must return an int.
+ * @return (int): 0 on successful insertion, -1 if the data already exists or on failure.
+ */
+int insert_cht(concurrent_ht_t *cht, void *data, int (*compare)(void *a, void *b));
+
+/**
+ * @brief Search a concurrent hash table for given data without taking any lock.
+ *
+ * @param cht (concurrent_ht_t *): Pointer to concurrent hash table structure.
+ * @param data (void *): Pointer to data to be hashed and searched.
+ * @param compare : User-defined comparison function that must return an int.
+ * @return (void *): The stored data equal to `data`, NULL if not found.
+ */
+void *search_cht(concurrent_ht_t *cht, void *data, int (*compare)(void *a, void *b));
+
+/**
+ * @brief Delete data from a concurrent hash table.
+ *
+ * @param cht (concurrent_ht_t *): Pointer to concurrent hash table structure.
+ * @param data (void *): Pointer to data to be hashed, searched, and deleted.
+ * @param compare : User-defined comparison function that must return an int.
+ * @return (int): 0 on successful deletion, -1 on failure.
+ */
+int delete_cht_item(concurrent_ht_t *cht, void *data, int (*compare)(void *a, void *b));
+
+#endif // DSA_CHT_H
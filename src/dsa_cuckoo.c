@@ -0,0 +1,352 @@
+#include <stdlib.h>
+#include <string.h>
+#include "dsa_cuckoo.h"
+#include "dsa_hash.h"
+
+/* Items moved along one insert path before the item left over goes to the stash */
+#define CUCKOO_MAX_KICKS 256
+/* Seeds tried by a rehash before it gives up */
+#define CUCKOO_MAX_REHASH 4
+
+static uint64_t hash_key(cuckoo_ht_t *ct, void *data)
+{
+	size_t len = ct->key_len ? ct->key_len(data) : 0;
+	uint64_t hash = ct->hash(data, len);
+
+	/* 0 marks an empty slot */
+	return hash ? hash : 1;
+}
+
+/* The two buckets of a hash, both taken from one mix of the hash and the table seed */
+static void buckets_of(const cuckoo_ht_t *ct, uint64_t hash, size_t *b1, size_t *b2)
+{
+	uint64_t mixed = dsa_hash_u64(hash ^ ct->seed);
+	size_t mask = ct->nbuckets - 1;
+
+	*b1 = mixed & mask;
+	*b2 = (mixed >> 32) & mask;
+	/* Distinct buckets give every key 2 * CUCKOO_BUCKET_SLOTS slots */
+	if (*b2 == *b1) {
+		*b2 = *b1 ^ 1;
+	}
+}
+
+/* xorshift64* - picks the item to move out of a full bucket */
+static uint64_t next_random(cuckoo_ht_t *ct)
+{
+	ct->rng ^= ct->rng >> 12;
+	ct->rng ^= ct->rng << 25;
+	ct->rng ^= ct->rng >> 27;
+	return ct->rng * 0x2545f4914f6cdd1du;
+}
+
+static cuckoo_bucket_t *create_buckets(size_t nbuckets)
+{
+	cuckoo_bucket_t *buckets = aligned_alloc(sizeof(cuckoo_bucket_t), nbuckets * sizeof(cuckoo_bucket_t));
+	if (buckets) {
+		memset(buckets, 0, nbuckets * sizeof(cuckoo_bucket_t));
+	}
+	return buckets;
+}
+
+static cuckoo_slot_t *find_in_bucket(cuckoo_bucket_t *bucket, uint64_t hash, void *data,
+				     int (*compare)(void *a, void *b))
+{
+	for (int i = 0; i < CUCKOO_BUCKET_SLOTS; i++) {
+		if (bucket->slots[i].hash == hash && compare(bucket->slots[i].data, data) == 0) {
+			return &bucket->slots[i];
+		}
+	}
+	return NULL;
+}
+
+static cuckoo_slot_t *free_in_bucket(cuckoo_bucket_t *bucket)
+{
+	for (int i = 0; i < CUCKOO_BUCKET_SLOTS; i++) {
+		if (!bucket->slots[i].hash) {
+			return &bucket->slots[i];
+		}
+	}
+	return NULL;
+}
+
+static cuckoo_slot_t *find(cuckoo_ht_t *ct, uint64_t hash, void *data, int (*compare)(void *a, void *b))
+{
+	cuckoo_slot_t *slot = NULL;
+	size_t b1 = 0;
+	size_t b2 = 0;
+
+	buckets_of(ct, hash, &b1, &b2);
+	/* Both cache lines are requested before either is read */
+	__builtin_prefetch(&ct->buckets[b2]);
+
+	slot = find_in_bucket(&ct->buckets[b1], hash, data, compare);
+	if (!slot) {
+		slot = find_in_bucket(&ct->buckets[b2], hash, data, compare);
+	}
+	for (size_t i = 0; !slot && i < ct->stash_items; i++) {
+		if (ct->stash[i].hash == hash && compare(ct->stash[i].data, data) == 0) {
+			slot = &ct->stash[i];
+		}
+	}
+	return slot;
+}
+
+/**
+ * Place an item without checking for duplicates. When both of its buckets are full a random item
+ * is moved out to its other bucket, which may in turn move another, and the item left over after
+ * CUCKOO_MAX_KICKS moves goes to the stash.
+ *
+ * @return (int) 0 on success, -1 if both buckets are full and the stash has no room.
+ */
+static int place(cuckoo_ht_t *ct, uint64_t hash, void *data)
+{
+	cuckoo_slot_t carry = { .hash = hash, .data = data };
+	cuckoo_slot_t swap;
+	cuckoo_slot_t *slot = NULL;
+	size_t b1 = 0;
+	size_t b2 = 0;
+	size_t b = 0;
+
+	buckets_of(ct, hash, &b1, &b2);
+	slot = free_in_bucket(&ct->buckets[b1]);
+	if (!slot) {
+		slot = free_in_bucket(&ct->buckets[b2]);
+	}
+	if (slot) {
+		*slot = carry;
+		return 0;
+	}
+	/* The walk may end in the stash, so it only starts with room there */
+	if (ct->stash_items == CUCKOO_STASH_SIZE) {
+		return -1;
+	}
+
+	b = (next_random(ct) & 1) ? b1 : b2;
+	for (int kick = 0; kick < CUCKOO_MAX_KICKS; kick++) {
+		slot = &ct->buckets[b].slots[next_random(ct) % CUCKOO_BUCKET_SLOTS];
+		swap = *slot;
+		*slot = carry;
+		carry = swap;
+
+		/* The evicted item goes to the bucket it was not in */
+		buckets_of(ct, carry.hash, &b1, &b2);
+		b = (b == b1) ? b2 : b1;
+		slot = free_in_bucket(&ct->buckets[b]);
+		if (slot) {
+			*slot = carry;
+			return 0;
+		}
+	}
+
+	ct->stash[ct->stash_items++] = carry;
+	return 0;
+}
+
+/* Place every item of `from` into `to`, leaving room in the stash of `to` for one more item */
+static int move_all(cuckoo_ht_t *from, cuckoo_ht_t *to)
+{
+	cuckoo_slot_t *slot = NULL;
+
+	for (size_t b = 0; b < from->nbuckets; b++) {
+		for (int i = 0; i < CUCKOO_BUCKET_SLOTS; i++) {
+			slot = &from->buckets[b].slots[i];
+			if (slot->hash && place(to, slot->hash, slot->data) == -1) {
+				return -1;
+			}
+		}
+	}
+	for (size_t i = 0; i < from->stash_items; i++) {
+		if (place(to, from->stash[i].hash, from->stash[i].data) == -1) {
+			return -1;
+		}
+	}
+	return to->stash_items < CUCKOO_STASH_SIZE ? 0 : -1;
+}
+
+/**
+ * Move every item into `nbuckets` new buckets under a new seed. The stored hashes are mixed with
+ * the seed to pick buckets, so keys are never hashed again. A seed that leaves the stash full is
+ * replaced, up to CUCKOO_MAX_REHASH times, and the table is left as it was if none works.
+ */
+static int rehash(cuckoo_ht_t *ct, size_t nbuckets)
+{
+	int ret_val = -1;
+	cuckoo_ht_t next;
+
+	for (int attempt = 0; attempt < CUCKOO_MAX_REHASH; attempt++) {
+		/* Draw the seed first so the random state carried into `next` has moved past it */
+		uint64_t seed = next_random(ct);
+		next = *ct;
+		next.nbuckets = nbuckets;
+		next.stash_items = 0;
+		next.seed = seed;
+		next.buckets = create_buckets(nbuckets);
+		if (!next.buckets) {
+			goto ret;
+		}
+		if (move_all(ct, &next) == 0) {
+			free(ct->buckets);
+			*ct = next;
+			ret_val = 0;
+			goto ret;
+		}
+		free(next.buckets);
+	}
+
+ret:
+	return ret_val;
+}
+
+/* Move stashed items into any bucket that has room for them again */
+static void drain_stash(cuckoo_ht_t *ct)
+{
+	cuckoo_slot_t *slot = NULL;
+	size_t b1 = 0;
+	size_t b2 = 0;
+
+	for (size_t i = 0; i < ct->stash_items;) {
+		buckets_of(ct, ct->stash[i].hash, &b1, &b2);
+		slot = free_in_bucket(&ct->buckets[b1]);
+		if (!slot) {
+			slot = free_in_bucket(&ct->buckets[b2]);
+		}
+		if (!slot) {
+			i++;
+			continue;
+		}
+		*slot = ct->stash[i];
+		ct->stash[i] = ct->stash[--ct->stash_items];
+		memset(&ct->stash[ct->stash_items], 0, sizeof(cuckoo_slot_t));
+	}
+}
+
+cuckoo_ht_t *create_cuckoo(size_t capacity, ht_hash_fn hash, ht_key_len_fn key_len)
+{
+	size_t nbuckets = 2;
+	cuckoo_ht_t *ct = calloc(1, sizeof(cuckoo_ht_t));
+	if (!ct) {
+		goto ret;
+	}
+
+	while (nbuckets * CUCKOO_BUCKET_SLOTS < capacity) {
+		nbuckets *= 2;
+	}
+	ct->buckets = create_buckets(nbuckets);
+	if (!ct->buckets) {
+		free(ct);
+		ct = NULL;
+		goto ret;
+	}
+	ct->nbuckets = nbuckets;
+	ct->items = 0;
+	ct->load_factor = 0.9;
+	ct->rng = 0x9e3779b97f4a7c15u;
+	ct->hash = hash ? hash : ht_hash_string;
+	ct->key_len = key_len;
+
+ret:
+	return ct;
+}
+
+void destroy_cuckoo(cuckoo_ht_t **ct, void (*destroy)(void *))
+{
+	if (*ct == NULL) {
+		return;
+	}
+	for (size_t b = 0; b < (*ct)->nbuckets; b++) {
+		for (int i = 0; i < CUCKOO_BUCKET_SLOTS; i++) {
+			if ((*ct)->buckets[b].slots[i].hash) {
+				destroy((*ct)->buckets[b].slots[i].data);
+			}
+		}
+	}
+	for (size_t i = 0; i < (*ct)->stash_items; i++) {
+		destroy((*ct)->stash[i].data);
+	}
+
+	free((*ct)->buckets);
+	free(*ct);
+	*ct = NULL;
+}
+
+int insert_cuckoo(cuckoo_ht_t *ct, void *data, int (*compare)(void *a, void *b))
+{
+	int ret_val = -1;
+	uint64_t hash = 0;
+
+	if (ct == NULL) {
+		goto ret;
+	}
+	hash = hash_key(ct, data);
+
+	/* Item already exists */
+	if (find(ct, hash, data, compare)) {
+		goto ret;
+	}
+
+	/* Grow before insert paths get long, doubling the buckets */
+	if ((double)(ct->items + 1) > ct->nbuckets * CUCKOO_BUCKET_SLOTS * ct->load_factor &&
+	    rehash(ct, ct->nbuckets * 2) == -1) {
+		goto ret;
+	}
+
+	/*
+	 * A full stash means the seed spreads the keys badly. Rehash at the same size first and grow
+	 * only if the table is at least half full - below that, the keys share too many full hashes
+	 * for more buckets to help.
+	 */
+	if (ct->stash_items == CUCKOO_STASH_SIZE && rehash(ct, ct->nbuckets) == -1) {
+		if (ct->items * 2 < ct->nbuckets * CUCKOO_BUCKET_SLOTS || rehash(ct, ct->nbuckets * 2) == -1) {
+			goto ret;
+		}
+	}
+
+	if (place(ct, hash, data) == -1) {
+		goto ret;
+	}
+	ct->items++;
+
+	ret_val = 0;
+ret:
+	return ret_val;
+}
+
+void *search_cuckoo(cuckoo_ht_t *ct, void *data, int (*compare)(void *a, void *b))
+{
+	cuckoo_slot_t *slot = NULL;
+
+	if (ct == NULL) {
+		return NULL;
+	}
+	slot = find(ct, hash_key(ct, data), data, compare);
+	return slot ? slot->data : NULL;
+}
+
+int delete_cuckoo_item(cuckoo_ht_t *ct, void *data, int (*compare)(void *a, void *b))
+{
+	int ret_val = -1;
+	cuckoo_slot_t *slot = NULL;
+
+	if (ct == NULL) {
+		goto ret;
+	}
+	slot = find(ct, hash_key(ct, data), data, compare);
+	if (!slot) {
+		goto ret;
+	}
+
+	if (slot >= ct->stash && slot < ct->stash + CUCKOO_STASH_SIZE) {
+		*slot = ct->stash[--ct->stash_items];
+		memset(&ct->stash[ct->stash_items], 0, sizeof(cuckoo_slot_t));
+	} else {
+		memset(slot, 0, sizeof(cuckoo_slot_t));
+		/* The freed slot may be one a stashed item belongs in */
+		drain_stash(ct);
+	}
+	ct->items--;
+
+	ret_val = 0;
+ret:
+	return ret_val;
+}
@@ -0,0 +1,135 @@
+#ifndef DSA_CUCKOO_H
+#define DSA_CUCKOO_H
+
+/**
+ * @file dsa_cuckoo.h
+ * @author ajester (alex.m.jester.mil@army.mil)
+ * @brief Cuckoo Hash Table Library.
+ * @version 0.1
+ * @date 2021-10-26
+ *
+ * @details Cuckoo Hash Table - A Set ADT with the same insert, search and delete semantics as
+ * `hash_table_t`. Every item lives in one of two 4 slot buckets chosen by its hash, so a lookup
+ * reads at most two cache lines plus a small stash that is only checked while it holds items.
+ * Inserts make room by moving items to their other bucket, fall back to the stash when that takes
+ * too long, and rehash the table once the stash is full.
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "dsa_ht.h"
+
+/* Slots per bucket, 4 slots of 16 bytes fill one cache line */
+#define CUCKOO_BUCKET_SLOTS 4
+/* Items that could not be placed in either of their buckets */
+#define CUCKOO_STASH_SIZE 4
+
+/**
+ * @brief Cuckoo Hash Table Slot
+ *
+ * @property hash (uint64_t): Full 64 bit hash of data, 0 for an empty slot.
+ * @property data (void *): Data stored in the slot.
+ *
+ * @typedef cuckoo_slot_t
+ *
+ */
+typedef struct cuckoo_slot {
+	uint64_t hash;
+	void *data;
+} cuckoo_slot_t;
+
+/**
+ * @brief Cuckoo Hash Table Bucket, aligned to a cache line.
+ *
+ * @property slots (cuckoo_slot_t []): Slots of the bucket.
+ *
+ * @typedef cuckoo_bucket_t
+ *
+ */
+typedef struct cuckoo_bucket {
+	_Alignas(64) cuckoo_slot_t slots[CUCKOO_BUCKET_SLOTS];
+} cuckoo_bucket_t;
+
+/**
+ * @brief Cuckoo Hash Table Structure
+ *
+ * @property buckets (cuckoo_bucket_t *): Array of buckets.
+ * @property nbuckets (size_t): Number of buckets, always a power of two.
+ * @property items (size_t): Number of items in the table, including the stash.
+ * @property load_factor (double): Share of slots in use that makes the table grow.
+ * @property stash (cuckoo_slot_t []): Items that did not fit in either of their buckets.
+ * @property stash_items (size_t): Number of items in `stash`.
+ * @property seed (uint64_t): Seed mixed into the hash to pick buckets, changed by every rehash.
+ * @property rng (uint64_t): State for choosing which item to move out of a full bucket.
+ * @property hash (ht_hash_fn): Hash function applied to every key.
+ * @property key_len (ht_key_len_fn): Key length callback, NULL if the hash function finds the length itself.
+ *
+ * @typedef cuckoo_ht_t
+ *
+ */
+typedef struct cuckoo_hash_table {
+	cuckoo_bucket_t *buckets;
+	size_t nbuckets;
+	size_t items;
+	double load_factor;
+	cuckoo_slot_t stash[CUCKOO_STASH_SIZE];
+	size_t stash_items;
+	uint64_t seed;
+	uint64_t rng;
+	ht_hash_fn hash;
+	ht_key_len_fn key_len;
+} cuckoo_ht_t;
+
+/**
+ * @brief Create a cuckoo hash table object.
+ *
+ * @param capacity (size_t): Initial number of slots, rounded up to a power of two number of buckets.
+ * @param hash (ht_hash_fn): Hash function for keys, NULL for `ht_hash_string`.
+ * @param key_len (ht_key_len_fn): Optional key length callback passed through to `hash`.
+ * @return (cuckoo_ht_t *): Pointer to cuckoo hash table structure, NULL on failure.
+ */
+cuckoo_ht_t *create_cuckoo(size_t capacity, ht_hash_fn hash, ht_key_len_fn key_len);
+
+/**
+ * @brief Destroy a cuckoo hash table object.
+ *
+ * @param ct (cuckoo_ht_t **): Double Pointer to cuckoo hash table structure.
+ * @param destroy : User-defined destruction function to be performed on each item's data.
+ */
+void destroy_cuckoo(cuckoo_ht_t **ct, void (*destroy)(void *));
+
+/**
+ * @brief Insert data into a cuckoo hash table. Items already in the table may move.
+ *
+ * @param ct (cuckoo_ht_t *): Pointer to cuckoo hash table structure.
+ * @param data (void *): Pointer to data that will be inserted.
+ * @param compare : User-defined comparison function that must return an int.
+ * @return (int): 0 on successful insertion, -1 if the data already exists or on failure, e.g. when
+ * too many keys share a full hash for any rehash to separate them.
+ */
+int insert_cuckoo(cuckoo_ht_t *ct, void *data, int (*compare)(void *a, void *b));
+
+/**
+ * @brief Search a cuckoo hash table for given data, reading at most two buckets and the stash.
+ *
+ * @param ct (cuckoo_ht_t *): Pointer to cuckoo hash table structure.
+ * @param data (void *): Pointer to data to be hashed and searched.
+ * @param compare : User-defined comparison function that must return an int.
+ * @return (void *): The stored data equal to `data`, NULL if not found.
+ */
+void *search_cuckoo(cuckoo_ht_t *ct, void *data, int (*compare)(void *a, void *b));
+
+/**
+ * @brief Delete data from a cuckoo hash table.
+ *
+ * @param ct (cuckoo_ht_t *): Pointer to cuckoo hash table structure.
+ * @param data (void *): Pointer to data to be hashed, searched, and deleted.
+ * @param compare : User-defined comparison function that must return an int.
+ * @return (int): 0 on successful deletion, -1 on failure.
+ */
+int delete_cuckoo_item(cuckoo_ht_t *ct, void *data, int (*compare)(void *a, void *b));
+
+#endif // DSA_CUCKOO_H
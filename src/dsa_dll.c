@@ -242,6 +242,36 @@ ret:
 	return ret_val;
 }
 
+void dll_unlink(dll_t *dll, dll_node_t *node)
+{
+	if (node->previous) {
+		node->previous->next = node->next;
+	} else {
+		dll->head = node->next;
+	}
+	if (node->next) {
+		node->next->previous = node->previous;
+	} else {
+		dll->tail = node->previous;
+	}
+	node->previous = NULL;
+	node->next = NULL;
+	dll->nodes--;
+}
+
+void dll_link_front(dll_t *dll, dll_node_t *node)
+{
+	node->previous = NULL;
+	node->next = dll->head;
+	if (dll->head) {
+		dll->head->previous = node;
+	} else {
+		dll->tail = node;
+	}
+	dll->head = node;
+	dll->nodes++;
+}
+
 dll_node_t *dll_search(dll_t *dll, void *data)
 {
 	dll_node_t *temp = dll->head;
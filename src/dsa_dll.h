@@ -120,6 +120,22 @@ int dll_delete_rear(dll_t *dll);
  */
 int dll_delete_at_pos(dll_t *dll, size_t index);
 
+/**
+ * @brief Detach a node from dll in O(1) without freeing it. The node must be in dll.
+ * 
+ * @param dll (dll_t *): Pointer to doubly_linked_list struct.
+ * @param node (dll_node_t *): Node to detach.
+ */
+void dll_unlink(dll_t *dll, dll_node_t *node);
+
+/**
+ * @brief Attach a detached node at the front of dll in O(1).
+ * 
+ * @param dll (dll_t *): Pointer to doubly_linked_list struct.
+ * @param node (dll_node_t *): Node to attach, e.g. from `dll_create_node` or `dll_unlink`.
+ */
+void dll_link_front(dll_t *dll, dll_node_t *node);
+
 /**
  * @brief Search a dll for the first occurence of data.
  * 
@@ -0,0 +1,401 @@
+#include <stdlib.h>
+#include <string.h>
+#include "dsa_filter.h"
+#include "dsa_hash.h"
+
+/* Keys between issuing the prefetch for a key and reading its block or buckets */
+#define FILTER_PREFETCH_AHEAD 8
+/* Bits set per key at most, each position takes 9 bits of one 64 bit hash */
+#define BLOOM_MAX_K 7
+/* Fingerprints moved along one insert path before the one left over becomes the victim */
+#define CFILTER_MAX_KICKS 500
+
+/* Block of a key, taken from the high bits so it does not follow the low bits tables index with */
+static bloom_block_t *bloom_block(bloom_filter_t *bf, uint64_t hash)
+{
+	return &bf->blocks[(hash >> 32) & (bf->nblocks - 1)];
+}
+
+static void bloom_set(bloom_filter_t *bf, uint64_t hash)
+{
+	bloom_block_t *block = bloom_block(bf, hash);
+	uint64_t bits = dsa_hash_u64(hash);
+
+	for (unsigned int i = 0; i < bf->k; i++, bits >>= 9) {
+		unsigned int pos = bits & (BLOOM_BLOCK_BITS - 1);
+		block->words[pos / 64] |= 1ull << (pos % 64);
+	}
+}
+
+static bool bloom_test(bloom_filter_t *bf, uint64_t hash)
+{
+	bloom_block_t *block = bloom_block(bf, hash);
+	uint64_t bits = dsa_hash_u64(hash);
+
+	for (unsigned int i = 0; i < bf->k; i++, bits >>= 9) {
+		unsigned int pos = bits & (BLOOM_BLOCK_BITS - 1);
+		if (!(block->words[pos / 64] & (1ull << (pos % 64)))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bloom_filter_t *create_bloom(size_t expected, size_t bits_per_key)
+{
+	size_t nblocks = 1;
+	size_t bits = 0;
+	bloom_filter_t *bf = NULL;
+
+	if (bits_per_key == 0) {
+		goto ret;
+	}
+	bf = calloc(1, sizeof(bloom_filter_t));
+	if (!bf) {
+		goto ret;
+	}
+
+	bits = expected * bits_per_key;
+	while (nblocks * BLOOM_BLOCK_BITS < bits) {
+		nblocks *= 2;
+	}
+	bf->blocks = aligned_alloc(sizeof(bloom_block_t), nblocks * sizeof(bloom_block_t));
+	if (!bf->blocks) {
+		free(bf);
+		bf = NULL;
+		goto ret;
+	}
+	memset(bf->blocks, 0, nblocks * sizeof(bloom_block_t));
+	bf->nblocks = nblocks;
+	/* bits_per_key * ln 2 bits per key gives the fewest false positives */
+	bf->k = (unsigned int)(bits_per_key * 0.693 + 0.5);
+	bf->k = bf->k < 1 ? 1 : (bf->k > BLOOM_MAX_K ? BLOOM_MAX_K : bf->k);
+	bf->items = 0;
+
+ret:
+	return bf;
+}
+
+void destroy_bloom(bloom_filter_t **bf)
+{
+	if (*bf == NULL) {
+		return;
+	}
+	free((*bf)->blocks);
+	free(*bf);
+	*bf = NULL;
+}
+
+int insert_bloom(bloom_filter_t *bf, uint64_t hash)
+{
+	if (bf == NULL) {
+		return -1;
+	}
+	bloom_set(bf, hash);
+	bf->items++;
+	return 0;
+}
+
+bool search_bloom(bloom_filter_t *bf, uint64_t hash)
+{
+	return bf ? bloom_test(bf, hash) : false;
+}
+
+int insert_bloom_batch(bloom_filter_t *bf, const uint64_t *hashes, size_t n)
+{
+	if (bf == NULL) {
+		return -1;
+	}
+	for (size_t i = 0; i < n; i++) {
+		if (i + FILTER_PREFETCH_AHEAD < n) {
+			__builtin_prefetch(bloom_block(bf, hashes[i + FILTER_PREFETCH_AHEAD]), 1);
+		}
+		bloom_set(bf, hashes[i]);
+	}
+	bf->items += n;
+	return 0;
+}
+
+size_t search_bloom_batch(bloom_filter_t *bf, const uint64_t *hashes, size_t n, bool *results)
+{
+	size_t hits = 0;
+
+	if (bf == NULL) {
+		return 0;
+	}
+	for (size_t i = 0; i < n; i++) {
+		if (i + FILTER_PREFETCH_AHEAD < n) {
+			__builtin_prefetch(bloom_block(bf, hashes[i + FILTER_PREFETCH_AHEAD]));
+		}
+		results[i] = bloom_test(bf, hashes[i]);
+		hits += results[i];
+	}
+	return hits;
+}
+
+int merge_bloom(bloom_filter_t *dst, bloom_filter_t *src)
+{
+	if (dst == NULL || src == NULL || dst->nblocks != src->nblocks || dst->k != src->k) {
+		return -1;
+	}
+	for (size_t b = 0; b < dst->nblocks; b++) {
+		for (size_t w = 0; w < BLOOM_BLOCK_BITS / 64; w++) {
+			dst->blocks[b].words[w] |= src->blocks[b].words[w];
+		}
+	}
+	dst->items += src->items;
+	return 0;
+}
+
+/* Top 16 bits of the hash, 0 marks an empty slot */
+static uint16_t fingerprint(uint64_t hash)
+{
+	uint16_t fp = (uint16_t)(hash >> 48);
+	return fp ? fp : 1;
+}
+
+/* The other bucket of a fingerprint, found from either bucket and the fingerprint alone */
+static size_t alt_index(cfilter_t *cf, size_t index, uint16_t fp)
+{
+	return (index ^ dsa_hash_u64(fp)) & (cf->nbuckets - 1);
+}
+
+/* xorshift64* - picks the fingerprint to move out of a full bucket */
+static uint64_t next_random(cfilter_t *cf)
+{
+	cf->rng ^= cf->rng >> 12;
+	cf->rng ^= cf->rng << 25;
+	cf->rng ^= cf->rng >> 27;
+	return cf->rng * 0x2545f4914f6cdd1du;
+}
+
+static bool bucket_add(cfilter_bucket_t *bucket, uint16_t fp)
+{
+	for (int i = 0; i < CFILTER_BUCKET_SLOTS; i++) {
+		if (!bucket->fp[i]) {
+			bucket->fp[i] = fp;
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool bucket_has(cfilter_bucket_t *bucket, uint16_t fp)
+{
+	for (int i = 0; i < CFILTER_BUCKET_SLOTS; i++) {
+		if (bucket->fp[i] == fp) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool bucket_remove(cfilter_bucket_t *bucket, uint16_t fp)
+{
+	for (int i = 0; i < CFILTER_BUCKET_SLOTS; i++) {
+		if (bucket->fp[i] == fp) {
+			bucket->fp[i] = 0;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Store a fingerprint in one of its buckets. When both are full a random fingerprint is moved out
+ * to its other bucket, which may in turn move another, and the one left over after
+ * CFILTER_MAX_KICKS moves is kept as the victim.
+ *
+ * @return (int) 0 on success, -1 if the filter already holds a victim.
+ */
+static int place(cfilter_t *cf, size_t index, uint16_t fp)
+{
+	uint16_t swap = 0;
+	size_t alt = alt_index(cf, index, fp);
+
+	if (cf->victim_fp) {
+		return -1;
+	}
+	if (bucket_add(&cf->buckets[index], fp) || bucket_add(&cf->buckets[alt], fp)) {
+		cf->items++;
+		return 0;
+	}
+
+	index = (next_random(cf) & 1) ? index : alt;
+	for (int kick = 0; kick < CFILTER_MAX_KICKS; kick++) {
+		uint16_t *slot = &cf->buckets[index].fp[next_random(cf) % CFILTER_BUCKET_SLOTS];
+		swap = *slot;
+		*slot = fp;
+		fp = swap;
+
+		index = alt_index(cf, index, fp);
+		if (bucket_add(&cf->buckets[index], fp)) {
+			cf->items++;
+			return 0;
+		}
+	}
+
+	cf->victim_index = index;
+	cf->victim_fp = fp;
+	cf->items++;
+	return 0;
+}
+
+static void prefetch_buckets(cfilter_t *cf, uint64_t hash)
+{
+	size_t index = hash & (cf->nbuckets - 1);
+
+	__builtin_prefetch(&cf->buckets[index]);
+	__builtin_prefetch(&cf->buckets[alt_index(cf, index, fingerprint(hash))]);
+}
+
+cfilter_t *create_cfilter(size_t capacity)
+{
+	size_t nbuckets = 2;
+	cfilter_t *cf = calloc(1, sizeof(cfilter_t));
+	if (!cf) {
+		goto ret;
+	}
+
+	while (nbuckets * CFILTER_BUCKET_SLOTS * 0.95 < capacity) {
+		nbuckets *= 2;
+	}
+	cf->buckets = calloc(nbuckets, sizeof(cfilter_bucket_t));
+	if (!cf->buckets) {
+		free(cf);
+		cf = NULL;
+		goto ret;
+	}
+	cf->nbuckets = nbuckets;
+	cf->items = 0;
+	cf->victim_fp = 0;
+	cf->rng = 0x9e3779b97f4a7c15u;
+
+ret:
+	return cf;
+}
+
+void destroy_cfilter(cfilter_t **cf)
+{
+	if (*cf == NULL) {
+		return;
+	}
+	free((*cf)->buckets);
+	free(*cf);
+	*cf = NULL;
+}
+
+int insert_cfilter(cfilter_t *cf, uint64_t hash)
+{
+	if (cf == NULL) {
+		return -1;
+	}
+	return place(cf, hash & (cf->nbuckets - 1), fingerprint(hash));
+}
+
+bool search_cfilter(cfilter_t *cf, uint64_t hash)
+{
+	uint16_t fp = 0;
+	size_t i1 = 0;
+	size_t i2 = 0;
+
+	if (cf == NULL) {
+		return false;
+	}
+	fp = fingerprint(hash);
+	i1 = hash & (cf->nbuckets - 1);
+	i2 = alt_index(cf, i1, fp);
+
+	return bucket_has(&cf->buckets[i1], fp) || bucket_has(&cf->buckets[i2], fp) ||
+	       (cf->victim_fp == fp && (cf->victim_index == i1 || cf->victim_index == i2));
+}
+
+int delete_cfilter_item(cfilter_t *cf, uint64_t hash)
+{
+	int ret_val = -1;
+	uint16_t fp = 0;
+	size_t i1 = 0;
+	size_t i2 = 0;
+
+	if (cf == NULL) {
+		goto ret;
+	}
+	fp = fingerprint(hash);
+	i1 = hash & (cf->nbuckets - 1);
+	i2 = alt_index(cf, i1, fp);
+
+	if (cf->victim_fp == fp && (cf->victim_index == i1 || cf->victim_index == i2)) {
+		cf->victim_fp = 0;
+		cf->items--;
+		ret_val = 0;
+		goto ret;
+	}
+	if (!bucket_remove(&cf->buckets[i1], fp) && !bucket_remove(&cf->buckets[i2], fp)) {
+		goto ret;
+	}
+	cf->items--;
+
+	/* The freed slot may give the victim a place again */
+	if (cf->victim_fp) {
+		fp = cf->victim_fp;
+		cf->victim_fp = 0;
+		cf->items--;
+		place(cf, cf->victim_index, fp);
+	}
+
+	ret_val = 0;
+ret:
+	return ret_val;
+}
+
+size_t insert_cfilter_batch(cfilter_t *cf, const uint64_t *hashes, size_t n)
+{
+	size_t inserted = 0;
+
+	if (cf == NULL) {
+		return 0;
+	}
+	for (size_t i = 0; i < n; i++) {
+		if (i + FILTER_PREFETCH_AHEAD < n) {
+			prefetch_buckets(cf, hashes[i + FILTER_PREFETCH_AHEAD]);
+		}
+		inserted += insert_cfilter(cf, hashes[i]) == 0;
+	}
+	return inserted;
+}
+
+size_t search_cfilter_batch(cfilter_t *cf, const uint64_t *hashes, size_t n, bool *results)
+{
+	size_t hits = 0;
+
+	if (cf == NULL) {
+		return 0;
+	}
+	for (size_t i = 0; i < n; i++) {
+		if (i + FILTER_PREFETCH_AHEAD < n) {
+			prefetch_buckets(cf, hashes[i + FILTER_PREFETCH_AHEAD]);
+		}
+		results[i] = search_cfilter(cf, hashes[i]);
+		hits += results[i];
+	}
+	return hits;
+}
+
+int merge_cfilter(cfilter_t *dst, cfilter_t *src)
+{
+	if (dst == NULL || src == NULL || dst == src || dst->nbuckets != src->nbuckets) {
+		return -1;
+	}
+	/* A fingerprint's bucket in `src` is one of its two buckets in `dst` as well */
+	for (size_t b = 0; b < src->nbuckets; b++) {
+		for (int i = 0; i < CFILTER_BUCKET_SLOTS; i++) {
+			if (src->buckets[b].fp[i] && place(dst, b, src->buckets[b].fp[i]) == -1) {
+				return -1;
+			}
+		}
+	}
+	if (src->victim_fp) {
+		return place(dst, src->victim_index, src->victim_fp);
+	}
+	return 0;
+}
@@ -0,0 +1,242 @@
+#ifndef DSA_FILTER_H
+#define DSA_FILTER_H
+
+/**
+ * @file dsa_filter.h
+ * @author ajester (alex.m.jester.mil@army.mil)
+ * @brief Approximate Membership Filter Library.
+ * @version 0.1
+ * @date 2021-10-26
+ *
+ * @details Filters answer "definitely absent" or "maybe present" for a key, using a few bits per
+ * key, so most lookups of absent keys can skip the hash table entirely. Both filters take the
+ * 64 bit hash of a key instead of the key itself. Hash keys with `ht_hash_key` of the table they
+ * guard, or any `dsa_hash` function, and the same hash serves the filter and the `_hashed` table
+ * calls.
+ *
+ * Blocked Bloom Filter - Every key sets and tests bits in one 64 byte block, so a query reads a
+ * single cache line. Keys cannot be removed.
+ *
+ * Cuckoo Filter - Stores a 16 bit fingerprint of every key in one of two 4 slot buckets. Keys
+ * can be removed, and a query reads at most two buckets.
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Bits in one Bloom filter block, one cache line */
+#define BLOOM_BLOCK_BITS 512
+/* Fingerprints per cuckoo filter bucket */
+#define CFILTER_BUCKET_SLOTS 4
+
+/**
+ * @brief Blocked Bloom Filter Block, aligned to a cache line.
+ *
+ * @property words (uint64_t []): Bits of the block.
+ *
+ * @typedef bloom_block_t
+ *
+ */
+typedef struct bloom_block {
+	_Alignas(64) uint64_t words[BLOOM_BLOCK_BITS / 64];
+} bloom_block_t;
+
+/**
+ * @brief Blocked Bloom Filter Structure
+ *
+ * @property blocks (bloom_block_t *): Array of blocks.
+ * @property nblocks (size_t): Number of blocks, always a power of two.
+ * @property k (unsigned int): Bits set per key.
+ * @property items (size_t): Number of keys added, counting repeats.
+ *
+ * @typedef bloom_filter_t
+ *
+ */
+typedef struct bloom_filter {
+	bloom_block_t *blocks;
+	size_t nblocks;
+	unsigned int k;
+	size_t items;
+} bloom_filter_t;
+
+/**
+ * @brief Cuckoo Filter Bucket
+ *
+ * @property fp (uint16_t []): Fingerprints, 0 for an empty slot.
+ *
+ * @typedef cfilter_bucket_t
+ *
+ */
+typedef struct cfilter_bucket {
+	uint16_t fp[CFILTER_BUCKET_SLOTS];
+} cfilter_bucket_t;
+
+/**
+ * @brief Cuckoo Filter Structure
+ *
+ * @property buckets (cfilter_bucket_t *): Array of buckets.
+ * @property nbuckets (size_t): Number of buckets, always a power of two.
+ * @property items (size_t): Number of fingerprints stored, including the victim.
+ * @property victim_index (size_t): Bucket of the victim fingerprint.
+ * @property victim_fp (uint16_t): Fingerprint moved out by the last failed insert, 0 if none. The
+ * filter takes no more keys while it holds one.
+ * @property rng (uint64_t): State for choosing which fingerprint to move out of a full bucket.
+ *
+ * @typedef cfilter_t
+ *
+ */
+typedef struct cuckoo_filter {
+	cfilter_bucket_t *buckets;
+	size_t nbuckets;
+	size_t items;
+	size_t victim_index;
+	uint16_t victim_fp;
+	uint64_t rng;
+} cfilter_t;
+
+/**
+ * @brief Create a blocked Bloom filter object.
+ *
+ * @param expected (size_t): Number of keys the filter is sized for.
+ * @param bits_per_key (size_t): Bits of filter per expected key, e.g. 10 for about 1% false
+ * positives. The filter size is rounded up to a power of two number of blocks.
+ * @return (bloom_filter_t *): Pointer to Bloom filter structure, NULL on failure.
+ */
+bloom_filter_t *create_bloom(size_t expected, size_t bits_per_key);
+
+/**
+ * @brief Destroy a Bloom filter object.
+ *
+ * @param bf (bloom_filter_t **): Double Pointer to Bloom filter structure.
+ */
+void destroy_bloom(bloom_filter_t **bf);
+
+/**
+ * @brief Add a key to a Bloom filter.
+ *
+ * @param bf (bloom_filter_t *): Pointer to Bloom filter structure.
+ * @param hash (uint64_t): 64 bit hash of the key.
+ * @return (int): 0 on success, -1 on failure.
+ */
+int insert_bloom(bloom_filter_t *bf, uint64_t hash);
+
+/**
+ * @brief Test a key against a Bloom filter.
+ *
+ * @param bf (bloom_filter_t *): Pointer to Bloom filter structure.
+ * @param hash (uint64_t): 64 bit hash of the key.
+ * @return (bool): false if the key was never added, true if it may have been.
+ */
+bool search_bloom(bloom_filter_t *bf, uint64_t hash);
+
+/**
+ * @brief Add many keys to a Bloom filter, prefetching their blocks ahead of the writes.
+ *
+ * @param bf (bloom_filter_t *): Pointer to Bloom filter structure.
+ * @param hashes (const uint64_t *): Array of `n` key hashes.
+ * @param n (size_t): Number of keys.
+ * @return (int): 0 on success, -1 on failure.
+ */
+int insert_bloom_batch(bloom_filter_t *bf, const uint64_t *hashes, size_t n);
+
+/**
+ * @brief Test many keys against a Bloom filter, prefetching their blocks ahead of the reads.
+ *
+ * @param bf (bloom_filter_t *): Pointer to Bloom filter structure.
+ * @param hashes (const uint64_t *): Array of `n` key hashes.
+ * @param n (size_t): Number of keys.
+ * @param results (bool *): Output array of `n` results as from `search_bloom`.
+ * @return (size_t): Number of keys that may be present.
+ */
+size_t search_bloom_batch(bloom_filter_t *bf, const uint64_t *hashes, size_t n, bool *results);
+
+/**
+ * @brief Add every key of one Bloom filter to another. Both must have been created with the same
+ * size and bits per key.
+ *
+ * @param dst (bloom_filter_t *): Pointer to the Bloom filter that receives the keys.
+ * @param src (bloom_filter_t *): Pointer to the Bloom filter whose keys are added.
+ * @return (int): 0 on success, -1 if the filters differ in size or bits per key.
+ */
+int merge_bloom(bloom_filter_t *dst, bloom_filter_t *src);
+
+/**
+ * @brief Create a cuckoo filter object.
+ *
+ * @param capacity (size_t): Number of keys the filter must hold. Buckets are added so that it is
+ * at most 95% full, rounded up to a power of two number of buckets.
+ * @return (cfilter_t *): Pointer to cuckoo filter structure, NULL on failure.
+ */
+cfilter_t *create_cfilter(size_t capacity);
+
+/**
+ * @brief Destroy a cuckoo filter object.
+ *
+ * @param cf (cfilter_t **): Double Pointer to cuckoo filter structure.
+ */
+void destroy_cfilter(cfilter_t **cf);
+
+/**
+ * @brief Add a key to a cuckoo filter. A key added twice is stored twice and must be deleted twice.
+ *
+ * @param cf (cfilter_t *): Pointer to cuckoo filter structure.
+ * @param hash (uint64_t): 64 bit hash of the key.
+ * @return (int): 0 on success, -1 if the filter is full.
+ */
+int insert_cfilter(cfilter_t *cf, uint64_t hash);
+
+/**
+ * @brief Test a key against a cuckoo filter.
+ *
+ * @param cf (cfilter_t *): Pointer to cuckoo filter structure.
+ * @param hash (uint64_t): 64 bit hash of the key.
+ * @return (bool): false if the key is not in the filter, true if it may be.
+ */
+bool search_cfilter(cfilter_t *cf, uint64_t hash);
+
+/**
+ * @brief Remove a key from a cuckoo filter. Only keys that were added may be removed, or another
+ * key sharing the fingerprint is removed in its place.
+ *
+ * @param cf (cfilter_t *): Pointer to cuckoo filter structure.
+ * @param hash (uint64_t): 64 bit hash of the key.
+ * @return (int): 0 on successful deletion, -1 if no matching fingerprint was found.
+ */
+int delete_cfilter_item(cfilter_t *cf, uint64_t hash);
+
+/**
+ * @brief Add many keys to a cuckoo filter, prefetching their buckets ahead of the writes.
+ *
+ * @param cf (cfilter_t *): Pointer to cuckoo filter structure.
+ * @param hashes (const uint64_t *): Array of `n` key hashes.
+ * @param n (size_t): Number of keys.
+ * @return (size_t): Number of keys added, less than `n` once the filter is full.
+ */
+size_t insert_cfilter_batch(cfilter_t *cf, const uint64_t *hashes, size_t n);
+
+/**
+ * @brief Test many keys against a cuckoo filter, prefetching their buckets ahead of the reads.
+ *
+ * @param cf (cfilter_t *): Pointer to cuckoo filter structure.
+ * @param hashes (const uint64_t *): Array of `n` key hashes.
+ * @param n (size_t): Number of keys.
+ * @param results (bool *): Output array of `n` results as from `search_cfilter`.
+ * @return (size_t): Number of keys that may be present.
+ */
+size_t search_cfilter_batch(cfilter_t *cf, const uint64_t *hashes, size_t n, bool *results);
+
+/**
+ * @brief Add every fingerprint of one cuckoo filter to another with the same number of buckets.
+ *
+ * @param dst (cfilter_t *): Pointer to the cuckoo filter that receives the keys.
+ * @param src (cfilter_t *): Pointer to the cuckoo filter whose keys are added.
+ * @return (int): 0 on success, -1 if the filters differ in size, are the same filter, or `dst`
+ * fills up, in which case `dst` keeps the fingerprints added before it did.
+ */
+int merge_cfilter(cfilter_t *dst, cfilter_t *src);
+
+#endif // DSA_FILTER_H
@@ -0,0 +1,108 @@
+#include <string.h>
+#include "dsa_hash.h"
+
+#define WY_P0 0x2d358dccaa6c78a5u
+#define WY_P1 0x8bb84b93962eacc9u
+#define WY_P2 0x4b33a62ed433d4a3u
+#define WY_P3 0x4d5a2da51de1aa47u
+
+/* Multiply to 128 bits and fold the halves together */
+static inline uint64_t mum(uint64_t a, uint64_t b)
+{
+	__uint128_t r = (__uint128_t)a * b;
+	return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+static inline uint64_t read64(const uint8_t *p)
+{
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint64_t read32(const uint8_t *p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+/* Read 1 to 3 bytes as a single word */
+static inline uint64_t read_small(const uint8_t *p, size_t len)
+{
+	return ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+}
+
+/**
+ * Take a key and return a wyhash style hash.
+ * @authors Wang Yi
+ * @date 2019
+ * @accessed 2021
+ * @source https://github.com/wangyi-fudan/wyhash
+ */
+uint64_t dsa_hash64_seeded(const void *key, size_t len, uint64_t seed)
+{
+	const uint8_t *p = key;
+	uint64_t a = 0, b = 0;
+	size_t i = len;
+
+	seed ^= mum(seed ^ WY_P0, WY_P1);
+
+	if (len <= 16) {
+		if (len >= 4) {
+			/* Two overlapping 4 byte reads from each end cover 4 to 16 bytes */
+			a = (read32(p) << 32) | read32(p + ((len >> 3) << 2));
+			b = (read32(p + len - 4) << 32) | read32(p + len - 4 - ((len >> 3) << 2));
+		} else if (len > 0) {
+			a = read_small(p, len);
+		}
+	} else {
+		if (i > 48) {
+			uint64_t see1 = seed, see2 = seed;
+			do {
+				seed = mum(read64(p) ^ WY_P1, read64(p + 8) ^ seed);
+				see1 = mum(read64(p + 16) ^ WY_P2, read64(p + 24) ^ see1);
+				see2 = mum(read64(p + 32) ^ WY_P3, read64(p + 40) ^ see2);
+				p += 48;
+				i -= 48;
+			} while (i > 48);
+			seed ^= see1 ^ see2;
+		}
+		while (i > 16) {
+			seed = mum(read64(p) ^ WY_P1, read64(p + 8) ^ seed);
+			p += 16;
+			i -= 16;
+		}
+		/* The last 16 bytes may overlap bytes already consumed */
+		a = read64(p + i - 16);
+		b = read64(p + i - 8);
+	}
+
+	a ^= WY_P1;
+	b ^= seed;
+	__uint128_t r = (__uint128_t)a * b;
+	a = (uint64_t)r;
+	b = (uint64_t)(r >> 64);
+	return mum(a ^ WY_P0 ^ len, b ^ WY_P1);
+}
+
+uint64_t dsa_hash64(const void *key, size_t len)
+{
+	return dsa_hash64_seeded(key, len, 0);
+}
+
+uint64_t dsa_hash_string(const char *s)
+{
+	return dsa_hash64(s, strlen(s));
+}
+
+/* splitmix64 finalizer - spreads every input bit over the whole word */
+uint64_t dsa_hash_u64(uint64_t x)
+{
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9u;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebu;
+	x ^= x >> 31;
+	return x;
+}
@@ -0,0 +1,57 @@
+#ifndef DSA_HASH_H
+#define DSA_HASH_H
+
+/**
+ * @file dsa_hash.h
+ * @author ajester (alex.m.jester.mil@army.mil)
+ * @brief Hash Function Library.
+ * @version 0.1
+ * @date 2021-10-26
+ *
+ * @details Length-aware 64 bit hash functions shared by the hashing data structures. Keys are
+ * consumed 8 and 16 bytes at a time and the length is taken once up front, so hashing cost is
+ * linear in key length.
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Hash `len` bytes of a key.
+ *
+ * @param key (const void *): Pointer to the key bytes.
+ * @param len (size_t): Number of bytes to hash.
+ * @return (uint64_t): 64 bit hash of the key.
+ */
+uint64_t dsa_hash64(const void *key, size_t len);
+
+/**
+ * @brief Hash `len` bytes of a key with a seed. Different seeds give unrelated hash values.
+ *
+ * @param key (const void *): Pointer to the key bytes.
+ * @param len (size_t): Number of bytes to hash.
+ * @param seed (uint64_t): Seed value.
+ * @return (uint64_t): 64 bit hash of the key.
+ */
+uint64_t dsa_hash64_seeded(const void *key, size_t len, uint64_t seed);
+
+/**
+ * @brief Hash a NUL-terminated string, measuring its length once.
+ *
+ * @param s (const char *): Pointer to the string to hash.
+ * @return (uint64_t): 64 bit hash of the string.
+ */
+uint64_t dsa_hash_string(const char *s);
+
+/**
+ * @brief Hash a 64 bit integer.
+ *
+ * @param x (uint64_t): Integer to hash.
+ * @return (uint64_t): 64 bit hash of the integer.
+ */
+uint64_t dsa_hash_u64(uint64_t x);
+
+#endif // DSA_HASH_H
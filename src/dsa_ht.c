@@ -1,34 +1,91 @@
 #include <stdio.h>
+#include <stdarg.h>
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
+#include <sys/random.h>
 #include "dsa_ht.h"
+#include "dsa_hash.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #define FNV_PRIME_64 1099511628211
 #define FNV_OFFSET_64 14695981039346656037u
 
+/* Number of old slots moved to the new array per operation during an incremental resize */
+#define HT_MIGRATE_SLOTS 16
 
-static int resize(hash_table_t *ht)
-{
-	int ret_val = -1;
-	size_t i = ht->capacity - 1;
-	printf("Resizing Hashtable %ld -> %ld capacity\n", ht->capacity, (ht->capacity * 2));
-	size_t next_size = (ht->capacity * 2);
-	ht->array = realloc(ht->array, next_size * (sizeof(ht_item_t)));
-	if (!ht->array) {
-		printf("Unable to reallocate - something went wrong.\n");
-		goto ret;
-	}
-	ht->capacity = next_size;
-	ret_val = 0;
-ret:
-	return ret_val;
-}
+/* Keys hashed and prefetched together by the batch functions */
+#define HT_BATCH_SIZE 16
+
+/* Group probing - slots checked per step and the control byte markers. Full slots hold the low 7 hash bits */
+#define HT_GROUP_WIDTH 16
+#define CTRL_EMPTY ((int8_t)-128)
+#define CTRL_DELETED ((int8_t)-2)
+
+/* A table shrinks once fewer than load_factor / HT_SHRINK_RATIO of its slots hold items */
+#define HT_SHRINK_RATIO 4
+
+/* Inline key bytes kept per slot by HT_INLINE_KEYS tables, and the length marking a key that only fits in part */
+#define HT_KEY_CELL 16
+#define HT_KEY_LONG 0xff
+
+/* Slots covered by one word of the used bitmap */
+#define HT_BITMAP_BITS 64
 
 static bool has_item(ht_item_t *item)
 {
 	return item->has_item || item->data;
 }
 
+static bool is_tombstone(ht_item_t *item)
+{
+	return !has_item(item) && item->hash == INT64_MAX;
+}
+
+static void make_tombstone(ht_item_t *item)
+{
+	item->data = NULL;
+	item->has_item = false;
+	item->hash = INT64_MAX;
+}
+
+static size_t bitmap_words(size_t capacity)
+{
+	return (capacity + HT_BITMAP_BITS - 1) / HT_BITMAP_BITS;
+}
+
+static void set_used(uint64_t *used, size_t index)
+{
+	used[index / HT_BITMAP_BITS] |= (uint64_t)1 << (index % HT_BITMAP_BITS);
+}
+
+static void clear_used(uint64_t *used, size_t index)
+{
+	used[index / HT_BITMAP_BITS] &= ~((uint64_t)1 << (index % HT_BITMAP_BITS));
+}
+
+/* Index of the first used slot at or after `index`, `capacity` if there is none */
+static size_t next_used(const uint64_t *used, size_t capacity, size_t index)
+{
+	size_t word = index / HT_BITMAP_BITS;
+	uint64_t bits = 0;
+
+	if (index >= capacity) {
+		return capacity;
+	}
+	bits = used[word] & (~(uint64_t)0 << (index % HT_BITMAP_BITS));
+	while (!bits) {
+		if (++word == bitmap_words(capacity)) {
+			return capacity;
+		}
+		bits = used[word];
+	}
+	return word * HT_BITMAP_BITS + __builtin_ctzll(bits);
+}
+
 /**
  * Take a string and return a Fowler-Noll-Vo hash.
  * @authors Glenn Fowler, Landon Curt Noll, Kiem-Phong Vo
@@ -42,121 +99,1126 @@ static bool has_item(ht_item_t *item)
 uint64_t FNV64(const char *s)
 {
 	uint64_t hash = FNV_OFFSET_64, i;
-	for (i = 0; i < strlen(s); i++) {
+	size_t len = strlen(s);
+	for (i = 0; i < len; i++) {
 		hash = hash ^ (s[i]);
 		hash = hash * FNV_PRIME_64;
 	}
 	return hash;
 }
 
+uint64_t ht_hash_string(const void *key, size_t len)
+{
+	(void)len;
+	return dsa_hash_string((const char *)key);
+}
+
+uint64_t ht_hash_bytes(const void *key, size_t len)
+{
+	return dsa_hash64(key, len);
+}
+
+uint64_t ht_hash_u64(const void *key, size_t len)
+{
+	(void)len;
+	return dsa_hash_u64(*(const uint64_t *)key);
+}
+
+uint64_t ht_hash_intptr(const void *key, size_t len)
+{
+	(void)len;
+	return dsa_hash_u64((uint64_t)(uintptr_t)key);
+}
+
+/*
+ * Fold the high bits of a hash into the low ones. Masked indexing only looks at the low bits,
+ * which are often weak in user hash functions, e.g. aligned pointers.
+ */
+static uint64_t mix(uint64_t hash)
+{
+	hash ^= hash >> 32;
+	hash *= 0x9e3779b97f4a7c15u;
+	hash ^= hash >> 29;
+	return hash;
+}
+
+/**
+ * Keyed hashing for HT_SEEDED_HASH tables. Byte keys are hashed with the seed itself. Other hash
+ * functions are mixed with the seed afterwards, which still hides the slot a key lands in.
+ */
+static uint64_t seeded_hash(hash_table_t *ht, void *data, size_t len)
+{
+	if (ht->hash == ht_hash_string) {
+		return dsa_hash64_seeded(data, strlen((const char *)data), ht->seed);
+	}
+	if (ht->hash == ht_hash_bytes) {
+		return dsa_hash64_seeded(data, len, ht->seed);
+	}
+	return dsa_hash_u64(ht->hash(data, len) ^ ht->seed);
+}
+
+static uint64_t hash_key(hash_table_t *ht, void *data)
+{
+	size_t len = ht->key_len ? ht->key_len(data) : 0;
+	uint64_t hash = (ht->flags & HT_SEEDED_HASH) ? seeded_hash(ht, data, len) : ht->hash(data, len);
+	return (ht->flags & HT_POW2_CAPACITY) ? mix(hash) : hash;
+}
+
+/* Seed from the kernel's random source, or from the clock and an address if it is unavailable */
+static uint64_t random_seed(void *salt)
+{
+	uint64_t seed = 0;
+	struct timespec ts;
+
+	if (getrandom(&seed, sizeof(seed), GRND_NONBLOCK) != sizeof(seed)) {
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		seed = dsa_hash_u64((uint64_t)ts.tv_nsec ^ ((uint64_t)ts.tv_sec << 32) ^ (uint64_t)(uintptr_t)salt);
+	}
+	return seed;
+}
+
+/* Home slot of a hash. Power of two capacities take a mask instead of a 64 bit divide */
+static inline size_t bucket(uint64_t hash, size_t capacity)
+{
+	if ((capacity & (capacity - 1)) == 0) {
+		return hash & (capacity - 1);
+	}
+	return hash % capacity;
+}
+
+static uint8_t *cell_at(hash_table_t *ht, size_t index)
+{
+	return ht->keys + index * HT_KEY_CELL;
+}
+
+/* Copy the leading bytes of a key into a zero padded cell and return the length to store with it */
+static uint8_t make_cell(hash_table_t *ht, void *data, uint8_t *cell)
+{
+	size_t len = ht->key_len ? ht->key_len(data) : strlen((const char *)data);
+
+	memset(cell, 0, HT_KEY_CELL);
+	memcpy(cell, data, len < HT_KEY_CELL ? len : HT_KEY_CELL);
+	return len <= HT_KEY_CELL ? (uint8_t)len : HT_KEY_LONG;
+}
+
+/**
+ * Check whether an item holds `data`. Items in the current array of an HT_INLINE_KEYS table are
+ * checked against their inline copy, so short keys are settled without following `item->data`.
+ */
+static bool matches(hash_table_t *ht, ht_item_t *item, uint64_t hash, void *data, int (*compare)(void *a, void *b))
+{
+	uint8_t cell[HT_KEY_CELL];
+
+	/* Only items with an identical full hash reach the key check */
+	if (item->hash != hash) {
+		return false;
+	}
+	if (ht->keys && item >= ht->array && item < ht->array + ht->capacity) {
+		if (make_cell(ht, data, cell) != item->inline_len ||
+		    memcmp(cell, cell_at(ht, item - ht->array), HT_KEY_CELL) != 0) {
+			return false;
+		}
+		/* Longer keys only have their first bytes inline */
+		if (item->inline_len != HT_KEY_LONG) {
+			return true;
+		}
+	}
+	return compare(item->data, data) == 0;
+}
+
+/**
+ * Walk the probe chain starting at `home` looking for `data`.
+ *
+ * @param ht (hash_table_t *) - Table that owns `array`.
+ * @param array (ht_item_t *) - Array to probe.
+ * @param capacity (size_t) - Capacity of `array`.
+ * @param hash (uint64_t) - Full hash of `data`, its home bucket is `bucket(hash, capacity)`.
+ * @param data (void *) - Data to look for, ignored when `compare` is NULL.
+ * @param compare - User-defined comparison function, NULL to only look for a free slot.
+ * @param free_slot (ht_item_t **) - Set to the first empty or deleted slot on the chain, may be NULL.
+ * @return (ht_item_t *) Matching item, NULL if the chain ended without a match.
+ */
+static ht_item_t *probe(hash_table_t *ht, ht_item_t *array, size_t capacity, uint64_t hash, void *data,
+			int (*compare)(void *a, void *b), ht_item_t **free_slot)
+{
+	ht_item_t *item = NULL;
+	size_t index = bucket(hash, capacity);
+
+	if (free_slot) {
+		*free_slot = NULL;
+	}
+
+	for (size_t i = 0; i < capacity; i++) {
+		item = &array[index];
+		if (!has_item(item)) {
+			if (free_slot && !*free_slot) {
+				*free_slot = item;
+			}
+			/* An empty slot ends the chain, a deleted one does not */
+			if (!is_tombstone(item) || !compare) {
+				break;
+			}
+		} else if (compare && matches(ht, item, hash, data, compare)) {
+			return item;
+		}
+
+		/* Move to next spot in hash table - Collision handling technique */
+		index = (index + 1 == capacity) ? 0 : index + 1;
+	}
+
+	return NULL;
+}
+
+/* Distance of a slot from the home bucket of hash */
+static uint32_t displacement(ht_item_t *array, size_t capacity, ht_item_t *slot, uint64_t hash)
+{
+	size_t index = slot - array;
+	size_t home = bucket(hash, capacity);
+
+	return (uint32_t)(index >= home ? index - home : index + capacity - home);
+}
+
+static void fill(ht_item_t *slot, uint64_t hash, void *data, void *value)
+{
+	slot->has_item = true;
+	slot->hash = hash;
+	slot->data = data;
+	slot->value = value;
+}
+
+/* Fill a free slot of the current array, which may be a tombstone being reused */
+static ht_item_t *claim(hash_table_t *ht, ht_item_t *slot, uint64_t hash, void *data, void *value)
+{
+	if (is_tombstone(slot)) {
+		ht->tombstones--;
+	}
+	fill(slot, hash, data, value);
+	slot->dist = displacement(ht->array, ht->capacity, slot, hash);
+	if (ht->keys) {
+		slot->inline_len = make_cell(ht, data, cell_at(ht, slot - ht->array));
+	}
+	set_used(ht->used, slot - ht->array);
+	return slot;
+}
+
+/**
+ * Robin Hood lookup. Items along a chain are ordered by distance from home, so the search
+ * stops as soon as it meets an item closer to its home than the key would be.
+ */
+static ht_item_t *rh_probe(hash_table_t *ht, uint64_t hash, void *data, int (*compare)(void *a, void *b))
+{
+	ht_item_t *item = NULL;
+	size_t index = bucket(hash, ht->capacity);
+
+	for (uint32_t dist = 0; dist < ht->capacity; dist++) {
+		item = &ht->array[index];
+		if (!has_item(item) || item->dist < dist) {
+			break;
+		}
+		if (matches(ht, item, hash, data, compare)) {
+			return item;
+		}
+		index = (index + 1 == ht->capacity) ? 0 : index + 1;
+	}
+
+	return NULL;
+}
+
+/**
+ * Robin Hood placement. The incoming item takes the slot of any item that is closer to its
+ * home bucket, and the displaced item continues down the chain.
+ *
+ * @return (ht_item_t *) Slot the new data landed in, NULL if the table has no empty slot.
+ */
+static ht_item_t *rh_place(hash_table_t *ht, uint64_t hash, void *data, void *value)
+{
+	ht_item_t carry = { .hash = hash, .data = data, .value = value, .has_item = true, .dist = 0 };
+	ht_item_t swap;
+	uint8_t carry_key[HT_KEY_CELL];
+	uint8_t swap_key[HT_KEY_CELL];
+	ht_item_t *landed = NULL;
+	ht_item_t *item = NULL;
+	size_t index = bucket(hash, ht->capacity);
+
+	/* A table left full by a failed resize has no empty slot to end the chain at */
+	if (ht->items >= ht->capacity) {
+		return NULL;
+	}
+
+	/* Inline keys travel with their items */
+	if (ht->keys) {
+		carry.inline_len = make_cell(ht, data, carry_key);
+	}
+
+	for (size_t probes = 0; probes < ht->capacity; probes++) {
+		item = &ht->array[index];
+		if (!has_item(item)) {
+			*item = carry;
+			if (ht->keys) {
+				memcpy(cell_at(ht, index), carry_key, HT_KEY_CELL);
+			}
+			set_used(ht->used, index);
+			return landed ? landed : item;
+		}
+		if (item->dist < carry.dist) {
+			swap = *item;
+			*item = carry;
+			carry = swap;
+			if (ht->keys) {
+				memcpy(swap_key, cell_at(ht, index), HT_KEY_CELL);
+				memcpy(cell_at(ht, index), carry_key, HT_KEY_CELL);
+				memcpy(carry_key, swap_key, HT_KEY_CELL);
+			}
+			if (!landed) {
+				landed = item;
+			}
+		}
+		carry.dist++;
+		index = (index + 1 == ht->capacity) ? 0 : index + 1;
+	}
+
+	return NULL;
+}
+
+/* Robin Hood deletion - shift the rest of the chain back one slot instead of leaving a tombstone */
+static void rh_remove(hash_table_t *ht, ht_item_t *item)
+{
+	ht_item_t *array = ht->array;
+	size_t capacity = ht->capacity;
+	size_t index = item - array;
+	size_t next = (index + 1 == capacity) ? 0 : index + 1;
+
+	while (has_item(&array[next]) && array[next].dist > 0) {
+		array[index] = array[next];
+		array[index].dist--;
+		if (ht->keys) {
+			memcpy(cell_at(ht, index), cell_at(ht, next), HT_KEY_CELL);
+		}
+		index = next;
+		next = (index + 1 == capacity) ? 0 : index + 1;
+	}
+	memset(&array[index], 0, sizeof(ht_item_t));
+	clear_used(ht->used, index);
+}
+
+/* Bitmask of the slots in a group whose control byte equals `value` */
+static uint32_t group_match(const int8_t *ctrl, int8_t value)
+{
+#ifdef __SSE2__
+	__m128i group = _mm_load_si128((const __m128i *)ctrl);
+	return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(value)));
+#else
+	uint32_t mask = 0;
+	for (int i = 0; i < HT_GROUP_WIDTH; i++) {
+		mask |= (uint32_t)(ctrl[i] == value) << i;
+	}
+	return mask;
+#endif
+}
+
+/* Bitmask of the empty or deleted slots in a group - the only control bytes with the high bit set */
+static uint32_t group_match_free(const int8_t *ctrl)
+{
+#ifdef __SSE2__
+	return (uint32_t)_mm_movemask_epi8(_mm_load_si128((const __m128i *)ctrl));
+#else
+	uint32_t mask = 0;
+	for (int i = 0; i < HT_GROUP_WIDTH; i++) {
+		mask |= (uint32_t)(ctrl[i] < 0) << i;
+	}
+	return mask;
+#endif
+}
+
+static int8_t ctrl_hash(uint64_t hash)
+{
+	return (int8_t)(hash & 0x7f);
+}
+
+static size_t home_group(uint64_t hash, size_t capacity)
+{
+	return bucket(hash >> 7, capacity / HT_GROUP_WIDTH) * HT_GROUP_WIDTH;
+}
+
+/**
+ * Group lookup. The control bytes of a whole group are compared against the key's 7 bit
+ * hash at once, and only matching slots are read from the item array. A group with an
+ * empty slot ends the search.
+ */
+static ht_item_t *group_probe(hash_table_t *ht, uint64_t hash, void *data, int (*compare)(void *a, void *b))
+{
+	int8_t h2 = ctrl_hash(hash);
+	size_t group = home_group(hash, ht->capacity);
+	uint32_t match = 0;
+	ht_item_t *item = NULL;
+
+	for (size_t probed = 0; probed < ht->capacity; probed += HT_GROUP_WIDTH) {
+		match = group_match(&ht->ctrl[group], h2);
+		while (match) {
+			item = &ht->array[group + __builtin_ctz(match)];
+			if (matches(ht, item, hash, data, compare)) {
+				return item;
+			}
+			match &= match - 1;
+		}
+		if (group_match(&ht->ctrl[group], CTRL_EMPTY)) {
+			break;
+		}
+		group = (group + HT_GROUP_WIDTH == ht->capacity) ? 0 : group + HT_GROUP_WIDTH;
+	}
+
+	return NULL;
+}
+
+/**
+ * Group placement into the first empty or deleted slot along the group sequence.
+ *
+ * @return (ht_item_t *) Slot the new data landed in, NULL if every group is full.
+ */
+static ht_item_t *group_place(hash_table_t *ht, uint64_t hash, void *data, void *value)
+{
+	size_t group = home_group(hash, ht->capacity);
+	uint32_t match = 0;
+	ht_item_t *slot = NULL;
+
+	for (size_t groups = 0; !(match = group_match_free(&ht->ctrl[group])); groups++) {
+		if (groups + 1 == ht->capacity / HT_GROUP_WIDTH) {
+			return NULL;
+		}
+		group = (group + HT_GROUP_WIDTH == ht->capacity) ? 0 : group + HT_GROUP_WIDTH;
+	}
+
+	slot = &ht->array[group + __builtin_ctz(match)];
+	ht->ctrl[slot - ht->array] = ctrl_hash(hash);
+	return claim(ht, slot, hash, data, value);
+}
+
+/**
+ * Group deletion. A slot may go back to empty when its group still has an empty slot, since
+ * no lookup has then ever continued past the group. Otherwise it is marked deleted.
+ */
+static void group_remove(hash_table_t *ht, ht_item_t *item)
+{
+	size_t index = item - ht->array;
+	size_t group = index - index % HT_GROUP_WIDTH;
+
+	if (group_match(&ht->ctrl[group], CTRL_EMPTY)) {
+		ht->ctrl[index] = CTRL_EMPTY;
+		memset(item, 0, sizeof(ht_item_t));
+		clear_used(ht->used, index);
+	} else {
+		ht->ctrl[index] = CTRL_DELETED;
+		make_tombstone(item);
+		ht->tombstones++;
+	}
+}
+
+static int8_t *create_ctrl(size_t capacity)
+{
+	int8_t *ctrl = aligned_alloc(HT_GROUP_WIDTH, capacity);
+	if (ctrl) {
+		memset(ctrl, CTRL_EMPTY, capacity);
+	}
+	return ctrl;
+}
+
+/* Store data in the current array using the table's probing scheme */
+static ht_item_t *store(hash_table_t *ht, uint64_t hash, void *data, void *value)
+{
+	ht_item_t *slot = NULL;
+
+	if (ht->flags & HT_ROBIN_HOOD) {
+		return rh_place(ht, hash, data, value);
+	}
+	if (ht->flags & HT_GROUP_PROBE) {
+		return group_place(ht, hash, data, value);
+	}
+	/* Place data into the first free slot of its probe chain without checking for duplicates */
+	probe(ht, ht->array, ht->capacity, hash, NULL, NULL, &slot);
+	return claim(ht, slot, hash, data, value);
+}
+
+/* Find data in the current array, then in the array being migrated */
+static ht_item_t *find(hash_table_t *ht, uint64_t hash, void *data, int (*compare)(void *a, void *b))
+{
+	ht_item_t *found = NULL;
+
+	if (ht->flags & HT_GROUP_PROBE) {
+		return group_probe(ht, hash, data, compare);
+	}
+	if (ht->flags & HT_ROBIN_HOOD) {
+		found = rh_probe(ht, hash, data, compare);
+	} else {
+		found = probe(ht, ht->array, ht->capacity, hash, data, compare, NULL);
+	}
+
+	/* Items not migrated yet are still in the old array, which only ever holds tombstones */
+	if (!found && ht->old_array) {
+		found = probe(ht, ht->old_array, ht->old_capacity, hash, data, compare, NULL);
+	}
+	return found;
+}
+
+static void finish_migration(hash_table_t *ht)
+{
+	free(ht->old_array);
+	free(ht->old_used);
+	ht->old_array = NULL;
+	ht->old_used = NULL;
+	ht->old_capacity = 0;
+	ht->migrate_index = 0;
+}
+
+/**
+ * Move up to `slots` slots of the old array into the new one. Migrated slots become
+ * tombstones so probe chains through the old array stay intact until it is freed.
+ */
+static void migrate(hash_table_t *ht, size_t slots)
+{
+	ht_item_t *item = NULL;
+
+	if (!ht->old_array) {
+		return;
+	}
+
+	while (slots-- && ht->migrate_index < ht->old_capacity) {
+		item = &ht->old_array[ht->migrate_index++];
+		if (has_item(item)) {
+			/* The stored hash is reused, keys are never hashed again */
+			store(ht, item->hash, item->data, item->value);
+			make_tombstone(item);
+		}
+	}
+
+	if (ht->migrate_index == ht->old_capacity) {
+		finish_migration(ht);
+	}
+}
+
+/* Capacity the table's probing scheme can use that is at least `capacity` */
+static size_t round_capacity(hash_table_t *ht, size_t capacity)
+{
+	capacity = capacity ? capacity : 1;
+	if (ht->flags & HT_POW2_CAPACITY) {
+		capacity = (capacity & (capacity - 1)) ? (size_t)1 << (64 - __builtin_clzll(capacity)) : capacity;
+	}
+	if (ht->flags & HT_GROUP_PROBE) {
+		capacity = (capacity + HT_GROUP_WIDTH - 1) / HT_GROUP_WIDTH * HT_GROUP_WIDTH;
+	}
+	return capacity;
+}
+
+/* Format a message for the table's diagnostics callback, if it has one */
+static void diagnose(hash_table_t *ht, const char *format, ...)
+{
+	char message[128];
+	va_list args;
+
+	if (!ht->diag) {
+		return;
+	}
+	va_start(args, format);
+	vsnprintf(message, sizeof(message), format, args);
+	va_end(args);
+	ht->diag(ht, message, ht->diag_ctx);
+}
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Rehash every item into a new array of `next_size` slots. Tombstones are left behind, so a
+ * resize to the current capacity only cleans the table.
+ */
+static int resize(hash_table_t *ht, size_t next_size)
+{
+	int ret_val = -1;
+	ht_item_t *next_array = NULL;
+	uint64_t *next_used = NULL;
+	int8_t *old_ctrl = ht->ctrl;
+	int8_t *next_ctrl = NULL;
+	uint8_t *old_keys = ht->keys;
+	uint8_t *next_keys = NULL;
+	double start = now();
+
+	/* A resize is only reached once the previous one has been drained */
+	migrate(ht, SIZE_MAX);
+
+	diagnose(ht, "resizing %zu -> %zu slots, %zu items, %zu tombstones", ht->capacity, next_size, ht->items,
+		 ht->tombstones);
+	next_array = calloc(next_size, sizeof(ht_item_t));
+	next_used = calloc(bitmap_words(next_size), sizeof(uint64_t));
+	if (old_ctrl) {
+		next_ctrl = create_ctrl(next_size);
+	}
+	if (old_keys) {
+		next_keys = malloc(next_size * HT_KEY_CELL);
+	}
+	if (!next_array || !next_used || (old_ctrl && !next_ctrl) || (old_keys && !next_keys)) {
+		diagnose(ht, "unable to allocate %zu slots", next_size);
+		free(next_array);
+		free(next_used);
+		free(next_ctrl);
+		free(next_keys);
+		goto ret;
+	}
+	ht->ctrl = next_ctrl;
+	/* Items left in the old array are checked with the user comparator, so its inline keys can go now */
+	ht->keys = next_keys;
+
+	ht->old_array = ht->array;
+	ht->old_used = ht->used;
+	ht->old_capacity = ht->capacity;
+	ht->migrate_index = 0;
+	ht->array = next_array;
+	ht->used = next_used;
+	ht->capacity = next_size;
+	ht->tombstones = 0;
+
+	/* Without incremental resizing the whole table moves now */
+	if (!(ht->flags & HT_INCREMENTAL_RESIZE)) {
+		migrate(ht, SIZE_MAX);
+	}
+	free(old_ctrl);
+	free(old_keys);
+	ht->resizes++;
+
+	ret_val = 0;
+ret:
+	ht->resize_time += now() - start;
+	return ret_val;
+}
+
 hash_table_t *create_ht(size_t capacity)
 {
-	hash_table_t *ht = malloc(sizeof(hash_table_t));
+	return create_ht_ex(capacity, NULL);
+}
+
+hash_table_t *create_ht_hash(size_t capacity, ht_hash_fn hash, ht_key_len_fn key_len)
+{
+	ht_options_t options = { .hash = hash, .key_len = key_len };
+	return create_ht_ex(capacity, &options);
+}
+
+hash_table_t *create_ht_ex(size_t capacity, const ht_options_t *options)
+{
+	hash_table_t *ht = NULL;
+	unsigned int flags = options ? options->flags : 0;
+
+	/* The group backend keeps its own slot metadata and resizes in one step */
+	if ((flags & HT_GROUP_PROBE) && (flags & (HT_ROBIN_HOOD | HT_INCREMENTAL_RESIZE))) {
+		goto ret;
+	}
+	/* Inline keys are copied as bytes, so their length must be known: a key length callback or the default string hash */
+	if ((flags & HT_INLINE_KEYS) && options->hash && !options->key_len) {
+		goto ret;
+	}
+
+	ht = calloc(1, sizeof(hash_table_t));
 	if (!ht) {
 		goto ret;
 	}
-	ht->capacity = capacity;
+	ht->flags = flags;
+	ht->capacity = round_capacity(ht, capacity);
+	if (flags & HT_GROUP_PROBE) {
+		ht->ctrl = create_ctrl(ht->capacity);
+		if (!ht->ctrl) {
+			free(ht);
+			ht = NULL;
+			goto ret;
+		}
+	}
 	ht->array = calloc((ht->capacity), sizeof(ht_item_t));
-	if (!ht->array) {
+	ht->used = calloc(bitmap_words(ht->capacity), sizeof(uint64_t));
+	if (flags & HT_INLINE_KEYS) {
+		ht->keys = malloc(ht->capacity * HT_KEY_CELL);
+	}
+	if (!ht->array || !ht->used || ((flags & HT_INLINE_KEYS) && !ht->keys)) {
+		free(ht->array);
+		free(ht->used);
+		free(ht->keys);
+		free(ht->ctrl);
+		free(ht);
+		ht = NULL;
 		goto ret;
 	}
 	ht->items = 0;
+	ht->min_capacity = ht->capacity;
+	ht->seed = 0;
 	ht->load_factor = (double) 2 / 3;
+	ht->hash = ht_hash_string;
+	if (options) {
+		ht->key_len = options->key_len;
+		ht->diag = options->diag;
+		ht->diag_ctx = options->diag_ctx;
+		ht->seed = options->seed;
+		if (options->hash) {
+			ht->hash = options->hash;
+		}
+	}
+	if ((flags & HT_SEEDED_HASH) && !ht->seed) {
+		ht->seed = random_seed(ht);
+	}
 ret:
 	return ht;
 }
 
+/* Destroy the data of every item, then return each used slot of the array to empty */
+static void clear_array(ht_item_t *array, size_t capacity, uint64_t *used, size_t start, int8_t *ctrl,
+			void (*destroy)(void *))
+{
+	for (size_t i = next_used(used, capacity, start); i < capacity; i = next_used(used, capacity, i + 1)) {
+		if (has_item(&array[i])) {
+			destroy(array[i].data);
+		}
+		memset(&array[i], 0, sizeof(ht_item_t));
+		if (ctrl) {
+			ctrl[i] = CTRL_EMPTY;
+		}
+	}
+	memset(used, 0, bitmap_words(capacity) * sizeof(uint64_t));
+}
+
 void destroy_ht(hash_table_t **ht, void (*destroy)(void *))
 {
 	if (*ht == NULL) {
 		return;
 	}
-	for (size_t i = 0; i < (*ht)->capacity; i++) {
-		destroy((*ht)->array[i].data);
-	}
+	ht_clear(*ht, destroy);
 
+	free((*ht)->ctrl);
+	free((*ht)->keys);
+	free((*ht)->used);
 	free((*ht)->array);
 	(*ht)->array = NULL;
 	free(*ht);
 	*ht = NULL;
 }
 
+/**
+ * Find data with a precomputed hash, or store it with the given value when it is not in the table yet.
+ *
+ * @param inserted (bool *) - Set to true when the data was stored by this call.
+ * @return (ht_item_t *) Item holding the data, NULL on failure.
+ */
+static ht_item_t *find_or_store_hashed(hash_table_t *ht, uint64_t hash, void *data, void *value,
+				       int (*compare)(void *a, void *b), bool *inserted)
+{
+	ht_item_t *item = NULL;
+	ht_item_t *slot = NULL;
+
+	*inserted = false;
+
+	/* Item already exists */
+	if (ht->flags & (HT_ROBIN_HOOD | HT_GROUP_PROBE)) {
+		item = find(ht, hash, data, compare);
+		if (item) {
+			goto ret;
+		}
+		item = store(ht, hash, data, value);
+		if (!item) {
+			goto ret;
+		}
+	} else {
+		if (ht->old_array) {
+			item = probe(ht, ht->old_array, ht->old_capacity, hash, data, compare, NULL);
+			if (item) {
+				goto ret;
+			}
+		}
+		/* Duplicate check and free slot search share one walk of the chain */
+		item = probe(ht, ht->array, ht->capacity, hash, data, compare, &slot);
+		if (item || !slot) {
+			goto ret;
+		}
+		item = claim(ht, slot, hash, data, value);
+	}
+	ht->items++;
+	*inserted = true;
+
+	/* Tombstones lengthen probe chains like items do, so both count towards the load factor */
+	if ((float)(ht->items + ht->tombstones) >= ht->capacity * ht->load_factor) {
+		/* Double the capacity, unless clearing out the tombstones frees enough room */
+		if ((float)(ht->items * 2) >= ht->capacity * ht->load_factor) {
+			resize(ht, ht->capacity * 2);
+		} else {
+			resize(ht, ht->capacity);
+		}
+		item = find(ht, hash, data, compare);
+	}
+
+ret:
+	return item;
+}
+
+static ht_item_t *find_or_store(hash_table_t *ht, void *data, void *value,
+				int (*compare)(void *a, void *b), bool *inserted)
+{
+	*inserted = false;
+	if (ht == NULL) {
+		return NULL;
+	}
+	migrate(ht, HT_MIGRATE_SLOTS);
+
+	return find_or_store_hashed(ht, hash_key(ht, data), data, value, compare, inserted);
+}
+
 int insert_ht(hash_table_t *ht, void *data, int (*compare)(void *a, void *b))
 {
 	int ret_val = -1;
+	bool inserted = false;
+
+	find_or_store(ht, data, NULL, compare, &inserted);
+	if (inserted) {
+		ret_val = 0;
+	}
+
+	return ret_val;
+}
+
+int ht_put(hash_table_t *ht, void *key, void *value, int (*compare)(void *a, void *b))
+{
+	int ret_val = -1;
+	bool inserted = false;
+
+	ht_item_t *item = find_or_store(ht, key, value, compare, &inserted);
+	if (!item) {
+		goto ret;
+	}
+	item->value = value;
+
+	ret_val = 0;
+ret:
+	return ret_val;
+}
+
+void *ht_get(hash_table_t *ht, void *key, int (*compare)(void *a, void *b))
+{
+	ht_item_t *item = search_ht(ht, key, compare);
+	return item ? item->value : NULL;
+}
+
+ht_item_t *ht_get_or_insert(hash_table_t *ht, void *key, void *value, int (*compare)(void *a, void *b))
+{
+	bool inserted = false;
+	return find_or_store(ht, key, value, compare, &inserted);
+}
+
+int ht_upsert(hash_table_t *ht, void *key, void *(*update)(void *key, void *value, bool exists, void *ctx),
+	      void *ctx, int (*compare)(void *a, void *b))
+{
+	int ret_val = -1;
+	bool inserted = false;
+
+	ht_item_t *item = find_or_store(ht, key, NULL, compare, &inserted);
+	if (!item) {
+		goto ret;
+	}
+	item->value = update(item->data, item->value, !inserted, ctx);
+
+	ret_val = 0;
+ret:
+	return ret_val;
+}
 
+ht_item_t *search_ht(hash_table_t *ht, void *data, int (*compare)(void *a, void *b))
+{
+	if (ht == NULL) {
+		return NULL;
+	}
+	return search_ht_hashed(ht, hash_key(ht, data), data, compare);
+}
+
+uint64_t ht_hash_key(hash_table_t *ht, void *data)
+{
+	return ht ? hash_key(ht, data) : 0;
+}
+
+ht_item_t *search_ht_hashed(hash_table_t *ht, uint64_t hash, void *data, int (*compare)(void *a, void *b))
+{
+	ht_item_t *search = NULL;
 	if (ht == NULL) {
 		goto ret;
 	}
-	int cmp = 0;
+	migrate(ht, HT_MIGRATE_SLOTS);
 
-	/* Cast (void *) data to (char *) for hashing purposes using FNV64 */
-	size_t hash = FNV64((char *)data) % ht->capacity;
-	size_t hash_copy = hash;
-	while (has_item(&ht->array[hash])) {
-		/* Collision */
-		if (ht->array[hash].hash == hash_copy) {
-			cmp = compare(ht->array[hash].data, data);
-			/* Item already exists */
-			if (cmp == 0) {
-				goto ret;
-			} else {
-				while (!has_item(&ht->array[hash])) {
-					hash += 1;
-				}
+	search = find(ht, hash, data, compare);
+
+ret:
+	return search;
+}
+
+int insert_ht_hashed(hash_table_t *ht, uint64_t hash, void *data, int (*compare)(void *a, void *b))
+{
+	int ret_val = -1;
+	bool inserted = false;
+
+	if (ht == NULL) {
+		goto ret;
+	}
+	migrate(ht, HT_MIGRATE_SLOTS);
+
+	find_or_store_hashed(ht, hash, data, NULL, compare, &inserted);
+	if (inserted) {
+		ret_val = 0;
+	}
+
+ret:
+	return ret_val;
+}
+
+/* Start loading the home bucket of a hash so a later probe finds it in cache */
+static void prefetch_home(hash_table_t *ht, uint64_t hash)
+{
+	if (ht->flags & HT_GROUP_PROBE) {
+		size_t group = home_group(hash, ht->capacity);
+		__builtin_prefetch(&ht->ctrl[group]);
+		__builtin_prefetch(&ht->array[group + (hash & (HT_GROUP_WIDTH - 1))]);
+	} else {
+		__builtin_prefetch(&ht->array[bucket(hash, ht->capacity)]);
+	}
+	if (ht->keys) {
+		__builtin_prefetch(cell_at(ht, (ht->flags & HT_GROUP_PROBE) ? home_group(hash, ht->capacity) :
+						   bucket(hash, ht->capacity)));
+	}
+}
+
+size_t search_ht_batch(hash_table_t *ht, void **data, size_t n, int (*compare)(void *a, void *b),
+		       ht_item_t **results)
+{
+	size_t hits = 0;
+	size_t chunk = 0;
+	uint64_t hashes[HT_BATCH_SIZE];
+
+	if (ht == NULL) {
+		goto ret;
+	}
+	/* Migrate up front so no result is moved by a later chunk */
+	migrate(ht, HT_MIGRATE_SLOTS * n);
+
+	for (size_t start = 0; start < n; start += chunk) {
+		chunk = (n - start < HT_BATCH_SIZE) ? n - start : HT_BATCH_SIZE;
+
+		/* Hash the whole chunk and issue every load before resolving any of them */
+		for (size_t i = 0; i < chunk; i++) {
+			hashes[i] = hash_key(ht, data[start + i]);
+			prefetch_home(ht, hashes[i]);
+		}
+		for (size_t i = 0; i < chunk; i++) {
+			results[start + i] = find(ht, hashes[i], data[start + i], compare);
+			hits += results[start + i] != NULL;
+		}
+	}
+
+ret:
+	return hits;
+}
+
+size_t insert_ht_batch(hash_table_t *ht, void **data, size_t n, int (*compare)(void *a, void *b),
+		       int *results)
+{
+	size_t inserted_items = 0;
+	size_t chunk = 0;
+	bool inserted = false;
+	uint64_t hashes[HT_BATCH_SIZE];
+
+	if (ht == NULL) {
+		goto ret;
+	}
+
+	for (size_t start = 0; start < n; start += chunk) {
+		chunk = (n - start < HT_BATCH_SIZE) ? n - start : HT_BATCH_SIZE;
+		migrate(ht, HT_MIGRATE_SLOTS * chunk);
+
+		for (size_t i = 0; i < chunk; i++) {
+			hashes[i] = hash_key(ht, data[start + i]);
+			prefetch_home(ht, hashes[i]);
+		}
+		for (size_t i = 0; i < chunk; i++) {
+			find_or_store_hashed(ht, hashes[i], data[start + i], NULL, compare, &inserted);
+			if (results) {
+				results[start + i] = inserted ? 0 : -1;
 			}
+			inserted_items += inserted;
 		}
+	}
+
+ret:
+	return inserted_items;
+}
+
+int ht_reserve(hash_table_t *ht, size_t n)
+{
+	int ret_val = -1;
+	size_t next_size = 0;
 
-		/* Move to next spot in hast table if previous was full - Collision handling technique */
-		hash += 1;
+	if (ht == NULL) {
+		goto ret;
 	}
 
-	ht->array[hash].has_item = true;
-	ht->array[hash].hash = hash_copy;
-	ht->array[hash].data = data;
-	ht->items++;
+	/* Large enough that n items stay below the grow threshold */
+	next_size = round_capacity(ht, (size_t)(n / ht->load_factor) + 1);
+	if (next_size > ht->capacity && resize(ht, next_size) == -1) {
+		goto ret;
+	}
+	if (next_size > ht->min_capacity) {
+		ht->min_capacity = next_size;
+	}
+
+	ret_val = 0;
+ret:
+	return ret_val;
+}
 
-	/* If load factor reaches 2/3 capacity then resize by doubling the capacity */
-	if ((float)(ht->items) >= ht->capacity * ht->load_factor) {
-		resize(ht);
+int ht_compact(hash_table_t *ht)
+{
+	int ret_val = -1;
+	size_t next_size = 0;
+
+	if (ht == NULL) {
+		goto ret;
 	}
 
+	/* The smallest capacity that leaves the table at half its grow threshold, never larger than now */
+	next_size = (size_t)(ht->items * 2 / ht->load_factor) + 1;
+	next_size = next_size > ht->min_capacity ? next_size : ht->min_capacity;
+	next_size = round_capacity(ht, next_size < ht->capacity ? next_size : ht->capacity);
+
+	if (next_size == ht->capacity && !ht->tombstones) {
+		migrate(ht, SIZE_MAX);
+		ret_val = 0;
+		goto ret;
+	}
+	if (resize(ht, next_size) == -1) {
+		goto ret;
+	}
+	migrate(ht, SIZE_MAX);
+
 	ret_val = 0;
 ret:
 	return ret_val;
 }
 
-ht_item_t *search_ht(hash_table_t *ht, void *data, int (*compare)(void *a, void *b))
+void ht_clear(hash_table_t *ht, void (*destroy)(void *))
 {
-	ht_item_t *search = NULL;
 	if (ht == NULL) {
+		return;
+	}
+	clear_array(ht->array, ht->capacity, ht->used, 0, ht->ctrl, destroy);
+	if (ht->old_array) {
+		clear_array(ht->old_array, ht->old_capacity, ht->old_used, ht->migrate_index, NULL, destroy);
+		finish_migration(ht);
+	}
+	ht->items = 0;
+	ht->tombstones = 0;
+}
+
+/* Steps past its home a lookup of the item at `index` takes - slots, or groups for group-probed tables */
+static size_t probe_length(hash_table_t *ht, size_t index)
+{
+	uint64_t hash = ht->array[index].hash;
+	size_t groups = ht->capacity / HT_GROUP_WIDTH;
+	size_t group = index / HT_GROUP_WIDTH;
+	size_t home = 0;
+
+	if (!(ht->flags & HT_GROUP_PROBE)) {
+		return displacement(ht->array, ht->capacity, &ht->array[index], hash);
+	}
+	home = home_group(hash, ht->capacity) / HT_GROUP_WIDTH;
+	return group >= home ? group - home : group + groups - home;
+}
+
+int ht_stats(hash_table_t *ht, ht_stats_t *stats)
+{
+	int ret_val = -1;
+	size_t length = 0;
+
+	if (ht == NULL || stats == NULL) {
 		goto ret;
 	}
-	int cmp = 0;
+	memset(stats, 0, sizeof(ht_stats_t));
+	stats->items = ht->items;
+	stats->capacity = ht->capacity;
+	stats->tombstones = ht->tombstones;
+	stats->resizes = ht->resizes;
+	stats->resize_time = ht->resize_time;
+
+	/* Items still in the old array of an incremental resize are left out of the probe lengths */
+	for (size_t i = next_used(ht->used, ht->capacity, 0); i < ht->capacity;
+	     i = next_used(ht->used, ht->capacity, i + 1)) {
+		if (!has_item(&ht->array[i])) {
+			continue;
+		}
+		length = probe_length(ht, i);
+		stats->probes[length < HT_STATS_PROBES ? length : HT_STATS_PROBES - 1]++;
+		if (length > stats->max_displacement) {
+			stats->max_displacement = length;
+		}
+	}
 
-	/* Cast (void *) data to (char *) for hashing purposes using FNV64 */
-	size_t hash = FNV64((char *)data) % ht->capacity;
-	size_t hash_copy = hash;
+	stats->bytes = sizeof(hash_table_t) + ht->capacity * sizeof(ht_item_t) +
+		       bitmap_words(ht->capacity) * sizeof(uint64_t);
+	if (ht->ctrl) {
+		stats->bytes += ht->capacity;
+	}
+	if (ht->keys) {
+		stats->bytes += ht->capacity * HT_KEY_CELL;
+	}
+	if (ht->old_array) {
+		stats->bytes += ht->old_capacity * sizeof(ht_item_t) + bitmap_words(ht->old_capacity) * sizeof(uint64_t);
+	}
 
-	while (hash < ht->capacity) {
-		/* Hash exists */
-		if (ht->array[hash].hash == hash_copy) {
+	ret_val = 0;
+ret:
+	return ret_val;
+}
 
-			/* If the data in the array matches the requested search data then return a reference */
-			cmp = compare(ht->array[hash].data, data);
-			if (cmp == 0) {
-				search = &ht->array[hash];
-				break;
+void ht_iter_init(hash_table_t *ht, ht_iter_t *iter)
+{
+	iter->ht = ht;
+	iter->index = 0;
+	iter->in_old = false;
+}
+
+ht_item_t *ht_iter_next(ht_iter_t *iter)
+{
+	hash_table_t *ht = iter->ht;
+	ht_item_t *item = NULL;
+
+	if (ht == NULL) {
+		goto ret;
+	}
+
+	if (!iter->in_old) {
+		/* Deleted slots stay marked as used, so check each used slot for an item */
+		for (iter->index = next_used(ht->used, ht->capacity, iter->index); iter->index < ht->capacity;
+		     iter->index = next_used(ht->used, ht->capacity, iter->index + 1)) {
+			if (has_item(&ht->array[iter->index])) {
+				item = &ht->array[iter->index++];
+				goto ret;
 			}
 		}
+		iter->in_old = true;
+		iter->index = ht->migrate_index;
+	}
 
-		/* Move to next spot in hash table */
-		hash += 1;
+	/* Items an incremental resize has not moved yet */
+	if (ht->old_array) {
+		for (iter->index = next_used(ht->old_used, ht->old_capacity, iter->index); iter->index < ht->old_capacity;
+		     iter->index = next_used(ht->old_used, ht->old_capacity, iter->index + 1)) {
+			if (has_item(&ht->old_array[iter->index])) {
+				item = &ht->old_array[iter->index++];
+				goto ret;
+			}
+		}
 	}
 
 ret:
-	return search;
-
+	return item;
 }
 
 ht_item_t *index_ht(hash_table_t *ht, size_t index)
@@ -182,12 +1244,29 @@ int delete_ht_item(hash_table_t *ht, void *data, int (*compare)(void *a, void *b
 		goto ret;
 	}
 
-	delete->data = NULL;
-	delete->has_item = false;
-	delete->hash = INT64_MAX;
+	if (ht->flags & HT_GROUP_PROBE) {
+		group_remove(ht, delete);
+	} else if (delete < ht->array || delete >= ht->array + ht->capacity) {
+		/* Still in the old array, which is freed once migrated */
+		make_tombstone(delete);
+	} else if (ht->flags & HT_ROBIN_HOOD) {
+		rh_remove(ht, delete);
+	} else {
+		make_tombstone(delete);
+		ht->tombstones++;
+	}
 	ht->items--;
-	
+
+	/*
+	 * Halve the capacity once the table is a quarter as full as the grow threshold. It is then at
+	 * half that threshold, so a few inserts or deletes cannot make it grow and shrink in turn.
+	 */
+	if (ht->capacity > ht->min_capacity && (float)(ht->items * HT_SHRINK_RATIO) < ht->capacity * ht->load_factor) {
+		size_t next_size = round_capacity(ht, ht->capacity / 2);
+		resize(ht, next_size > ht->min_capacity ? next_size : ht->min_capacity);
+	}
+
 	ret_val = 0;
 ret:
 	return ret_val;
-}
\ No newline at end of file
+}
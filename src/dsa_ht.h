@@ -4,7 +4,7 @@
 /**
  * @file dsa_ht.h
  * @author ajester (alex.m.jester.mil@army.mil)
- * @brief Hash Table Library using FNV64.
+ * @brief Hash Table Library using open addressing.
  * @version 0.1
  * @date 2021-10-26
  * 
@@ -22,9 +22,12 @@
 /**
  * @brief Hash Table Item Structure
  * 
- * @property hash (uint64_t): Hash associated with data address.
- * @property data (void *): Data to be hashed and stored in hash table. 
+ * @property hash (uint64_t): Full 64 bit hash of data, checked before the user comparator is called.
+ * @property data (void *): Data to be hashed and stored in hash table, the key when used as a map.
+ * @property value (void *): Value associated with the key by the map functions, NULL otherwise.
  * @property empty (bool): Boolean value indicating if the location is empty or not.
+ * @property inline_len (uint8_t): Key length in bytes, or 255 for longer keys, when the table keeps inline keys.
+ * @property dist (uint32_t): Distance of the item from its home bucket.
  * 
  * @typedef ht_item_t 
  * 
@@ -32,16 +35,136 @@
 typedef struct hash_table_item {
 	uint64_t hash;
 	void *data;
+	void *value;
 	bool has_item;
+	uint8_t inline_len;
+	uint32_t dist;
 } ht_item_t;
 
+/**
+ * @brief Hash Function Callback
+ * 
+ * @param key (const void *): Key to hash, the `data` pointer given to the hash table.
+ * @param len (size_t): Key length from the table's key length callback, 0 when the table has none.
+ * @return (uint64_t): 64 bit hash of the key.
+ * 
+ * @typedef ht_hash_fn
+ * 
+ */
+typedef uint64_t (*ht_hash_fn)(const void *key, size_t len);
+
+/**
+ * @brief Key Length Callback
+ * 
+ * @param key (const void *): Key to measure, the `data` pointer given to the hash table.
+ * @return (size_t): Number of bytes of the key to hash.
+ * 
+ * @typedef ht_key_len_fn
+ * 
+ */
+typedef size_t (*ht_key_len_fn)(const void *key);
+
+/* Entries in the probe length histogram of ht_stats_t, the last one counts every longer probe */
+#define HT_STATS_PROBES 16
+
+struct hash_table;
+
+/**
+ * @brief Diagnostics Callback, called with a one line description of events such as resizes.
+ * 
+ * @param ht (const struct hash_table *): Table the event happened in.
+ * @param message (const char *): Description of the event, without a trailing newline.
+ * @param ctx (void *): User context given with the callback.
+ * 
+ * @typedef ht_diag_fn
+ * 
+ */
+typedef void (*ht_diag_fn)(const struct hash_table *ht, const char *message, void *ctx);
+
+/**
+ * @brief Hash Table Creation Flags
+ * 
+ * @property HT_INCREMENTAL_RESIZE: Grow by keeping the old and new arrays side by side and migrating
+ * a bounded number of slots on every insert, search, and delete instead of rehashing in one step.
+ * @property HT_ROBIN_HOOD: Robin Hood probing. Lookups stop early and deletes shift later items back
+ * instead of leaving tombstones, so item pointers are only valid until the next insert or delete.
+ * @property HT_GROUP_PROBE: Group probed backend. One control byte per slot, holding 7 bits of the
+ * hash, is kept in a separate array and 16 slots are checked at once (SSE2 when available) before
+ * any item is read. The capacity is rounded up to a multiple of 16. Cannot be combined with
+ * HT_ROBIN_HOOD or HT_INCREMENTAL_RESIZE.
+ * @property HT_POW2_CAPACITY: Round the capacity up to a power of two so home slots are found with a
+ * mask instead of a 64 bit divide. Hashes are mixed first so that the low bits used by the mask
+ * depend on the whole hash.
+ * @property HT_INLINE_KEYS: Keep a copy of the first 16 bytes of every key in the table, next to its
+ * slot. Keys of up to 16 bytes are then found without reading the caller's memory or calling the
+ * comparator, so keys are equal exactly when their bytes are. Key bytes are measured with the key
+ * length callback, which is required with a custom hash function, or as strings by default.
+ * @property HT_SEEDED_HASH: Keyed hashing for tables fed with untrusted keys. Every table gets its own
+ * random seed, so keys cannot be chosen in advance to pile up in one probe chain. String and byte
+ * keys (`ht_hash_string`, `ht_hash_bytes`) are hashed with `dsa_hash64_seeded`. Any other hash
+ * function is mixed with the seed afterwards, which protects against keys chosen to collide in the
+ * table's slots but not against keys that share a full hash. Not a cryptographic MAC.
+ * 
+ * @typedef ht_flags_t
+ * 
+ */
+typedef enum ht_flags {
+	HT_INCREMENTAL_RESIZE = 1 << 0,
+	HT_ROBIN_HOOD = 1 << 1,
+	HT_GROUP_PROBE = 1 << 2,
+	HT_POW2_CAPACITY = 1 << 3,
+	HT_INLINE_KEYS = 1 << 4,
+	HT_SEEDED_HASH = 1 << 5,
+} ht_flags_t;
+
+/**
+ * @brief Hash Table Creation Options
+ * 
+ * @property flags (unsigned int): Bitwise OR of ht_flags_t values.
+ * @property hash (ht_hash_fn): Hash function for keys, NULL for `ht_hash_string`.
+ * @property key_len (ht_key_len_fn): Optional key length callback whose result is passed to `hash`.
+ * @property diag (ht_diag_fn): Optional diagnostics callback, nothing is reported without one.
+ * @property diag_ctx (void *): User context passed to `diag`.
+ * @property seed (uint64_t): Seed for HT_SEEDED_HASH tables, 0 to draw a random one.
+ * 
+ * @typedef ht_options_t
+ * 
+ */
+typedef struct hash_table_options {
+	unsigned int flags;
+	ht_hash_fn hash;
+	ht_key_len_fn key_len;
+	ht_diag_fn diag;
+	void *diag_ctx;
+	uint64_t seed;
+} ht_options_t;
+
 /**
  * @brief Hash Table Structure
  * 
  * @property array (ht_item_t *): Array of hash table items.
  * @property capacity (size_t): Hash table capacity.
  * @property items (size_t): Track the number of items in a hash table.
+ * @property tombstones (size_t): Deleted slots in `array` that still lengthen probe chains. Items and
+ * tombstones together count towards the load factor.
+ * @property min_capacity (size_t): Capacity the table was created or reserved with, it never shrinks below this.
  * @property load_factor (douuble): Ratio to determine when the hash table should be resized.
+ * @property flags (unsigned int): Bitwise OR of ht_flags_t values the table was created with.
+ * @property old_array (ht_item_t *): Array being migrated during an incremental resize, NULL otherwise.
+ * @property old_capacity (size_t): Capacity of `old_array`.
+ * @property migrate_index (size_t): Next slot of `old_array` to migrate.
+ * @property hash (ht_hash_fn): Hash function applied to every key.
+ * @property key_len (ht_key_len_fn): Key length callback, NULL if the hash function finds the length itself.
+ * @property ctrl (int8_t *): Control byte per slot for HT_GROUP_PROBE tables, NULL otherwise.
+ * @property used (uint64_t *): Bitmap with one bit per slot of `array`, set while the slot holds an item
+ * or a tombstone. Walks and clears scan it instead of every slot.
+ * @property old_used (uint64_t *): Bitmap of `old_array`, NULL when no resize is in progress.
+ * @property keys (uint8_t *): First 16 key bytes of every slot of `array` for HT_INLINE_KEYS tables, NULL otherwise.
+ * @property resizes (size_t): Number of resizes, including rehashes at the same capacity.
+ * @property resize_time (double): Seconds spent in resizes, not counting incremental migration steps.
+ * @property diag (ht_diag_fn): Diagnostics callback, NULL if none.
+ * @property diag_ctx (void *): User context passed to `diag`.
+ * @property seed (uint64_t): Hash seed of HT_SEEDED_HASH tables, 0 otherwise.
  * 
  * @typedef hash_table_t
  * 
@@ -50,9 +173,115 @@ typedef struct hash_table {
 	ht_item_t *array;
 	size_t capacity;
 	size_t items;
+	size_t tombstones;
+	size_t min_capacity;
 	double load_factor;
+	unsigned int flags;
+	ht_item_t *old_array;
+	size_t old_capacity;
+	size_t migrate_index;
+	ht_hash_fn hash;
+	ht_key_len_fn key_len;
+	int8_t *ctrl;
+	uint64_t *used;
+	uint64_t *old_used;
+	uint8_t *keys;
+	size_t resizes;
+	double resize_time;
+	ht_diag_fn diag;
+	void *diag_ctx;
+	uint64_t seed;
 } hash_table_t;
 
+/**
+ * @brief Hash Table Statistics
+ * 
+ * @property items (size_t): Number of items.
+ * @property capacity (size_t): Number of slots.
+ * @property tombstones (size_t): Deleted slots that still lengthen probe chains.
+ * @property probes (size_t []): Number of items a lookup finds `i` steps past the home slot, or home
+ * group for HT_GROUP_PROBE tables. The last entry counts all longer probes.
+ * @property max_displacement (size_t): Longest probe of any item, in the same steps as `probes`.
+ * @property resizes (size_t): Number of resizes.
+ * @property resize_time (double): Seconds spent in resizes.
+ * @property bytes (size_t): Bytes allocated for the table and its arrays.
+ * 
+ * @typedef ht_stats_t
+ * 
+ */
+typedef struct hash_table_stats {
+	size_t items;
+	size_t capacity;
+	size_t tombstones;
+	size_t probes[HT_STATS_PROBES];
+	size_t max_displacement;
+	size_t resizes;
+	double resize_time;
+	size_t bytes;
+} ht_stats_t;
+
+/**
+ * @brief Hash Table Iterator
+ * 
+ * @property ht (hash_table_t *): Table being walked.
+ * @property index (size_t): Next slot to look at.
+ * @property in_old (bool): True once the walk has moved on to the array of an incremental resize.
+ * 
+ * @typedef ht_iter_t
+ * 
+ */
+typedef struct hash_table_iterator {
+	hash_table_t *ht;
+	size_t index;
+	bool in_old;
+} ht_iter_t;
+
+/**
+ * @brief Fowler-Noll-Vo hash of a NUL-terminated string, one byte per step.
+ * 
+ * @details Kept for existing callers. Tables hash strings with `ht_hash_string` by default.
+ * 
+ * @param s (const char *): Pointer to the string to hash.
+ * @return (uint64_t): 64 bit hash of the string.
+ */
+uint64_t FNV64(const char *s);
+
+/**
+ * @brief Hash a NUL-terminated string key with `dsa_hash_string`. This is the default hash function.
+ * 
+ * @param key (const void *): Pointer to a NUL-terminated string.
+ * @param len (size_t): Unused, the string length is measured.
+ * @return (uint64_t): 64 bit hash of the string.
+ */
+uint64_t ht_hash_string(const void *key, size_t len);
+
+/**
+ * @brief Hash `len` bytes of a binary key such as a struct with `dsa_hash64`. Use with a key length callback.
+ * 
+ * @param key (const void *): Pointer to the key bytes.
+ * @param len (size_t): Number of bytes to hash.
+ * @return (uint64_t): 64 bit hash of the bytes.
+ */
+uint64_t ht_hash_bytes(const void *key, size_t len);
+
+/**
+ * @brief Hash the uint64_t that `key` points to with `dsa_hash_u64`.
+ * 
+ * @param key (const void *): Pointer to a uint64_t key.
+ * @param len (size_t): Unused.
+ * @return (uint64_t): 64 bit hash of the integer.
+ */
+uint64_t ht_hash_u64(const void *key, size_t len);
+
+/**
+ * @brief Hash the pointer value itself, for integer keys cast to (void *).
+ * 
+ * @param key (const void *): Integer key stored directly in the data pointer.
+ * @param len (size_t): Unused.
+ * @return (uint64_t): 64 bit hash of the integer.
+ */
+uint64_t ht_hash_intptr(const void *key, size_t len);
+
 /**
  * @brief Create a hash_table object. 
  * 
@@ -61,6 +290,25 @@ typedef struct hash_table {
  */
 hash_table_t *create_ht(size_t capacity);
 
+/**
+ * @brief Create a hash_table object with non-default behaviour.
+ * 
+ * @param capacity (size_t): Initial capacity to create the hash table array.
+ * @param options (const ht_options_t *): Creation options, NULL for the defaults used by `create_ht`.
+ * @return (hash_table_t *): Pointer to hash table structure, NULL on failure.
+ */
+hash_table_t *create_ht_ex(size_t capacity, const ht_options_t *options);
+
+/**
+ * @brief Create a hash_table object that hashes keys with a user provided function.
+ * 
+ * @param capacity (size_t): Initial capacity to create the hash table array.
+ * @param hash (ht_hash_fn): Hash function for keys, e.g. `ht_hash_u64` for integer keys.
+ * @param key_len (ht_key_len_fn): Optional key length callback, NULL if `hash` does not need a length.
+ * @return (hash_table_t *): Pointer to hash table structure, NULL on failure.
+ */
+hash_table_t *create_ht_hash(size_t capacity, ht_hash_fn hash, ht_key_len_fn key_len);
+
 /**
  * @brief Destroy a hash table object, free memory allocations including any allocated memory given to `data`
  * utilizing a user provided deallocation function.
@@ -83,6 +331,9 @@ int insert_ht(hash_table_t *ht, void *data, int (*compare)(void *a, void *b));
 /**
  * @brief Delete a hash table item from a hash table.
  * 
+ * @details The table halves its capacity once it is less than a quarter as full as the point at
+ * which it grows, down to the capacity it was created with.
+ * 
  * @param ht (hash_table_t *): Pointer to hash table structure.
  * @param data (void *): Pointer to data to be hashed, searched, and deleted.
  * @param compare : User-defined comparison function that must return an int.
@@ -100,9 +351,177 @@ int delete_ht_item(hash_table_t *ht, void *data, int (*compare)(void *a, void *b
  */
 ht_item_t *search_ht(hash_table_t *ht, void *data, int (*compare)(void *a, void *b));
 
+/**
+ * @brief Hash a key the way a table does on insert and search, including seeding and mixing.
+ * The result can be passed to the `_hashed` calls of the same table and to the `dsa_filter`
+ * calls, so a key is hashed once for both.
+ * 
+ * @param ht (hash_table_t *): Pointer to hash table structure.
+ * @param data (void *): Pointer to data to be hashed.
+ * @return (uint64_t): Hash of the data for this table, 0 if `ht` is NULL.
+ */
+uint64_t ht_hash_key(hash_table_t *ht, void *data);
+
+/**
+ * @brief Search a hash table with a hash from `ht_hash_key` of the same table.
+ * 
+ * @param ht (hash_table_t *): Pointer to hash table structure.
+ * @param hash (uint64_t): Hash of `data` from `ht_hash_key`.
+ * @param data (void *): Pointer to data to be searched.
+ * @param compare : User-defined comparison function that must return an int.
+ * @return (ht_item_t *): Pointer to hash table item structure, NULL if not found.
+ */
+ht_item_t *search_ht_hashed(hash_table_t *ht, uint64_t hash, void *data, int (*compare)(void *a, void *b));
+
+/**
+ * @brief Insert data into a hash table with a hash from `ht_hash_key` of the same table.
+ * 
+ * @param ht (hash_table_t *): Pointer to hash table structure.
+ * @param hash (uint64_t): Hash of `data` from `ht_hash_key`.
+ * @param data (void *): Pointer to data that will be inserted.
+ * @param compare : User-defined comparison function that must return an int.
+ * @return (int): 0 on successful insertion, -1 if the data already exists or on failure.
+ */
+int insert_ht_hashed(hash_table_t *ht, uint64_t hash, void *data, int (*compare)(void *a, void *b));
+
+/**
+ * @brief Search a hash table for many keys at once. Keys are hashed and their home buckets
+ * prefetched in groups before any probe runs, so the cache misses of the lookups overlap.
+ * 
+ * @param ht (hash_table_t *): Pointer to hash table structure.
+ * @param data (void **): Array of `n` pointers to data to be searched.
+ * @param n (size_t): Number of keys.
+ * @param compare : User-defined comparison function that must return an int.
+ * @param results (ht_item_t **): Output array of `n` items, NULL where a key was not found.
+ * @return (size_t): Number of keys found.
+ */
+size_t search_ht_batch(hash_table_t *ht, void **data, size_t n, int (*compare)(void *a, void *b),
+		       ht_item_t **results);
+
+/**
+ * @brief Insert many items at once, prefetching home buckets ahead of the probes.
+ * 
+ * @param ht (hash_table_t *): Pointer to hash table structure.
+ * @param data (void **): Array of `n` pointers to data to be inserted.
+ * @param n (size_t): Number of items.
+ * @param compare : User-defined comparison function that must return an int.
+ * @param results (int *): Optional output array of `n` return codes as from `insert_ht`, may be NULL.
+ * @return (size_t): Number of items inserted.
+ */
+size_t insert_ht_batch(hash_table_t *ht, void **data, size_t n, int (*compare)(void *a, void *b),
+		       int *results);
+
+/**
+ * @brief Associate a value with a key, replacing the value if the key is already present.
+ * 
+ * @param ht (hash_table_t *): Pointer to hash table structure.
+ * @param key (void *): Key to hash and store.
+ * @param value (void *): Value to associate with the key.
+ * @param compare : User-defined comparison function for keys that must return an int.
+ * @return (int): 0 on success, -1 on failure.
+ */
+int ht_put(hash_table_t *ht, void *key, void *value, int (*compare)(void *a, void *b));
+
+/**
+ * @brief Look up the value associated with a key. Only the key is needed for the lookup.
+ * 
+ * @param ht (hash_table_t *): Pointer to hash table structure.
+ * @param key (void *): Key to look up.
+ * @param compare : User-defined comparison function for keys that must return an int.
+ * @return (void *): Value associated with the key, NULL if the key is not present.
+ */
+void *ht_get(hash_table_t *ht, void *key, int (*compare)(void *a, void *b));
+
+/**
+ * @brief Look up a key, inserting it with `value` if it is not present.
+ * 
+ * @param ht (hash_table_t *): Pointer to hash table structure.
+ * @param key (void *): Key to look up or insert.
+ * @param value (void *): Value stored only if the key is inserted.
+ * @param compare : User-defined comparison function for keys that must return an int.
+ * @return (ht_item_t *): Item holding the key and its current value, NULL on failure.
+ */
+ht_item_t *ht_get_or_insert(hash_table_t *ht, void *key, void *value, int (*compare)(void *a, void *b));
+
+/**
+ * @brief Insert or update the value of a key through a callback, hashing the key once.
+ * 
+ * @param ht (hash_table_t *): Pointer to hash table structure.
+ * @param key (void *): Key to look up or insert.
+ * @param update : Callback given the stored key, its current value (NULL when new), whether the key
+ * already existed, and `ctx`. Its return value becomes the key's value.
+ * @param ctx (void *): User context passed to `update`.
+ * @param compare : User-defined comparison function for keys that must return an int.
+ * @return (int): 0 on success, -1 on failure.
+ */
+int ht_upsert(hash_table_t *ht, void *key, void *(*update)(void *key, void *value, bool exists, void *ctx),
+	      void *ctx, int (*compare)(void *a, void *b));
+
+/**
+ * @brief Size a hash table once for `n` items, so loading them never resizes it. The table does
+ * not shrink below this size afterwards.
+ * 
+ * @param ht (hash_table_t *): Pointer to hash table structure.
+ * @param n (size_t): Number of items the table must hold without growing.
+ * @return (int): 0 on success, -1 on failure.
+ */
+int ht_reserve(hash_table_t *ht, size_t n);
+
+/**
+ * @brief Rehash a hash table into the smallest capacity that leaves it at half its grow threshold,
+ * dropping every tombstone and finishing any incremental resize.
+ * 
+ * @param ht (hash_table_t *): Pointer to hash table structure.
+ * @return (int): 0 on success, -1 on failure.
+ */
+int ht_compact(hash_table_t *ht);
+
+/**
+ * @brief Remove every item from a hash table, keeping its allocation. Only used slots are
+ * visited, so the cost follows the number of items rather than the capacity.
+ * 
+ * @param ht (hash_table_t *): Pointer to hash table structure.
+ * @param destroy : User-defined destruction function performed on each item's data.
+ */
+void ht_clear(hash_table_t *ht, void (*destroy)(void *));
+
+/**
+ * @brief Collect statistics about a hash table. This walks every item, so it is not meant for hot paths.
+ * 
+ * @details Items still waiting in the old array of an incremental resize are counted in `items`
+ * and `bytes` but not in the probe lengths.
+ * 
+ * @param ht (hash_table_t *): Pointer to hash table structure.
+ * @param stats (ht_stats_t *): Filled with the table's statistics.
+ * @return (int): 0 on success, -1 on failure.
+ */
+int ht_stats(hash_table_t *ht, ht_stats_t *stats);
+
+/**
+ * @brief Start a walk over the items of a hash table.
+ * 
+ * @param ht (hash_table_t *): Pointer to hash table structure.
+ * @param iter (ht_iter_t *): Iterator to initialise.
+ */
+void ht_iter_init(hash_table_t *ht, ht_iter_t *iter);
+
+/**
+ * @brief Return the next item of a walk. Empty slots are skipped a bitmap word at a time.
+ * 
+ * @details The table must not be modified during the walk. Items still waiting in the old
+ * array of an incremental resize are included.
+ * 
+ * @param iter (ht_iter_t *): Iterator set up by `ht_iter_init`.
+ * @return (ht_item_t *): Next item, NULL once every item has been returned.
+ */
+ht_item_t *ht_iter_next(ht_iter_t *iter);
+
 /**
  * @brief Index a hash table an return a pointer to the indexed object.
  * 
+ * @details While an incremental resize is running only the new array is indexed. Items still
+ * waiting in the old array are not visible through this function.
+ * 
  * @param ht (hash_table_t *): Pointer to hash table structure.
  * @param index (size_t): Index to search.
  * @return (ht_item_t *):  Pointer to indexed hash table item structure.
@@ -0,0 +1,276 @@
+#ifndef DSA_HT_TYPED_H
+#define DSA_HT_TYPED_H
+
+/**
+ * @file dsa_ht_typed.h
+ * @author ajester (alex.m.jester.mil@army.mil)
+ * @brief Type-Specialized Hash Table Generator.
+ * @version 0.1
+ * @date 2021-10-26
+ *
+ * @details Header-only hash tables generated for one key and value type. Keys and values are
+ * stored inline in their own arrays and hashing and equality are expanded in place, so the
+ * compiler can inline both, unlike `hash_table_t` which reaches them through function pointers
+ * and `void *`.
+ *
+ * `DSA_HT_DEFINE(name, key_t, val_t)` generates a table for integer or pointer keys.
+ * `DSA_HT_DEFINE_EX(name, key_t, val_t, hash, eq)` takes a hash expression `hash(key)` returning
+ * uint64_t and an equality expression `eq(a, b)`, e.g. for fixed size struct keys.
+ *
+ * Both generate, for a table `name_t`:
+ *
+ *     name_t *create_name(size_t capacity);
+ *     void destroy_name(name_t **h);
+ *     int name_put(name_t *h, key_t key, val_t value);   0 on success, -1 on failure
+ *     val_t *name_get(name_t *h, key_t key);             NULL if the key is not present
+ *     int name_delete(name_t *h, key_t key);             0 on success, -1 if not present
+ *     int name_reserve(name_t *h, size_t n);             0 on success, -1 on failure
+ *     bool name_next(name_t *h, size_t *index);          walks the slots in use
+ *
+ * Slots are probed linearly in a power of two array. A control byte per slot holds 7 bits of the
+ * hash, so most slots of other keys are passed over without comparing keys.
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Control bytes, a slot in use holds DSA_HT_TYPED_FULL and the top 7 bits of its hash */
+#define DSA_HT_TYPED_EMPTY 0x00
+#define DSA_HT_TYPED_DELETED 0x01
+#define DSA_HT_TYPED_FULL 0x80
+/* Slots of a new table at least */
+#define DSA_HT_TYPED_MIN_CAPACITY 8
+
+/* splitmix64 finalizer, the default hash of integer keys */
+static inline uint64_t dsa_ht_typed_hash_int(uint64_t x)
+{
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9u;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebu;
+	x ^= x >> 31;
+	return x;
+}
+
+#define DSA_HT_TYPED_HASH_INT(key) dsa_ht_typed_hash_int((uint64_t)(uintptr_t)(key))
+#define DSA_HT_TYPED_EQ_INT(a, b) ((a) == (b))
+
+#define DSA_HT_DEFINE(name, key_t, val_t) \
+	DSA_HT_DEFINE_EX(name, key_t, val_t, DSA_HT_TYPED_HASH_INT, DSA_HT_TYPED_EQ_INT)
+
+#define DSA_HT_DEFINE_EX(name, key_t, val_t, hash_fn, eq_fn)                                          \
+	typedef struct name {                                                                          \
+		uint8_t *ctrl;                                                                         \
+		key_t *keys;                                                                           \
+		val_t *values;                                                                         \
+		size_t capacity;                                                                       \
+		size_t items;                                                                          \
+		size_t tombstones;                                                                     \
+	} name##_t;                                                                                    \
+                                                                                                       \
+	static inline uint8_t name##_tag_(uint64_t hash)                                               \
+	{                                                                                              \
+		return (uint8_t)(DSA_HT_TYPED_FULL | (hash >> 57));                                    \
+	}                                                                                              \
+                                                                                                       \
+	/* Slot holding key, or the capacity if it is not present */                                   \
+	static inline size_t name##_find_(const name##_t *h, key_t key, uint64_t hash)                 \
+	{                                                                                              \
+		size_t mask = h->capacity - 1;                                                         \
+		size_t index = hash & mask;                                                            \
+		uint8_t tag = name##_tag_(hash);                                                       \
+                                                                                                       \
+		while (h->ctrl[index] != DSA_HT_TYPED_EMPTY) {                                         \
+			if (h->ctrl[index] == tag && eq_fn(h->keys[index], key)) {                     \
+				return index;                                                          \
+			}                                                                              \
+			index = (index + 1) & mask;                                                    \
+		}                                                                                      \
+		return h->capacity;                                                                    \
+	}                                                                                              \
+                                                                                                       \
+	/* Move every key into `capacity` new slots, dropping the tombstones */                       \
+	static inline int name##_rehash_(name##_t *h, size_t capacity)                                 \
+	{                                                                                              \
+		uint8_t *ctrl = calloc(capacity, 1);                                                   \
+		key_t *keys = malloc(capacity * sizeof(key_t));                                        \
+		val_t *values = malloc(capacity * sizeof(val_t));                                      \
+                                                                                                       \
+		if (!ctrl || !keys || !values) {                                                       \
+			free(ctrl);                                                                    \
+			free(keys);                                                                    \
+			free(values);                                                                  \
+			return -1;                                                                     \
+		}                                                                                      \
+		for (size_t i = 0; i < h->capacity; i++) {                                             \
+			if (!(h->ctrl[i] & DSA_HT_TYPED_FULL)) {                                       \
+				continue;                                                              \
+			}                                                                              \
+			uint64_t hash = hash_fn(h->keys[i]);                                           \
+			size_t index = hash & (capacity - 1);                                          \
+			while (ctrl[index] != DSA_HT_TYPED_EMPTY) {                                    \
+				index = (index + 1) & (capacity - 1);                                  \
+			}                                                                              \
+			ctrl[index] = h->ctrl[i];                                                      \
+			keys[index] = h->keys[i];                                                      \
+			values[index] = h->values[i];                                                  \
+		}                                                                                      \
+		free(h->ctrl);                                                                         \
+		free(h->keys);                                                                         \
+		free(h->values);                                                                       \
+		h->ctrl = ctrl;                                                                        \
+		h->keys = keys;                                                                        \
+		h->values = values;                                                                    \
+		h->capacity = capacity;                                                                \
+		h->tombstones = 0;                                                                     \
+		return 0;                                                                              \
+	}                                                                                              \
+                                                                                                       \
+	/* Slots needed to hold n keys below the 3/4 load factor */                                    \
+	static inline size_t name##_capacity_for_(size_t n)                                            \
+	{                                                                                              \
+		size_t capacity = DSA_HT_TYPED_MIN_CAPACITY;                                           \
+		while (capacity * 3 <= n * 4) {                                                        \
+			capacity *= 2;                                                                 \
+		}                                                                                      \
+		return capacity;                                                                       \
+	}                                                                                              \
+                                                                                                       \
+	static inline name##_t *create_##name(size_t capacity)                                         \
+	{                                                                                              \
+		name##_t *h = calloc(1, sizeof(name##_t));                                             \
+		if (!h) {                                                                              \
+			return NULL;                                                                   \
+		}                                                                                      \
+		capacity = name##_capacity_for_(capacity);                                             \
+		h->ctrl = calloc(capacity, 1);                                                         \
+		h->keys = malloc(capacity * sizeof(key_t));                                            \
+		h->values = malloc(capacity * sizeof(val_t));                                          \
+		if (!h->ctrl || !h->keys || !h->values) {                                              \
+			free(h->ctrl);                                                                 \
+			free(h->keys);                                                                 \
+			free(h->values);                                                               \
+			free(h);                                                                       \
+			return NULL;                                                                   \
+		}                                                                                      \
+		h->capacity = capacity;                                                                \
+		return h;                                                                              \
+	}                                                                                              \
+                                                                                                       \
+	static inline void destroy_##name(name##_t **h)                                                \
+	{                                                                                              \
+		if (*h == NULL) {                                                                      \
+			return;                                                                        \
+		}                                                                                      \
+		free((*h)->ctrl);                                                                      \
+		free((*h)->keys);                                                                      \
+		free((*h)->values);                                                                    \
+		free(*h);                                                                              \
+		*h = NULL;                                                                             \
+	}                                                                                              \
+                                                                                                       \
+	static inline int name##_reserve(name##_t *h, size_t n)                                        \
+	{                                                                                              \
+		size_t capacity = 0;                                                                   \
+		if (h == NULL) {                                                                       \
+			return -1;                                                                     \
+		}                                                                                      \
+		capacity = name##_capacity_for_(n > h->items ? n : h->items);                          \
+		return capacity > h->capacity ? name##_rehash_(h, capacity) : 0;                      \
+	}                                                                                              \
+                                                                                                       \
+	static inline val_t *name##_get(name##_t *h, key_t key)                                        \
+	{                                                                                              \
+		size_t index = 0;                                                                      \
+		if (h == NULL) {                                                                       \
+			return NULL;                                                                   \
+		}                                                                                      \
+		index = name##_find_(h, key, hash_fn(key));                                            \
+		return index < h->capacity ? &h->values[index] : NULL;                                 \
+	}                                                                                              \
+                                                                                                       \
+	static inline int name##_put(name##_t *h, key_t key, val_t value)                              \
+	{                                                                                              \
+		uint64_t hash = 0;                                                                     \
+		size_t mask = 0;                                                                       \
+		size_t index = 0;                                                                      \
+		size_t slot = 0;                                                                       \
+		uint8_t tag = 0;                                                                       \
+                                                                                                       \
+		if (h == NULL) {                                                                       \
+			return -1;                                                                     \
+		}                                                                                      \
+		/* Double, or only drop the tombstones when they are what fills the table */          \
+		if ((h->items + h->tombstones + 1) * 4 > h->capacity * 3 &&                            \
+		    name##_rehash_(h, name##_capacity_for_(h->items + 1)) == -1) {                     \
+			return -1;                                                                     \
+		}                                                                                      \
+		hash = hash_fn(key);                                                                   \
+		mask = h->capacity - 1;                                                                \
+		index = hash & mask;                                                                   \
+		slot = h->capacity;                                                                    \
+		tag = name##_tag_(hash);                                                               \
+                                                                                                       \
+		/* Duplicate check and free slot search share one walk of the chain */               \
+		while (h->ctrl[index] != DSA_HT_TYPED_EMPTY) {                                         \
+			if (h->ctrl[index] == tag && eq_fn(h->keys[index], key)) {                     \
+				h->values[index] = value;                                              \
+				return 0;                                                              \
+			}                                                                              \
+			if (h->ctrl[index] == DSA_HT_TYPED_DELETED && slot == h->capacity) {           \
+				slot = index;                                                          \
+			}                                                                              \
+			index = (index + 1) & mask;                                                    \
+		}                                                                                      \
+		if (slot == h->capacity) {                                                             \
+			slot = index;                                                                  \
+		} else {                                                                               \
+			h->tombstones--;                                                               \
+		}                                                                                      \
+		h->ctrl[slot] = tag;                                                                   \
+		h->keys[slot] = key;                                                                   \
+		h->values[slot] = value;                                                               \
+		h->items++;                                                                            \
+		return 0;                                                                              \
+	}                                                                                              \
+                                                                                                       \
+	static inline int name##_delete(name##_t *h, key_t key)                                        \
+	{                                                                                              \
+		size_t index = 0;                                                                      \
+		if (h == NULL) {                                                                       \
+			return -1;                                                                     \
+		}                                                                                      \
+		index = name##_find_(h, key, hash_fn(key));                                            \
+		if (index == h->capacity) {                                                            \
+			return -1;                                                                     \
+		}                                                                                      \
+		/* A slot ending its chain can be emptied, others keep the chain going */             \
+		if (h->ctrl[(index + 1) & (h->capacity - 1)] == DSA_HT_TYPED_EMPTY) {                  \
+			h->ctrl[index] = DSA_HT_TYPED_EMPTY;                                           \
+		} else {                                                                               \
+			h->ctrl[index] = DSA_HT_TYPED_DELETED;                                         \
+			h->tombstones++;                                                               \
+		}                                                                                      \
+		h->items--;                                                                            \
+		return 0;                                                                              \
+	}                                                                                              \
+                                                                                                       \
+	/* Advance *index to the next slot in use, starting at *index itself */                       \
+	static inline bool name##_next(name##_t *h, size_t *index)                                     \
+	{                                                                                              \
+		while (*index < h->capacity) {                                                         \
+			if (h->ctrl[*index] & DSA_HT_TYPED_FULL) {                                     \
+				return true;                                                           \
+			}                                                                              \
+			(*index)++;                                                                    \
+		}                                                                                      \
+		return false;                                                                          \
+	}
+
+#endif // DSA_HT_TYPED_H
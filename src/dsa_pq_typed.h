@@ -0,0 +1,181 @@
+#ifndef DSA_PQ_TYPED_H
+#define DSA_PQ_TYPED_H
+
+/**
+ * @file dsa_pq_typed.h
+ * @author ajester (alex.m.jester.mil@army.mil)
+ * @brief Type-Specialized Priority Queue Generator.
+ * @version 0.1
+ * @date 2021-10-26
+ *
+ * @details Header-only priority queues generated for one key type. Keys are stored inline and
+ * the comparison is expanded in place, so the compiler can inline it, unlike `pqueue_t` with a
+ * comparator which calls it through a function pointer.
+ *
+ * `DSA_PQ_DEFINE(name, key_t, cmp)` takes a comparison expression `cmp(a, b)` that is negative
+ * when key a comes out before key b, positive when after and 0 for a tie. `DSA_PQ_TYPED_MIN`
+ * and `DSA_PQ_TYPED_MAX` order arithmetic keys lowest or highest first. Keys that tie come out
+ * in the order they were pushed, every key carries a sequence number to break ties.
+ *
+ * It generates, for a queue `name_t`:
+ *
+ *     name_t *create_name(size_t capacity);
+ *     void destroy_name(name_t **h);
+ *     int name_push(name_t *h, key_t key);      0 on success, -1 on failure
+ *     key_t *name_peek(name_t *h);              NULL if the queue is empty
+ *     int name_pop(name_t *h, key_t *key);      0 on success, -1 if the queue is empty
+ *     int name_reserve(name_t *h, size_t n);    0 on success, -1 on failure
+ *
+ * The heap has DSA_PQ_TYPED_ARITY children per entry, which halves its depth against a binary
+ * heap and unrolls the search for the first child.
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define DSA_PQ_TYPED_ARITY 4
+/* Entries of a new queue at least */
+#define DSA_PQ_TYPED_MIN_CAPACITY 8
+
+#define DSA_PQ_TYPED_MIN(a, b) (((a) > (b)) - ((a) < (b)))
+#define DSA_PQ_TYPED_MAX(a, b) (((a) < (b)) - ((a) > (b)))
+
+#define DSA_PQ_DEFINE(name, key_t, cmp_fn)                                                             \
+	typedef struct name##_entry {                                                                  \
+		key_t key;                                                                             \
+		uint64_t sequence;                                                                     \
+	} name##_entry_t;                                                                              \
+                                                                                                       \
+	typedef struct name {                                                                          \
+		name##_entry_t *entries;                                                               \
+		size_t capacity;                                                                       \
+		size_t items;                                                                          \
+		uint64_t sequence;                                                                     \
+	} name##_t;                                                                                    \
+                                                                                                       \
+	/* Whether a comes out before b, ties go to the one pushed first */                           \
+	static inline int name##_before_(const name##_entry_t *a, const name##_entry_t *b)             \
+	{                                                                                              \
+		int order = cmp_fn(a->key, b->key);                                                    \
+		return order < 0 || (order == 0 && a->sequence < b->sequence);                         \
+	}                                                                                              \
+                                                                                                       \
+	static inline int name##_resize_(name##_t *h, size_t capacity)                                 \
+	{                                                                                              \
+		name##_entry_t *entries = realloc(h->entries, capacity * sizeof(name##_entry_t));      \
+		if (!entries) {                                                                        \
+			return -1;                                                                     \
+		}                                                                                      \
+		h->entries = entries;                                                                  \
+		h->capacity = capacity;                                                                \
+		return 0;                                                                              \
+	}                                                                                              \
+                                                                                                       \
+	static inline name##_t *create_##name(size_t capacity)                                         \
+	{                                                                                              \
+		name##_t *h = calloc(1, sizeof(name##_t));                                             \
+		if (!h) {                                                                              \
+			return NULL;                                                                   \
+		}                                                                                      \
+		capacity = capacity > DSA_PQ_TYPED_MIN_CAPACITY ? capacity : DSA_PQ_TYPED_MIN_CAPACITY; \
+		if (name##_resize_(h, capacity) == -1) {                                               \
+			free(h);                                                                       \
+			return NULL;                                                                   \
+		}                                                                                      \
+		return h;                                                                              \
+	}                                                                                              \
+                                                                                                       \
+	static inline void destroy_##name(name##_t **h)                                                \
+	{                                                                                              \
+		if (*h == NULL) {                                                                      \
+			return;                                                                        \
+		}                                                                                      \
+		free((*h)->entries);                                                                   \
+		free(*h);                                                                              \
+		*h = NULL;                                                                             \
+	}                                                                                              \
+                                                                                                       \
+	static inline int name##_reserve(name##_t *h, size_t n)                                        \
+	{                                                                                              \
+		if (h == NULL) {                                                                       \
+			return -1;                                                                     \
+		}                                                                                      \
+		return n > h->capacity ? name##_resize_(h, n) : 0;                                     \
+	}                                                                                              \
+                                                                                                       \
+	static inline int name##_push(name##_t *h, key_t key)                                          \
+	{                                                                                              \
+		name##_entry_t entry;                                                                  \
+		size_t hole = 0;                                                                       \
+		size_t parent = 0;                                                                     \
+                                                                                                       \
+		if (h == NULL) {                                                                       \
+			return -1;                                                                     \
+		}                                                                                      \
+		if (h->items == h->capacity && name##_resize_(h, h->capacity * 2) == -1) {             \
+			return -1;                                                                     \
+		}                                                                                      \
+		entry.key = key;                                                                       \
+		entry.sequence = h->sequence++;                                                        \
+		hole = h->items++;                                                                     \
+		while (hole > 0) {                                                                     \
+			parent = (hole - 1) / DSA_PQ_TYPED_ARITY;                                      \
+			if (!name##_before_(&entry, &h->entries[parent])) {                            \
+				break;                                                                 \
+			}                                                                              \
+			h->entries[hole] = h->entries[parent];                                         \
+			hole = parent;                                                                 \
+		}                                                                                      \
+		h->entries[hole] = entry;                                                              \
+		return 0;                                                                              \
+	}                                                                                              \
+                                                                                                       \
+	static inline key_t *name##_peek(name##_t *h)                                                  \
+	{                                                                                              \
+		if (h == NULL || h->items == 0) {                                                      \
+			return NULL;                                                                   \
+		}                                                                                      \
+		return &h->entries[0].key;                                                             \
+	}                                                                                              \
+                                                                                                       \
+	static inline int name##_pop(name##_t *h, key_t *key)                                          \
+	{                                                                                              \
+		name##_entry_t last;                                                                   \
+		size_t hole = 0;                                                                       \
+		size_t child = 1;                                                                      \
+		size_t first = 0;                                                                      \
+		size_t end = 0;                                                                        \
+                                                                                                       \
+		if (h == NULL || h->items == 0) {                                                      \
+			return -1;                                                                     \
+		}                                                                                      \
+		if (key) {                                                                             \
+			*key = h->entries[0].key;                                                      \
+		}                                                                                      \
+		/* The last entry fills the hole left by the root */                                  \
+		last = h->entries[--h->items];                                                         \
+		while (child < h->items) {                                                             \
+			first = child;                                                                 \
+			end = child + DSA_PQ_TYPED_ARITY < h->items ? child + DSA_PQ_TYPED_ARITY       \
+								    : h->items;                        \
+			for (size_t c = first + 1; c < end; c++) {                                     \
+				if (name##_before_(&h->entries[c], &h->entries[child])) {              \
+					child = c;                                                     \
+				}                                                                      \
+			}                                                                              \
+			if (!name##_before_(&h->entries[child], &last)) {                              \
+				break;                                                                 \
+			}                                                                              \
+			h->entries[hole] = h->entries[child];                                          \
+			hole = child;                                                                  \
+			child = DSA_PQ_TYPED_ARITY * hole + 1;                                         \
+		}                                                                                      \
+		h->entries[hole] = last;                                                               \
+		return 0;                                                                              \
+	}
+
+#endif // DSA_PQ_TYPED_H
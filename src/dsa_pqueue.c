@@ -3,77 +3,331 @@
 #include <stdlib.h>
 #include "dsa_pqueue.h"
 
-static int adjust_pqueue(pqueue_t *pq)
-{    
-	int ret_external = -1;
-	int ret_internal = 0;
-	if (pq == NULL) {
-		goto ret;
+/* What moves with an element besides the element itself, in pqueues that keep it */
+typedef struct pqueue_tag {
+	size_t handle;
+	uint64_t sequence;
+} pqueue_tag_t;
+
+static inline pqueue_tag_t tag_at(const pqueue_t *pq, size_t index)
+{
+	pqueue_tag_t tag = { 0 };
+	if (pq->handles) {
+		tag.handle = pq->handles[index];
+	}
+	if (pq->sequences) {
+		tag.sequence = pq->sequences[index];
+	}
+	return tag;
+}
+
+/* Store an element and its tag at index */
+static inline void place(pqueue_t *pq, size_t index, pqueue_element_t element, pqueue_tag_t tag)
+{
+	pq->array[index] = element;
+	if (pq->handles) {
+		pq->handles[index] = tag.handle;
+		pq->positions[tag.handle] = index;
+	}
+	if (pq->sequences) {
+		pq->sequences[index] = tag.sequence;
+	}
+}
+
+/* Move the element at from to index */
+static inline void move(pqueue_t *pq, size_t index, size_t from)
+{
+	place(pq, index, pq->array[from], tag_at(pq, from));
+}
+
+/* Whether a comes out of the pqueue before b. Ties go to the lower sequence number in PQ_FIFO pqueues. */
+static inline bool before(const pqueue_t *pq, const pqueue_element_t *a, pqueue_tag_t a_tag,
+			  const pqueue_element_t *b, pqueue_tag_t b_tag)
+{
+	int order = 0;
+
+	if (pq->compare) {
+		order = pq->compare(a, b);
+	} else {
+		order = (a->priority > b->priority) - (a->priority < b->priority);
+	}
+	return order < 0 || (order == 0 && pq->sequences && a_tag.sequence < b_tag.sequence);
+}
+
+/* Whether the element at index comes out before element */
+static inline bool index_before(const pqueue_t *pq, size_t index, const pqueue_element_t *element, pqueue_tag_t tag)
+{
+	return before(pq, &pq->array[index], tag_at(pq, index), element, tag);
+}
+
+static inline size_t parent_index(const pqueue_t *pq, size_t index)
+{
+	return (index - 1) / pq->arity;
+}
+
+/* Smallest of count children starting at first, selected without branches */
+static inline size_t smallest_of(const pqueue_t *pq, size_t first, size_t count)
+{
+	size_t smallest = first;
+	size_t priority = pq->array[first].priority;
+
+	for (size_t child = first + 1; child < first + count; child++) {
+		bool smaller = pq->array[child].priority < priority;
+		smallest = smaller ? child : smallest;
+		priority = smaller ? pq->array[child].priority : priority;
+	}
+	return smallest;
+}
+
+/* First of the children starting at first to come out, ordered by the comparator and sequence numbers */
+static size_t first_child(const pqueue_t *pq, size_t first)
+{
+	size_t end = first + pq->arity < pq->elements ? first + pq->arity : pq->elements;
+	size_t smallest = first;
+
+	for (size_t child = first + 1; child < end; child++) {
+		if (index_before(pq, child, &pq->array[smallest], tag_at(pq, smallest))) {
+			smallest = child;
+		}
+	}
+	return smallest;
+}
+
+/* Smallest of the children starting at first, which must exist */
+static inline size_t smallest_child(const pqueue_t *pq, size_t first)
+{
+	if (pq->compare || pq->sequences) {
+		return first_child(pq, first);
+	}
+	/* A constant count for full groups lets the compiler unroll the loop */
+	if (first + pq->arity <= pq->elements) {
+		switch (pq->arity) {
+		case 2:
+			return smallest_of(pq, first, 2);
+		case 4:
+			return smallest_of(pq, first, 4);
+		case 8:
+			return smallest_of(pq, first, 8);
+		}
+	}
+	return smallest_of(pq, first, pq->elements - first);
+}
+
+/* Place element at the hole at index, moving parents up to top down while element comes out before them */
+static void sift_up(pqueue_t *pq, size_t top, size_t hole, pqueue_element_t element, pqueue_tag_t tag)
+{
+	size_t parent = 0;
+
+	while (hole > top) {
+		parent = parent_index(pq, hole);
+		if (!before(pq, &element, tag, &pq->array[parent], tag_at(pq, parent))) {
+			break;
+		}
+		move(pq, hole, parent);
+		hole = parent;
+	}
+	place(pq, hole, element, tag);
+}
+
+/* Place element at the hole at index, moving the first child up while it comes out before element */
+static void sift_down(pqueue_t *pq, size_t hole, pqueue_element_t element, pqueue_tag_t tag)
+{
+	size_t child = pq->arity * hole + 1;
+
+	while (child < pq->elements) {
+		child = smallest_child(pq, child);
+		if (!index_before(pq, child, &element, tag)) {
+			break;
+		}
+		move(pq, hole, child);
+		hole = child;
+		child = pq->arity * hole + 1;
+	}
+	place(pq, hole, element, tag);
+}
+
+/*
+ * Move the hole down to a leaf along the first children, then sift element up from there. It goes
+ * no higher than where the hole started, above which the heap may not be built yet.
+ */
+static void sift_down_bottom_up(pqueue_t *pq, size_t hole, pqueue_element_t element, pqueue_tag_t tag)
+{
+	size_t top = hole;
+	size_t child = pq->arity * hole + 1;
+
+	while (child < pq->elements) {
+		child = smallest_child(pq, child);
+		move(pq, hole, child);
+		hole = child;
+		child = pq->arity * hole + 1;
+	}
+	sift_up(pq, top, hole, element, tag);
+}
+
+/* Sift down with the variant selected by the flags */
+static inline void sift_down_flags(pqueue_t *pq, size_t hole, pqueue_element_t element, pqueue_tag_t tag)
+{
+	if (pq->flags & PQ_BOTTOM_UP) {
+		sift_down_bottom_up(pq, hole, element, tag);
+	} else {
+		sift_down(pq, hole, element, tag);
 	}
-	size_t child_1 = 1;
-	size_t child_2 = 2;
+}
+
+/* Floyd's heap construction, sift down every parent from the last, O(n) */
+static void heapify(pqueue_t *pq)
+{
+	size_t index = 0;
+
+	if (pq->elements < 2) {
+		return;
+	}
+	index = parent_index(pq, pq->elements - 1) + 1;
+	while (index-- > 0) {
+		sift_down_flags(pq, index, pq->array[index], tag_at(pq, index));
+	}
+}
+
+/* Take the element at index out of the heap, the last element fills its place */
+static pqueue_element_t remove_index(pqueue_t *pq, size_t index)
+{
+	pqueue_element_t removed = pq->array[index];
+	pqueue_element_t last;
+	pqueue_tag_t tag = tag_at(pq, index);
+	pqueue_tag_t last_tag;
 	size_t parent = 0;
-	size_t size = 0;
-	size_t current = 0;
-
-	/* readjust binary heap since root (pq_array[0]) will be deleted */
-	while (child_1 <= pq->elements - 1) {
-		/* if only one child, or child 1 is a lower priority */
-		if ((child_2 > pq->elements-1) || 
-				(pq->array[child_1].priority < 
-				pq->array[child_2].priority)) {
-			/* Child 1 becomes parent */
-			pq->array[parent] = pq->array[child_1];
-			parent = child_1;
+
+	pq->elements--;
+	if (index < pq->elements) {
+		last = pq->array[pq->elements];
+		last_tag = tag_at(pq, pq->elements);
+		parent = parent_index(pq, index);
+		if (index > 0 && before(pq, &last, last_tag, &pq->array[parent], tag_at(pq, parent))) {
+			sift_up(pq, 0, index, last, last_tag);
 		} else {
-			/* Child 2 becomes parent */
-			pq->array[parent] = pq->array[child_2];
-			parent = child_2;
+			sift_down_flags(pq, index, last, last_tag);
 		}
-		child_1 = 2 * parent + 1;
-		child_2 = 2 * parent + 2;
-	}    
-	
-	size = pq->elements;
-	current = parent + 1;
-
-	while (current != size) {
-		pq->elements = current - 1;
-		ret_internal = enpqueue(pq, pq->array[current].data, pq->array[current].priority);
-		if (ret_internal == -1) {
-			fprintf(stderr, "adjust_pqueue, enqueue\n");
-			goto ret;
+	}
+	if (pq->handles) {
+		/* The freed handle is kept after the elements, where the next enqueue takes it from */
+		pq->handles[pq->elements] = tag.handle;
+		pq->positions[tag.handle] = PQ_INVALID_HANDLE;
+	}
+	return removed;
+}
+
+/*
+ * Resize the arrays to max_size, new handles are numbered after the existing ones.
+ *
+ * The children of index i are arity * i + 1 to arity * i + arity. The array starts arity - 1
+ * elements into a cache line aligned block, which puts every group of children at a multiple of
+ * arity elements from the start of the block, so a group of 4 elements fills one cache line and
+ * a group of 8 fills two.
+ */
+static int resize_pqueue(pqueue_t *pq, size_t max_size)
+{
+	size_t bytes = sizeof(pqueue_element_t) * (max_size + pq->arity - 1);
+	void *block = NULL;
+	size_t *handles = NULL;
+	size_t *positions = NULL;
+	uint64_t *sequences = NULL;
+
+	/* aligned_alloc takes a multiple of the alignment */
+	block = aligned_alloc(PQ_CACHE_LINE, (bytes + PQ_CACHE_LINE - 1) / PQ_CACHE_LINE * PQ_CACHE_LINE);
+	if (block == NULL) {
+		return -1;
+	}
+	if (pq->block) {
+		memcpy((pqueue_element_t *)block + pq->arity - 1, pq->array, sizeof(pqueue_element_t) * pq->elements);
+		free(pq->block);
+	}
+	pq->block = block;
+	pq->array = (pqueue_element_t *)block + pq->arity - 1;
+	if (pq->flags & PQ_INDEXED) {
+		handles = realloc(pq->handles, sizeof(size_t) * max_size);
+		if (handles == NULL) {
+			return -1;
 		}
-		current++;
-	}      
-	
-	pq->elements = size - 1;
-	
-	if (pq->elements < pq->max_size / 2 && pq->elements >= 4) {
-		pq->array = realloc(pq->array, sizeof(pqueue_element_t) * (pq->max_size/2));
-		if (pq->array == NULL) {
-			fprintf(stderr, "adjust_pqueue, enqueue\n");
-			goto ret;
+		pq->handles = handles;
+		positions = realloc(pq->positions, sizeof(size_t) * max_size);
+		if (positions == NULL) {
+			return -1;
+		}
+		pq->positions = positions;
+		for (size_t i = pq->max_size; i < max_size; i++) {
+			pq->handles[i] = i;
+			pq->positions[i] = PQ_INVALID_HANDLE;
+		}
+	}
+	if (pq->flags & PQ_FIFO) {
+		sequences = realloc(pq->sequences, sizeof(uint64_t) * max_size);
+		if (sequences == NULL) {
+			return -1;
 		}
-		pq->max_size = pq->max_size / 2;
+		pq->sequences = sequences;
+	}
+	pq->max_size = max_size;
+	return 0;
+}
+
+/* Grow to hold n elements, doubling so that repeated growth stays amortized O(1) */
+static int reserve_pqueue(pqueue_t *pq, size_t n)
+{
+	size_t max_size = pq->max_size;
+
+	if (n <= max_size) {
+		return 0;
 	}
+	while (max_size < n) {
+		max_size *= 2;
+	}
+	return resize_pqueue(pq, max_size);
+}
 
-	ret_external = 0;
-ret:
-	return ret_external;
-}    
+/*
+ * Shrink once the elements fill less than a quarter of the array, to half its size or less. Half
+ * full arrays are left alone, so a pqueue going up and down around a size does not resize every
+ * time. Handles of an indexed pqueue may be numbered up to max_size, so it does not shrink.
+ */
+static void shrink_pqueue(pqueue_t *pq)
+{
+	size_t max_size = pq->max_size;
+
+	if (pq->handles) {
+		return;
+	}
+	while (pq->elements >= 4 && pq->elements < max_size / 4) {
+		max_size /= 2;
+	}
+	if (max_size < pq->max_size) {
+		/* On failure the larger array is still valid */
+		resize_pqueue(pq, max_size);
+	}
+}
 
 pqueue_t *create_pqueue(size_t max_size)
+{
+	return create_pqueue_ex(max_size, NULL);
+}
+
+pqueue_t *create_pqueue_ex(size_t max_size, const pqueue_options_t *options)
 {
 	pqueue_t *pq = calloc(1, sizeof(pqueue_t));
 	if (pq == NULL) {
 		printf("Unable to Allocate Priority Queue\n");
 		goto ret;
 	}
-	pq->max_size = max_size;
-	pq->array = malloc(sizeof(pqueue_element_t) * pq->max_size);
-	if (pq->array == NULL) {
+	pq->flags = options ? options->flags : 0;
+	pq->arity = options && options->arity ? options->arity : 2;
+	pq->compare = options ? options->compare : NULL;
+	if (pq->arity != 2 && pq->arity != 4 && pq->arity != 8) {
+		destroy_pqueue(&pq);
+		goto ret;
+	}
+	/* A size of 0 would never grow */
+	if (resize_pqueue(pq, max_size ? max_size : 1) == -1) {
 		printf("Unable to Allocate Priority Queue Array\n");
+		destroy_pqueue(&pq);
 	}
 
 ret:
@@ -82,71 +336,214 @@ ret:
 
 void destroy_pqueue(pqueue_t **pq)
 {
-	free((*pq)->array);
+	free((*pq)->block);
+	free((*pq)->handles);
+	free((*pq)->positions);
+	free((*pq)->sequences);
 	free(*pq);
 	*pq = NULL;
 }
 
-int enpqueue(pqueue_t *pq, void *data, size_t priority)
+/* Tag of an element added at the end, with the next free handle and the next sequence number */
+static inline pqueue_tag_t new_tag(pqueue_t *pq)
 {
-	int ret_val = -1;
-	if (pq == NULL) {
-		goto ret;
+	pqueue_tag_t tag = { 0 };
+	if (pq->handles) {
+		tag.handle = pq->handles[pq->elements];
 	}
+	tag.sequence = pq->sequence++;
+	return tag;
+}
+
+/* Add an element, returning its handle in an indexed pqueue */
+static size_t insert_pqueue(pqueue_t *pq, void *data, size_t priority)
+{
+	pqueue_element_t element = { .priority = priority, .data = data };
+	pqueue_tag_t tag;
 
-	size_t parent, child = 0;
-  
 	/* Dynamically Grow the Queue */
-	if (pq->elements >= pq->max_size) {
-		pq->max_size *= 2;
-		pq->array = realloc(pq->array, sizeof(pqueue_element_t) * pq->max_size);
-		if (pq->array == NULL) {
-			perror("realloc");
-			goto ret;
-		}
+	if (reserve_pqueue(pq, pq->elements + 1) == -1) {
+		perror("realloc");
+		return PQ_INVALID_HANDLE;
 	}
-	pq->elements++;
-
+	tag = new_tag(pq);
 	/* new element is placed at bottom of the array */
-	child = pq->elements - 1;
-	parent = (child - 1) / 2;
+	pq->elements++;
+	sift_up(pq, 0, pq->elements - 1, element, tag);
+	return tag.handle;
+}
 
-	while ((child > 0) && (priority < pq->array[parent].priority)) {
-		pq->array[child] = pq->array[parent];  // Move parent down
-		child = parent;  // Child index becomes the parent parent index
-		parent = (child - 1) / 2;  // Parent's new position
+int enpqueue(pqueue_t *pq, void *data, size_t priority)
+{
+	int ret_val = -1;
+	if (pq == NULL) {
+		goto ret;
+	}
+	if (insert_pqueue(pq, data, priority) == PQ_INVALID_HANDLE) {
+		goto ret;
 	}
-	pq->array[child].data = data;
-	pq->array[child].priority = priority;
 	ret_val = 0;
 
 ret:
 	return ret_val;
 }
 
+pq_handle_t enpqueue_handle(pqueue_t *pq, void *data, size_t priority)
+{
+	if (pq == NULL || !(pq->flags & PQ_INDEXED)) {
+		return PQ_INVALID_HANDLE;
+	}
+	return insert_pqueue(pq, data, priority);
+}
+
 void *depqueue(pqueue_t *pq)
 {
 	void *popped = NULL;
 	if (pq == NULL || pq->elements == 0) {
 		goto ret;
 	}
-	int ret_internal = 0;
-	
-	popped = pq->array[0].data;
 
-	if (pq->elements == 1) {
-		pq->elements = 0;
+	popped = remove_index(pq, 0).data;
+	shrink_pqueue(pq);
+
+ret:
+	return popped;
+}
+
+pqueue_t *create_pqueue_from_array(const pqueue_element_t *elements, size_t n, const pqueue_options_t *options)
+{
+	pqueue_t *pq = NULL;
+	if (elements == NULL && n > 0) {
+		goto ret;
+	}
+	pq = create_pqueue_ex(n, options);
+	if (pq == NULL) {
+		goto ret;
+	}
+	if (n > 0) {
+		memcpy(pq->array, elements, sizeof(pqueue_element_t) * n);
+	}
+	pq->elements = n;
+	/* Handles and sequence numbers start out numbered as the array, so element i has handle i */
+	for (size_t i = 0; i < n; i++) {
+		if (pq->handles) {
+			pq->positions[i] = i;
+		}
+		if (pq->sequences) {
+			pq->sequences[i] = i;
+		}
+	}
+	pq->sequence = n;
+	heapify(pq);
+
+ret:
+	return pq;
+}
+
+int enpqueue_batch(pqueue_t *pq, const pqueue_element_t *elements, size_t n)
+{
+	int ret_val = -1;
+	pqueue_tag_t tag;
+	if (pq == NULL || (elements == NULL && n > 0)) {
+		goto ret;
+	}
+	if (reserve_pqueue(pq, pq->elements + n) == -1) {
+		goto ret;
+	}
+
+	/* A batch larger than the heap is appended and the whole heap is built again in O(n) */
+	if (n > pq->elements) {
+		for (size_t i = 0; i < n; i++) {
+			place(pq, pq->elements, elements[i], new_tag(pq));
+			pq->elements++;
+		}
+		heapify(pq);
 	} else {
-		ret_internal = adjust_pqueue(pq);
-		if (ret_internal == -1) {
-			fprintf(stderr, "Error adjusting pqueue");
+		for (size_t i = 0; i < n; i++) {
+			tag = new_tag(pq);
+			pq->elements++;
+			sift_up(pq, 0, pq->elements - 1, elements[i], tag);
 		}
 	}
+	ret_val = 0;
+
+ret:
+	return ret_val;
+}
+
+size_t depqueue_n(pqueue_t *pq, void **data, size_t n)
+{
+	size_t popped = 0;
+	if (pq == NULL || data == NULL) {
+		goto ret;
+	}
+
+	while (popped < n && pq->elements > 0) {
+		data[popped++] = remove_index(pq, 0).data;
+	}
+	/* One resize for the whole batch */
+	shrink_pqueue(pq);
 
 ret:
 	return popped;
 }
 
+static bool valid_handle(pqueue_t *pq, pq_handle_t handle)
+{
+	return pq != NULL && pq->handles && handle < pq->max_size && pq->positions[handle] != PQ_INVALID_HANDLE;
+}
+
+int pq_update_priority(pqueue_t *pq, pq_handle_t handle, size_t priority)
+{
+	int ret_val = -1;
+	size_t index = 0;
+	size_t parent = 0;
+	pqueue_element_t element;
+	pqueue_tag_t tag;
+
+	if (!valid_handle(pq, handle)) {
+		goto ret;
+	}
+	index = pq->positions[handle];
+	element = pq->array[index];
+	element.priority = priority;
+	tag = tag_at(pq, index);
+	parent = index > 0 ? parent_index(pq, index) : 0;
+	if (index > 0 && before(pq, &element, tag, &pq->array[parent], tag_at(pq, parent))) {
+		sift_up(pq, 0, index, element, tag);
+	} else {
+		sift_down(pq, index, element, tag);
+	}
+	ret_val = 0;
+
+ret:
+	return ret_val;
+}
+
+void *pq_remove(pqueue_t *pq, pq_handle_t handle)
+{
+	void *removed = NULL;
+	if (!valid_handle(pq, handle)) {
+		goto ret;
+	}
+	removed = remove_index(pq, pq->positions[handle]).data;
+
+ret:
+	return removed;
+}
+
+pqueue_element_t *find_pqueue_handle(pqueue_t *pq, pq_handle_t handle)
+{
+	pqueue_element_t *element = NULL;
+	if (!valid_handle(pq, handle)) {
+		goto ret;
+	}
+	element = &pq->array[pq->positions[handle]];
+
+ret:
+	return element;
+}
+
 pqueue_element_t *search_pqueue(pqueue_t *pq, void *data)
 {
 	pqueue_element_t *element = NULL;
@@ -4,7 +4,7 @@
 /**
  * @file dsa_pqueue.h
  * @author ajester (alex.m.jester.mil@army.mil)
- * @brief Priority Queue Library using a Binary Min Heap.
+ * @brief Priority Queue Library using a Binary or d-ary Min Heap.
  * @version 0.1
  * @date 2021-10-26
  * 
@@ -15,7 +15,77 @@
  * 
  */
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Priority Queue Creation Flags
+ *
+ * @property PQ_BOTTOM_UP: Dequeue with a bottom-up sift-down. The hole left by the root is moved
+ * to a leaf along the smaller children, one comparison per level, and the last element is then
+ * sifted up from there. The last element usually belongs near the bottom, so this takes about
+ * half the comparisons of the default sift-down, which compares the last element at every level.
+ * @property PQ_INDEXED: Give every element a handle that stays valid while the element is in the
+ * pqueue, for `pq_update_priority`, `pq_remove` and `find_pqueue_handle` in O(log n). A handle is
+ * reused by a later enqueue once its element has left the pqueue. Indexed pqueues do not shrink.
+ * @property PQ_FIFO: Elements that tie come out in the order they were added. Every element gets
+ * a sequence number as it is added, which breaks ties in priority or in the comparator.
+ *
+ * @typedef pqueue_flags_t
+ *
+ */
+typedef enum pqueue_flags {
+	PQ_BOTTOM_UP = 1 << 0,
+	PQ_INDEXED = 1 << 1,
+	PQ_FIFO = 1 << 2,
+} pqueue_flags_t;
+
+/* Alignment of the heap array, groups of children are laid out from its start */
+#define PQ_CACHE_LINE 64
+
+/**
+ * @brief Handle of an element in a PQ_INDEXED pqueue.
+ *
+ * @typedef pq_handle_t
+ */
+typedef size_t pq_handle_t;
+
+/* Returned instead of a handle on failure */
+#define PQ_INVALID_HANDLE SIZE_MAX
+
+struct pqueue_element;
+
+/**
+ * @brief Priority Queue Comparator, orders elements by any of their priority and data.
+ *
+ * @param a (const struct pqueue_element *): First element.
+ * @param b (const struct pqueue_element *): Second element.
+ * @return (int): Negative if a comes out before b, positive if after, 0 for a tie.
+ *
+ * @typedef pqueue_compare_fn
+ */
+typedef int (*pqueue_compare_fn)(const struct pqueue_element *a, const struct pqueue_element *b);
+
+/**
+ * @brief Priority Queue Creation Options
+ *
+ * @property flags (unsigned int): Bitwise OR of pqueue_flags_t values.
+ * @property arity (unsigned int): Children per element, 2, 4 or 8, 0 for a binary heap. A wider
+ * heap is shallower, so a dequeue visits fewer levels but compares more children at each. Groups
+ * of 4 children fill one cache line and groups of 8 fill two.
+ * @property compare (pqueue_compare_fn): Order of the elements, NULL for the lowest priority
+ * first. A comparator on the data orders composite priorities, and one reversing the priorities
+ * gives a max heap. Elements are copied when they move, so the comparator must not keep pointers.
+ *
+ * @typedef pqueue_options_t
+ *
+ */
+typedef struct pqueue_options {
+	unsigned int flags;
+	unsigned int arity;
+	pqueue_compare_fn compare;
+} pqueue_options_t;
 
 /**
  * @brief Priority Queue Element Struct
@@ -36,6 +106,17 @@ typedef struct pqueue_element {
  * @property max_size (size_t): Maximum size of the priority queue.
  * @property elements (size_t): Number of elements currently in the pqueue.
  * @property array (struct pqueue element *): Array of pqueue elements.
+ * @property block (void *): Cache line aligned allocation holding `array`, which starts arity - 1
+ * elements in so that groups of children are aligned.
+ * @property arity (unsigned int): Children per element.
+ * @property flags (unsigned int): Bitwise OR of pqueue_flags_t values.
+ * @property handles (size_t *): PQ_INDEXED only, handle of the element at each index. Entries
+ * after the elements hold the handles not in use.
+ * @property positions (size_t *): PQ_INDEXED only, index of the element of each handle, or
+ * PQ_INVALID_HANDLE for a handle not in use.
+ * @property sequences (uint64_t *): PQ_FIFO only, sequence number of the element at each index.
+ * @property sequence (uint64_t): Sequence number of the next element added.
+ * @property compare (pqueue_compare_fn): Order of the elements, NULL for the lowest priority first.
  * 
  * @typedef pqueue_t
  * 
@@ -44,6 +125,14 @@ typedef struct pqueue_binary_heap {
 	size_t max_size;
 	size_t elements;
 	struct pqueue_element *array;
+	void *block;
+	unsigned int arity;
+	unsigned int flags;
+	size_t *handles;
+	size_t *positions;
+	uint64_t *sequences;
+	uint64_t sequence;
+	pqueue_compare_fn compare;
 } pqueue_t;
 
 /**
@@ -62,6 +151,15 @@ typedef struct pqueue_binary_heap {
  */
 pqueue_t *create_pqueue(size_t max_size);
 
+/**
+ * @brief Create a pqueue object with options.
+ *
+ * @param max_size (size_t): maximum size of the pqueue.
+ * @param options (const pqueue_options_t *): Creation options, NULL for the defaults used by `create_pqueue`.
+ * @return (pqueue_t *): Pointer to pqueue struct or NULL if a failure occurs or the arity is not supported.
+ */
+pqueue_t *create_pqueue_ex(size_t max_size, const pqueue_options_t *options);
+
 /**
  * @brief Deallocate memory used in a pqueue struct.
  * 
@@ -80,13 +178,87 @@ void destroy_pqueue(pqueue_t **pq);
 int enpqueue(pqueue_t *pq, void *data, size_t priority);
 
 /**
- * @brief Remove a element from the front of a pqueue.
+ * @brief Add a element to a PQ_INDEXED pqueue and get its handle.
+ *
+ * @param pq (pqueue_t *): Pointer to pqueue struct.
+ * @param data (void *): Data to be assiciated with the element.
+ * @param priority (size_t): Priority value of the element.
+ * @return (pq_handle_t): Handle of the element, PQ_INVALID_HANDLE on failure or if the pqueue is not indexed.
+ */
+pq_handle_t enpqueue_handle(pqueue_t *pq, void *data, size_t priority);
+
+/**
+ * @brief Remove a element from the front of a pqueue. The last element takes the place of the
+ * root and is sifted down, O(log n).
  * 
  * @param pq (pqueue_t *): Pointer to pqueue struct. 
  * @return (void *) Pointer to pqueue element's data, NULL on failure.
  */
 void *depqueue(pqueue_t *pq);
 
+/**
+ * @brief Create a pqueue holding a copy of an array of elements, built in O(n) with Floyd's
+ * method instead of n enqueues. The array is allocated once, at exactly n elements. In a
+ * PQ_INDEXED pqueue the element at index i of the array gets handle i.
+ *
+ * @param elements (const pqueue_element_t *): Elements in any order, may be NULL if `n` is 0.
+ * @param n (size_t): Number of elements.
+ * @param options (const pqueue_options_t *): Creation options, NULL for the defaults used by `create_pqueue`.
+ * @return (pqueue_t *): Pointer to pqueue struct or NULL if a failure occurs.
+ */
+pqueue_t *create_pqueue_from_array(const pqueue_element_t *elements, size_t n, const pqueue_options_t *options);
+
+/**
+ * @brief Add an array of elements to a pqueue, growing it at most once. A batch larger than the
+ * pqueue is appended and the heap is rebuilt in O(n), a smaller one is enqueued element by element.
+ * In a PQ_INDEXED pqueue the handles are not returned, use `enpqueue_handle` when they are needed.
+ *
+ * @param pq (pqueue_t *): Pointer to pqueue struct.
+ * @param elements (const pqueue_element_t *): Elements in any order.
+ * @param n (size_t): Number of elements.
+ * @return (int): 0 on success, -1 on failure, in which case none of the elements were added.
+ */
+int enpqueue_batch(pqueue_t *pq, const pqueue_element_t *elements, size_t n);
+
+/**
+ * @brief Remove up to n elements from the front of a pqueue, in priority order, shrinking it at
+ * most once.
+ *
+ * @param pq (pqueue_t *): Pointer to pqueue struct.
+ * @param data (void **): Array of at least n pointers, set to the data of the removed elements.
+ * @param n (size_t): Maximum number of elements to remove.
+ * @return (size_t): Number of elements removed, less than n if the pqueue ran out.
+ */
+size_t depqueue_n(pqueue_t *pq, void **data, size_t n);
+
+/**
+ * @brief Change the priority of an element of a PQ_INDEXED pqueue, O(log n).
+ *
+ * @param pq (pqueue_t *): Pointer to pqueue struct.
+ * @param handle (pq_handle_t): Handle of the element.
+ * @param priority (size_t): New priority value of the element.
+ * @return (int): 0 on success, -1 if the handle is not in use.
+ */
+int pq_update_priority(pqueue_t *pq, pq_handle_t handle, size_t priority);
+
+/**
+ * @brief Remove an element of a PQ_INDEXED pqueue wherever it is, O(log n).
+ *
+ * @param pq (pqueue_t *): Pointer to pqueue struct.
+ * @param handle (pq_handle_t): Handle of the element.
+ * @return (void *): Pointer to the element's data, NULL if the handle is not in use.
+ */
+void *pq_remove(pqueue_t *pq, pq_handle_t handle);
+
+/**
+ * @brief Find the element of a handle in a PQ_INDEXED pqueue.
+ *
+ * @param pq (pqueue_t *): Pointer to pqueue struct.
+ * @param handle (pq_handle_t): Handle of the element.
+ * @return (pqueue_element_t *) Pointer to pqueue element struct, NULL if the handle is not in use.
+ */
+pqueue_element_t *find_pqueue_handle(pqueue_t *pq, pq_handle_t handle);
+
 /**
  * @brief Search a pqueue for data.
  * 
@@ -0,0 +1,364 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "dsa_snapshot.h"
+#include "dsa_hash.h"
+
+/* Slots of a new writer at least */
+#define SNAPSHOT_MIN_CAPACITY 16
+
+static uint64_t key_hash(const void *key, size_t len, uint64_t seed)
+{
+	uint64_t hash = dsa_hash64_seeded(key, len, seed);
+
+	/* 0 marks an empty slot */
+	return hash ? hash : 1;
+}
+
+/* Checksum of the bytes after the header, chained one SNAPSHOT_BLOCK at a time */
+static uint64_t checksum_block(uint64_t checksum, const void *block, size_t len)
+{
+	return dsa_hash64_seeded(block, len, checksum);
+}
+
+static void flush_block(snapshot_writer_t *writer)
+{
+	if (!writer->block_used) {
+		return;
+	}
+	if (fwrite(writer->block, 1, writer->block_used, writer->file) != writer->block_used) {
+		writer->failed = true;
+	}
+	writer->checksum = checksum_block(writer->checksum, writer->block, writer->block_used);
+	writer->block_used = 0;
+}
+
+static void append(snapshot_writer_t *writer, const void *bytes, size_t len)
+{
+	const uint8_t *from = bytes;
+	size_t chunk = 0;
+
+	writer->offset += len;
+	while (len) {
+		chunk = SNAPSHOT_BLOCK - writer->block_used;
+		chunk = len < chunk ? len : chunk;
+		memcpy(writer->block + writer->block_used, from, chunk);
+		writer->block_used += chunk;
+		from += chunk;
+		len -= chunk;
+		if (writer->block_used == SNAPSHOT_BLOCK) {
+			flush_block(writer);
+		}
+	}
+}
+
+static void place_slot(snapshot_slot_t *slots, size_t capacity, const snapshot_slot_t *slot)
+{
+	size_t index = slot->hash & (capacity - 1);
+
+	while (slots[index].hash) {
+		index = (index + 1) & (capacity - 1);
+	}
+	slots[index] = *slot;
+}
+
+/* Double the slots once they are 3/4 full. Slots carry their hashes, so keys are not read again. */
+static int grow_slots(snapshot_writer_t *writer)
+{
+	snapshot_slot_t *slots = NULL;
+	size_t capacity = writer->capacity * 2;
+
+	if ((writer->items + 1) * 4 <= writer->capacity * 3) {
+		return 0;
+	}
+	slots = calloc(capacity, sizeof(snapshot_slot_t));
+	if (!slots) {
+		return -1;
+	}
+	for (size_t i = 0; i < writer->capacity; i++) {
+		if (writer->slots[i].hash) {
+			place_slot(slots, capacity, &writer->slots[i]);
+		}
+	}
+	free(writer->slots);
+	writer->slots = slots;
+	writer->capacity = capacity;
+	return 0;
+}
+
+static void free_writer(snapshot_writer_t *writer)
+{
+	if (writer->file) {
+		fclose(writer->file);
+	}
+	free(writer->block);
+	free(writer->slots);
+	free(writer);
+}
+
+snapshot_writer_t *create_snapshot_writer(const char *path, size_t expected)
+{
+	snapshot_header_t blank = { 0 };
+	struct timespec ts;
+	size_t capacity = SNAPSHOT_MIN_CAPACITY;
+	snapshot_writer_t *writer = calloc(1, sizeof(snapshot_writer_t));
+	if (!writer) {
+		goto ret;
+	}
+
+	while (capacity * 3 <= expected * 4) {
+		capacity *= 2;
+	}
+	writer->file = fopen(path, "wb");
+	writer->block = malloc(SNAPSHOT_BLOCK);
+	writer->slots = calloc(capacity, sizeof(snapshot_slot_t));
+	/* The header stays blank until the snapshot is finished */
+	if (!writer->file || !writer->block || !writer->slots || fwrite(&blank, sizeof(blank), 1, writer->file) != 1) {
+		free_writer(writer);
+		writer = NULL;
+		goto ret;
+	}
+	writer->capacity = capacity;
+	writer->offset = sizeof(snapshot_header_t);
+
+	/* A seed per snapshot, so no key set can be prepared to collide in every file */
+	clock_gettime(CLOCK_REALTIME, &ts);
+	writer->seed = dsa_hash_u64((uint64_t)ts.tv_nsec ^ ((uint64_t)ts.tv_sec << 32) ^ (uint64_t)(uintptr_t)writer);
+	writer->checksum = writer->seed;
+
+ret:
+	return writer;
+}
+
+int snapshot_write(snapshot_writer_t *writer, const void *key, size_t key_len, const void *value, size_t value_len)
+{
+	int ret_val = -1;
+	snapshot_slot_t slot;
+
+	if (writer == NULL || writer->failed || key_len > UINT32_MAX || value_len > UINT32_MAX) {
+		goto ret;
+	}
+	if (grow_slots(writer) == -1) {
+		goto ret;
+	}
+
+	slot.hash = key_hash(key, key_len, writer->seed);
+	slot.offset = writer->offset;
+	slot.key_len = (uint32_t)key_len;
+	slot.value_len = (uint32_t)value_len;
+	append(writer, key, key_len);
+	if (value_len) {
+		append(writer, value, value_len);
+	}
+	place_slot(writer->slots, writer->capacity, &slot);
+	writer->items++;
+
+	ret_val = writer->failed ? -1 : 0;
+ret:
+	return ret_val;
+}
+
+int finish_snapshot(snapshot_writer_t **writer)
+{
+	int ret_val = -1;
+	static const uint8_t padding[8];
+	snapshot_writer_t *w = *writer;
+	snapshot_header_t header = { 0 };
+
+	if (w == NULL) {
+		goto ret;
+	}
+
+	/* Align the slots so they can be read in place */
+	append(w, padding, (8 - w->offset % 8) % 8);
+	header.slots_offset = w->offset;
+	append(w, w->slots, w->capacity * sizeof(snapshot_slot_t));
+	flush_block(w);
+
+	memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+	header.version = SNAPSHOT_VERSION;
+	header.header_size = sizeof(snapshot_header_t);
+	header.capacity = w->capacity;
+	header.items = w->items;
+	header.seed = w->seed;
+	header.file_size = w->offset;
+	header.checksum = w->checksum;
+
+	if (w->failed || fseek(w->file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, w->file) != 1) {
+		goto cleanup;
+	}
+	ret_val = fclose(w->file) == 0 ? 0 : -1;
+	w->file = NULL;
+
+cleanup:
+	free_writer(w);
+	*writer = NULL;
+ret:
+	return ret_val;
+}
+
+static size_t string_bytes(const void *data, const void **bytes)
+{
+	*bytes = data;
+	return strlen((const char *)data);
+}
+
+int save_ht_snapshot(hash_table_t *ht, const char *path, snapshot_bytes_fn key_bytes, snapshot_bytes_fn value_bytes)
+{
+	int ret_val = -1;
+	snapshot_writer_t *writer = NULL;
+	ht_iter_t iter;
+	ht_item_t *item = NULL;
+	const void *key = NULL;
+	const void *value = NULL;
+	size_t key_len = 0;
+	size_t value_len = 0;
+
+	if (ht == NULL) {
+		goto ret;
+	}
+	writer = create_snapshot_writer(path, ht->items);
+	if (!writer) {
+		goto ret;
+	}
+	key_bytes = key_bytes ? key_bytes : string_bytes;
+
+	ht_iter_init(ht, &iter);
+	while ((item = ht_iter_next(&iter))) {
+		key_len = key_bytes(item->data, &key);
+		value_len = value_bytes ? value_bytes(item->value, &value) : 0;
+		if (snapshot_write(writer, key, key_len, value, value_len) == -1) {
+			/* A snapshot missing items is never finished */
+			writer->failed = true;
+			break;
+		}
+	}
+	ret_val = finish_snapshot(&writer);
+
+ret:
+	return ret_val;
+}
+
+static bool valid_header(const snapshot_header_t *header, size_t size)
+{
+	if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+	    header->version != SNAPSHOT_VERSION || header->header_size != sizeof(snapshot_header_t) ||
+	    header->file_size != size) {
+		return false;
+	}
+	if (!header->capacity || (header->capacity & (header->capacity - 1)) ||
+	    header->items >= header->capacity || header->capacity > size / sizeof(snapshot_slot_t)) {
+		return false;
+	}
+	return header->slots_offset % 8 == 0 && header->slots_offset >= header->header_size &&
+	       header->slots_offset + header->capacity * sizeof(snapshot_slot_t) == size;
+}
+
+static bool valid_checksum(const uint8_t *map, const snapshot_header_t *header)
+{
+	uint64_t checksum = header->seed;
+	size_t len = 0;
+
+	for (size_t offset = header->header_size; offset < header->file_size; offset += len) {
+		len = header->file_size - offset < SNAPSHOT_BLOCK ? header->file_size - offset : SNAPSHOT_BLOCK;
+		checksum = checksum_block(checksum, map + offset, len);
+	}
+	return checksum == header->checksum;
+}
+
+snapshot_t *open_snapshot(const char *path, bool verify)
+{
+	snapshot_t *snap = NULL;
+	struct stat st;
+	void *map = MAP_FAILED;
+	int fd = open(path, O_RDONLY);
+
+	if (fd == -1) {
+		goto ret;
+	}
+	if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(snapshot_header_t)) {
+		goto ret;
+	}
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED) {
+		goto ret;
+	}
+	if (!valid_header(map, st.st_size) || (verify && !valid_checksum(map, map))) {
+		goto ret;
+	}
+	snap = calloc(1, sizeof(snapshot_t));
+	if (!snap) {
+		goto ret;
+	}
+	/* Lookups touch scattered pages, so read-ahead would mostly load pages never used */
+	madvise(map, st.st_size, MADV_RANDOM);
+
+	snap->map = map;
+	snap->size = st.st_size;
+	snap->header = map;
+	snap->slots = (const snapshot_slot_t *)(snap->map + snap->header->slots_offset);
+	map = MAP_FAILED;
+
+ret:
+	if (map != MAP_FAILED) {
+		munmap(map, st.st_size);
+	}
+	if (fd != -1) {
+		close(fd);
+	}
+	return snap;
+}
+
+void close_snapshot(snapshot_t **snap)
+{
+	if (*snap == NULL) {
+		return;
+	}
+	munmap((void *)(*snap)->map, (*snap)->size);
+	free(*snap);
+	*snap = NULL;
+}
+
+const void *search_snapshot(snapshot_t *snap, const void *key, size_t key_len, size_t *value_len)
+{
+	const snapshot_header_t *header = NULL;
+	const snapshot_slot_t *slot = NULL;
+	uint64_t hash = 0;
+	size_t mask = 0;
+	size_t index = 0;
+
+	if (snap == NULL) {
+		return NULL;
+	}
+	header = snap->header;
+	hash = key_hash(key, key_len, header->seed);
+	mask = header->capacity - 1;
+	index = hash & mask;
+
+	/* Bounded by the capacity, so a damaged file without empty slots cannot loop forever */
+	for (size_t probes = 0; probes < header->capacity; probes++, index = (index + 1) & mask) {
+		slot = &snap->slots[index];
+		if (!slot->hash) {
+			break;
+		}
+		if (slot->hash != hash || slot->key_len != key_len) {
+			continue;
+		}
+		/* Offsets come from the file, keep them inside the key and value bytes without overflowing */
+		if (slot->offset < header->header_size || slot->offset > header->slots_offset ||
+		    header->slots_offset - slot->offset < (uint64_t)slot->key_len + slot->value_len) {
+			continue;
+		}
+		if (memcmp(snap->map + slot->offset, key, key_len) == 0) {
+			if (value_len) {
+				*value_len = slot->value_len;
+			}
+			return snap->map + slot->offset + key_len;
+		}
+	}
+	return NULL;
+}
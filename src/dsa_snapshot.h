@@ -0,0 +1,219 @@
+#ifndef DSA_SNAPSHOT_H
+#define DSA_SNAPSHOT_H
+
+/**
+ * @file dsa_snapshot.h
+ * @author ajester (alex.m.jester.mil@army.mil)
+ * @brief Hash Table Snapshot Library.
+ * @version 0.1
+ * @date 2021-10-26
+ *
+ * @details Hash Table Snapshot - A read-only hash table stored in a file that is queried in place
+ * through `mmap`, so a restarted process can answer lookups without inserting every key again.
+ * Keys and values are byte strings stored inline in the file, and slots refer to them by file
+ * offset instead of by pointer.
+ *
+ * File layout, in host byte order:
+ *
+ *     snapshot_header_t   magic, version, sizes, hash seed and checksum
+ *     key and value bytes written in insertion order, each value right after its key
+ *     snapshot_slot_t[capacity]   open addressing slots, 8 byte aligned
+ *
+ * A writer streams keys and values to the file as they are added and keeps only the slots in
+ * memory. The header is written last, so an unfinished file is never opened. The checksum covers
+ * everything after the header.
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "dsa_ht.h"
+
+#define SNAPSHOT_MAGIC "DSASNAP"
+#define SNAPSHOT_VERSION 1
+/* Bytes the checksum consumes at a time, and the size of the writer's buffer */
+#define SNAPSHOT_BLOCK (64u << 10)
+
+/**
+ * @brief Snapshot File Header
+ *
+ * @property magic (char []): SNAPSHOT_MAGIC, NUL padded. Zero until the snapshot is finished.
+ * @property version (uint32_t): SNAPSHOT_VERSION of the writer.
+ * @property header_size (uint32_t): Size of this header in bytes.
+ * @property capacity (uint64_t): Number of slots, a power of two.
+ * @property items (uint64_t): Number of keys.
+ * @property seed (uint64_t): Seed of the key hash, `dsa_hash64_seeded`.
+ * @property slots_offset (uint64_t): File offset of the slot array.
+ * @property file_size (uint64_t): Size of the whole file in bytes.
+ * @property checksum (uint64_t): Checksum of the bytes from `header_size` to `file_size`.
+ *
+ * @typedef snapshot_header_t
+ *
+ */
+typedef struct snapshot_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t header_size;
+	uint64_t capacity;
+	uint64_t items;
+	uint64_t seed;
+	uint64_t slots_offset;
+	uint64_t file_size;
+	uint64_t checksum;
+} snapshot_header_t;
+
+/**
+ * @brief Snapshot Slot
+ *
+ * @property hash (uint64_t): Hash of the key, 0 for an empty slot.
+ * @property offset (uint64_t): File offset of the key, which its value follows.
+ * @property key_len (uint32_t): Length of the key in bytes.
+ * @property value_len (uint32_t): Length of the value in bytes.
+ *
+ * @typedef snapshot_slot_t
+ *
+ */
+typedef struct snapshot_slot {
+	uint64_t hash;
+	uint64_t offset;
+	uint32_t key_len;
+	uint32_t value_len;
+} snapshot_slot_t;
+
+/**
+ * @brief Snapshot Writer
+ *
+ * @property file (FILE *): File being written.
+ * @property block (uint8_t *): Buffer of SNAPSHOT_BLOCK bytes not yet written.
+ * @property block_used (size_t): Bytes in `block`.
+ * @property offset (uint64_t): File offset of the next byte added.
+ * @property checksum (uint64_t): Checksum of the blocks written so far.
+ * @property slots (snapshot_slot_t *): Slot array, written to the file when the snapshot is finished.
+ * @property capacity (size_t): Number of slots.
+ * @property items (size_t): Number of keys added.
+ * @property seed (uint64_t): Seed of the key hash.
+ * @property failed (bool): Set once a write has failed, the snapshot can no longer be finished.
+ *
+ * @typedef snapshot_writer_t
+ *
+ */
+typedef struct snapshot_writer {
+	FILE *file;
+	uint8_t *block;
+	size_t block_used;
+	uint64_t offset;
+	uint64_t checksum;
+	snapshot_slot_t *slots;
+	size_t capacity;
+	size_t items;
+	uint64_t seed;
+	bool failed;
+} snapshot_writer_t;
+
+/**
+ * @brief Open Snapshot
+ *
+ * @property map (const uint8_t *): Read-only mapping of the whole file.
+ * @property size (size_t): Size of the mapping.
+ * @property header (const snapshot_header_t *): Header at the start of the mapping.
+ * @property slots (const snapshot_slot_t *): Slot array inside the mapping.
+ *
+ * @typedef snapshot_t
+ *
+ */
+typedef struct snapshot {
+	const uint8_t *map;
+	size_t size;
+	const snapshot_header_t *header;
+	const snapshot_slot_t *slots;
+} snapshot_t;
+
+/**
+ * @brief Bytes Callback, gives the bytes a snapshot stores for a key or value of a `hash_table_t`.
+ *
+ * @param data (const void *): Key or value from the hash table.
+ * @param bytes (const void **): Set to the first byte to store.
+ * @return (size_t): Number of bytes to store.
+ *
+ * @typedef snapshot_bytes_fn
+ *
+ */
+typedef size_t (*snapshot_bytes_fn)(const void *data, const void **bytes);
+
+/**
+ * @brief Start writing a snapshot. The file is created or truncated. Write to a temporary path
+ * and rename it once finished to replace a snapshot other processes may open.
+ *
+ * @param path (const char *): Path of the snapshot file.
+ * @param expected (size_t): Number of keys to size the slots for, more may be added.
+ * @return (snapshot_writer_t *): Pointer to snapshot writer structure, NULL on failure.
+ */
+snapshot_writer_t *create_snapshot_writer(const char *path, size_t expected);
+
+/**
+ * @brief Add a key and its value to a snapshot. Keys are not checked for duplicates, a key added
+ * twice is stored twice and lookups find one of the two.
+ *
+ * @param writer (snapshot_writer_t *): Pointer to snapshot writer structure.
+ * @param key (const void *): Key bytes.
+ * @param key_len (size_t): Length of the key, less than 4 GiB.
+ * @param value (const void *): Value bytes, may be NULL if `value_len` is 0.
+ * @param value_len (size_t): Length of the value, less than 4 GiB.
+ * @return (int): 0 on success, -1 on failure.
+ */
+int snapshot_write(snapshot_writer_t *writer, const void *key, size_t key_len, const void *value, size_t value_len);
+
+/**
+ * @brief Write the slots and the header, close the file and destroy the writer.
+ *
+ * @param writer (snapshot_writer_t **): Double Pointer to snapshot writer structure.
+ * @return (int): 0 on success, -1 if any write failed, in which case the file cannot be opened.
+ */
+int finish_snapshot(snapshot_writer_t **writer);
+
+/**
+ * @brief Write every item of a hash table to a snapshot.
+ *
+ * @param ht (hash_table_t *): Pointer to hash table structure.
+ * @param path (const char *): Path of the snapshot file.
+ * @param key_bytes (snapshot_bytes_fn): Bytes of an item's data, NULL for NUL-terminated strings
+ * stored without the terminator.
+ * @param value_bytes (snapshot_bytes_fn): Bytes of an item's value, NULL to store no values.
+ * @return (int): 0 on success, -1 on failure.
+ */
+int save_ht_snapshot(hash_table_t *ht, const char *path, snapshot_bytes_fn key_bytes, snapshot_bytes_fn value_bytes);
+
+/**
+ * @brief Map a snapshot read-only. The header and the bounds of the slot array are checked, and
+ * with `verify` the checksum as well, which reads the whole file.
+ *
+ * @param path (const char *): Path of the snapshot file.
+ * @param verify (bool): Check the checksum before returning.
+ * @return (snapshot_t *): Pointer to snapshot structure, NULL if the file cannot be mapped or
+ * fails a check.
+ */
+snapshot_t *open_snapshot(const char *path, bool verify);
+
+/**
+ * @brief Unmap a snapshot. Values returned by `search_snapshot` are no longer valid.
+ *
+ * @param snap (snapshot_t **): Double Pointer to snapshot structure.
+ */
+void close_snapshot(snapshot_t **snap);
+
+/**
+ * @brief Look up a key in a snapshot.
+ *
+ * @param snap (snapshot_t *): Pointer to snapshot structure.
+ * @param key (const void *): Key bytes.
+ * @param key_len (size_t): Length of the key.
+ * @param value_len (size_t *): Optional, set to the length of the value.
+ * @return (const void *): Value bytes inside the mapping, NULL if the key is not present.
+ */
+const void *search_snapshot(snapshot_t *snap, const void *key, size_t key_len, size_t *value_len);
+
+#endif // DSA_SNAPSHOT_H
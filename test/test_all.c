@@ -10,6 +10,14 @@
 #include "test_ht.c"
 #include "test_cll.c"
 #include "test_wgraph.c"
+#include "test_hash.c"
+#include "test_cht.c"
+#include "test_cuckoo.c"
+#include "test_filter.c"
+#include "test_cache.c"
+#include "test_ht_typed.c"
+#include "test_snapshot.c"
+#include "test_pq_typed.c"
 
 extern Suite *dsa_ll_st(void);
 extern Suite *dsa_dll_st(void);
@@ -20,6 +28,14 @@ extern Suite *dsa_bst_st(void);
 extern Suite *dsa_ht_st(void);
 extern Suite *dsa_cll_st(void);
 extern Suite *dsa_wgraph_st(void);
+extern Suite *dsa_hash_st(void);
+extern Suite *dsa_cht_st(void);
+extern Suite *dsa_cuckoo_st(void);
+extern Suite *dsa_filter_st(void);
+extern Suite *dsa_cache_st(void);
+extern Suite *dsa_ht_typed_st(void);
+extern Suite *dsa_snapshot_st(void);
+extern Suite *dsa_pq_typed_st(void);
 
 int main(void)
 {
@@ -35,6 +51,14 @@ int main(void)
 	srunner_add_suite(sr, dsa_ht_st());
 	srunner_add_suite(sr, dsa_cll_st());
 	srunner_add_suite(sr, dsa_wgraph_st());
+	srunner_add_suite(sr, dsa_hash_st());
+	srunner_add_suite(sr, dsa_cht_st());
+	srunner_add_suite(sr, dsa_cuckoo_st());
+	srunner_add_suite(sr, dsa_filter_st());
+	srunner_add_suite(sr, dsa_cache_st());
+	srunner_add_suite(sr, dsa_ht_typed_st());
+	srunner_add_suite(sr, dsa_snapshot_st());
+	srunner_add_suite(sr, dsa_pq_typed_st());
 
 	srunner_run_all(sr, CK_NORMAL);
 	int failed = srunner_ntests_failed(sr);
@@ -0,0 +1,202 @@
+#include <check.h>
+#include "../src/dsa_cache.h"
+#include "test_utils.h"
+
+static size_t evicted;
+static void *last_evicted;
+
+static void count_evict(void *key, void *value, void *ctx)
+{
+	evicted++;
+	last_evicted = key;
+	*(size_t *)ctx += (size_t)value;
+}
+
+/* test cache creation */
+START_TEST(test_create_cache)
+	{
+		cache_options_t options = { .policy = CACHE_ARC, .hash = ht_hash_intptr };
+		cache_t *cache = create_cache(8, compare_alphanumeric, NULL);
+		ck_assert_ptr_ne(cache, NULL);
+		ck_assert_int_eq(cache->policy, CACHE_LRU);
+		ck_assert_ptr_eq(cache->ghosts, NULL);
+		destroy_cache(&cache, NULL);
+		ck_assert_ptr_eq(cache, NULL);
+
+		cache = create_cache(8, compare_int_desc, &options);
+		ck_assert_ptr_ne(cache->ghosts, NULL);
+		destroy_cache(&cache, NULL);
+
+		ck_assert_ptr_eq(create_cache(0, compare_alphanumeric, NULL), NULL);
+		ck_assert_ptr_eq(create_cache(8, NULL, NULL), NULL);
+	}
+END_TEST
+
+/* test an LRU cache evicts the least recently used entry */
+START_TEST(test_lru_cache)
+	{
+		size_t evicted_values = 0;
+		cache_options_t options = { .evict = count_evict, .evict_ctx = &evicted_values };
+		cache_t *cache = create_cache(3, compare_alphanumeric, &options);
+
+		evicted = 0;
+		ck_assert_int_eq(cache_put(cache, "a", (void *)1), 0);
+		ck_assert_int_eq(cache_put(cache, "b", (void *)2), 0);
+		ck_assert_int_eq(cache_put(cache, "c", (void *)3), 0);
+		ck_assert_ptr_eq(cache_get(cache, "a"), (void *)1);
+		ck_assert_int_eq(cache_put(cache, "d", (void *)4), 0);
+		ck_assert_int_eq(evicted, 1);
+		ck_assert_str_eq(last_evicted, "b");
+		ck_assert_int_eq(evicted_values, 2);
+		ck_assert_ptr_eq(cache_get(cache, "b"), NULL);
+
+		/* replacing a value marks the entry as used without evicting */
+		ck_assert_int_eq(cache_put(cache, "c", (void *)30), 0);
+		ck_assert_int_eq(evicted, 1);
+		ck_assert_int_eq(cache_put(cache, "e", (void *)5), 0);
+		ck_assert_str_eq(last_evicted, "a");
+		ck_assert_ptr_eq(cache_get(cache, "c"), (void *)30);
+		ck_assert_ptr_eq(cache_get(cache, "d"), (void *)4);
+		ck_assert_int_eq(cache->hits, 3);
+		ck_assert_int_eq(cache->misses, 1);
+		ck_assert_int_eq(cache->evictions, 2);
+
+		ck_assert_int_eq(cache_remove(cache, "d"), 0);
+		ck_assert_int_eq(cache_remove(cache, "d"), -1);
+		ck_assert_int_eq(cache->table->items, 2);
+		ck_assert_int_eq(cache_put(cache, "f", (void *)6), 0);
+		ck_assert_int_eq(evicted, 2);
+
+		ck_assert_ptr_eq(cache_get(NULL, "a"), NULL);
+		ck_assert_int_eq(cache_put(NULL, "a", NULL), -1);
+		ck_assert_int_eq(cache_remove(NULL, "a"), -1);
+		destroy_cache(&cache, NULL);
+	}
+END_TEST
+
+/* test a scan of new keys does not push repeatedly used entries out of an ARC cache */
+START_TEST(test_arc_scan_cache)
+	{
+		cache_policy_t policies[] = { CACHE_LRU, CACHE_ARC };
+		size_t kept = 0;
+
+		for (size_t p = 0; p < 2; p++) {
+			cache_options_t options = { .policy = policies[p], .hash = ht_hash_intptr };
+			cache_t *cache = create_cache(4, compare_int_desc, &options);
+
+			for (intptr_t i = 1; i <= 4; i++) {
+				cache_put(cache, (void *)i, (void *)i);
+				cache_get(cache, (void *)i);
+			}
+			for (intptr_t i = 100; i < 200; i++) {
+				cache_put(cache, (void *)i, (void *)i);
+			}
+			kept = 0;
+			for (intptr_t i = 1; i <= 4; i++) {
+				kept += cache_get(cache, (void *)i) != NULL;
+			}
+			if (policies[p] == CACHE_LRU) {
+				ck_assert_int_eq(kept, 0);
+			} else {
+				ck_assert_int_ge(kept, 3);
+			}
+			destroy_cache(&cache, NULL);
+		}
+	}
+END_TEST
+
+/* test a key evicted from the recent list grows its share when it comes back */
+START_TEST(test_arc_adapt_cache)
+	{
+		cache_options_t options = { .policy = CACHE_ARC, .hash = ht_hash_intptr };
+		cache_t *cache = create_cache(4, compare_int_desc, &options);
+
+		cache_put(cache, (void *)1, (void *)1);
+		cache_put(cache, (void *)2, (void *)2);
+		cache_get(cache, (void *)1);
+		cache_get(cache, (void *)2);
+		cache_put(cache, (void *)3, (void *)3);
+		cache_put(cache, (void *)4, (void *)4);
+		ck_assert_int_eq(cache->frequent->nodes, 2);
+		ck_assert_int_eq(cache->recent->nodes, 2);
+
+		/* 3 is evicted from the recent list and remembered */
+		cache_put(cache, (void *)5, (void *)5);
+		ck_assert_ptr_eq(cache_get(cache, (void *)3), NULL);
+		ck_assert_int_eq(cache->recent_ghosts->nodes, 1);
+		ck_assert_int_eq(cache->target, 0);
+
+		/* 3 returns to the frequent list, and the recent list, now over its target, gives up 4 */
+		cache_put(cache, (void *)3, (void *)3);
+		ck_assert_int_eq(cache->target, 1);
+		ck_assert_int_eq(cache->frequent->nodes, 3);
+		ck_assert_ptr_eq(((cache_entry_t *)cache->frequent->head->data)->key, (void *)3);
+		ck_assert_int_eq(cache->recent_ghosts->nodes, 1);
+		ck_assert_ptr_eq(cache_get(cache, (void *)4), NULL);
+		ck_assert_int_eq(cache->table->items, 4);
+		destroy_cache(&cache, NULL);
+	}
+END_TEST
+
+/* test the ARC list bounds hold over a random mix of lookups, inserts and removals */
+START_TEST(test_arc_bounds_cache)
+	{
+		size_t evicted_values = 0;
+		cache_options_t options = { .policy = CACHE_ARC, .hash = ht_hash_intptr, .evict = count_evict,
+					    .evict_ctx = &evicted_values };
+		cache_t *cache = create_cache(64, compare_int_desc, &options);
+		uint64_t state = 88172645463325252u;
+		size_t inserted = 0;
+		size_t removed = 0;
+
+		evicted = 0;
+		for (int op = 0; op < 20000; op++) {
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			intptr_t key = 1 + (intptr_t)(state % 300);
+			if (key % 7 == 0 && op % 5 == 0) {
+				removed += cache_remove(cache, (void *)key) == 0;
+			} else if (!cache_get(cache, (void *)key)) {
+				ck_assert_int_eq(cache_put(cache, (void *)key, (void *)key), 0);
+				inserted++;
+				ck_assert_ptr_eq(cache_get(cache, (void *)key), (void *)key);
+			}
+
+			size_t recent = cache->recent->nodes;
+			size_t frequent = cache->frequent->nodes;
+			size_t ghosts = cache->recent_ghosts->nodes + cache->frequent_ghosts->nodes;
+			ck_assert_int_le(recent + frequent, 64);
+			ck_assert_int_le(recent + cache->recent_ghosts->nodes, 64);
+			ck_assert_int_le(recent + frequent + ghosts, 128);
+			ck_assert_int_le(cache->target, 64);
+			ck_assert_int_eq(cache->table->items, recent + frequent);
+			ck_assert_int_eq(cache->ghosts->items, ghosts);
+		}
+		ck_assert_int_eq(cache->evictions, evicted);
+		ck_assert_int_eq(inserted - removed - evicted, cache->table->items);
+		destroy_cache(&cache, NULL);
+	}
+END_TEST
+
+static TFun cache_tests[] = {
+	test_create_cache,
+	test_lru_cache,
+	test_arc_scan_cache,
+	test_arc_adapt_cache,
+	test_arc_bounds_cache,
+	NULL
+};
+
+Suite *dsa_cache_st(void)
+{
+	Suite *s = suite_create("DsaCache");
+
+	TCase *tc = tcase_create("Cache Core");
+	TFun *curr = cache_tests;
+	while (*curr) {
+		tcase_add_test(tc, *curr++);
+	}
+	suite_add_tcase(s, tc);
+	return s;
+}
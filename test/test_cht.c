@@ -0,0 +1,249 @@
+#include <check.h>
+#include <pthread.h>
+#include "../src/dsa_cht.h"
+#include "test_utils.h"
+
+#define CHT_TEST_WRITERS 4
+#define CHT_TEST_READERS 2
+#define CHT_TEST_KEYS 5000
+
+struct cht_test_worker {
+	concurrent_ht_t *cht;
+	intptr_t first;
+	int failures;
+	atomic_bool *stop;
+};
+
+static void *cht_writer(void *arg)
+{
+	struct cht_test_worker *worker = arg;
+	for (intptr_t i = worker->first; i < worker->first + CHT_TEST_KEYS; i++) {
+		worker->failures += insert_cht(worker->cht, (void *)i, compare_int_desc) != 0;
+	}
+	/* delete every other key this thread owns */
+	for (intptr_t i = worker->first; i < worker->first + CHT_TEST_KEYS; i += 2) {
+		worker->failures += delete_cht_item(worker->cht, (void *)i, compare_int_desc) != 0;
+	}
+	return NULL;
+}
+
+static void *cht_reader(void *arg)
+{
+	struct cht_test_worker *worker = arg;
+	while (!atomic_load(worker->stop)) {
+		/* key 0 is never inserted, key 1 is never deleted once present */
+		worker->failures += search_cht(worker->cht, (void *)0, compare_int_desc) != NULL;
+		void *found = search_cht(worker->cht, (void *)1, compare_int_desc);
+		worker->failures += found != NULL && found != (void *)1;
+	}
+	return NULL;
+}
+
+struct cht_test_holder {
+	concurrent_ht_t *cht;
+	intptr_t key;
+	int inserted;
+	void *found;
+	pthread_barrier_t *barrier;
+};
+
+static atomic_int cht_test_allocs;
+static int cht_test_fail_from;
+
+/* malloc, failing from the cht_test_fail_from'th call on while it is set */
+static void *cht_test_alloc(size_t size)
+{
+	if (cht_test_fail_from && atomic_fetch_add(&cht_test_allocs, 1) + 1 >= cht_test_fail_from) {
+		return NULL;
+	}
+	return malloc(size);
+}
+
+/* Use the table once, then hold the thread record until every holder has tried */
+static void *cht_holder(void *arg)
+{
+	struct cht_test_holder *holder = arg;
+	holder->inserted = insert_cht(holder->cht, (void *)holder->key, compare_int_desc);
+	holder->found = search_cht(holder->cht, (void *)1, compare_int_desc);
+	pthread_barrier_wait(holder->barrier);
+	return NULL;
+}
+
+/* test concurrent hash table creation */
+START_TEST(test_create_cht)
+	{
+		concurrent_ht_t *cht = create_cht(100, NULL, NULL);
+		ck_assert_ptr_ne(cht, NULL);
+		ck_assert_int_eq(atomic_load(&cht->table)->capacity, 128);
+		destroy_cht(&cht, no_op);
+		ck_assert_ptr_eq(cht, NULL);
+	}
+END_TEST
+
+/* test concurrent hash table single threaded operations */
+START_TEST(test_insert_search_delete_cht)
+	{
+		concurrent_ht_t *cht = create_cht(16, NULL, NULL);
+		ck_assert_ptr_ne(cht, NULL);
+		ck_assert_int_eq(insert_cht(cht, "Hello World", compare_alphanumeric), 0);
+		ck_assert_int_eq(insert_cht(cht, "Good-bye World", compare_alphanumeric), 0);
+		ck_assert_int_eq(insert_cht(cht, "Hello World", compare_alphanumeric), -1);
+		ck_assert_str_eq(search_cht(cht, "Good-bye World", compare_alphanumeric), "Good-bye World");
+		ck_assert_int_eq(delete_cht_item(cht, "Hello World", compare_alphanumeric), 0);
+		ck_assert_int_eq(delete_cht_item(cht, "Hello World", compare_alphanumeric), -1);
+		ck_assert_ptr_eq(search_cht(cht, "Hello World", compare_alphanumeric), NULL);
+		ck_assert_int_eq(atomic_load(&cht->items), 1);
+		destroy_cht(&cht, no_op);
+	}
+END_TEST
+
+/* test concurrent writers and readers across resizes */
+START_TEST(test_threads_cht)
+	{
+		concurrent_ht_t *cht = create_cht(16, ht_hash_intptr, NULL);
+		struct cht_test_worker workers[CHT_TEST_WRITERS + CHT_TEST_READERS] = { 0 };
+		pthread_t threads[CHT_TEST_WRITERS + CHT_TEST_READERS];
+		atomic_bool stop = false;
+		int failures = 0;
+
+		ck_assert_ptr_ne(cht, NULL);
+		for (int i = 0; i < CHT_TEST_WRITERS + CHT_TEST_READERS; i++) {
+			workers[i].cht = cht;
+			workers[i].first = 1 + i * CHT_TEST_KEYS;
+			workers[i].stop = &stop;
+			pthread_create(&threads[i], NULL, i < CHT_TEST_WRITERS ? cht_writer : cht_reader, &workers[i]);
+		}
+		for (int i = 0; i < CHT_TEST_WRITERS; i++) {
+			pthread_join(threads[i], NULL);
+		}
+		atomic_store(&stop, true);
+		for (int i = CHT_TEST_WRITERS; i < CHT_TEST_WRITERS + CHT_TEST_READERS; i++) {
+			pthread_join(threads[i], NULL);
+		}
+		for (int i = 0; i < CHT_TEST_WRITERS + CHT_TEST_READERS; i++) {
+			failures += workers[i].failures;
+		}
+		ck_assert_int_eq(failures, 0);
+		ck_assert_int_eq(atomic_load(&cht->items), CHT_TEST_WRITERS * CHT_TEST_KEYS / 2);
+		ck_assert_int_gt(atomic_load(&cht->table)->capacity, 16);
+		for (intptr_t i = 1; i <= CHT_TEST_WRITERS * CHT_TEST_KEYS; i++) {
+			void *found = search_cht(cht, (void *)i, compare_int_desc);
+			ck_assert_ptr_eq(found, (i % 2 == 0) ? (void *)i : NULL);
+		}
+		destroy_cht(&cht, no_op);
+	}
+END_TEST
+
+/* test operations failing once every thread record is held, and working again after threads exit */
+START_TEST(test_thread_limit_cht)
+	{
+		concurrent_ht_t *cht = create_cht(16, ht_hash_intptr, NULL);
+		struct cht_test_holder holders[CHT_MAX_THREADS] = { 0 };
+		struct cht_test_holder late = { 0 };
+		pthread_t threads[CHT_MAX_THREADS];
+		pthread_t thread;
+		pthread_barrier_t barrier;
+		int inserted = 0;
+		int found = 0;
+
+		ck_assert_ptr_ne(cht, NULL);
+		/* The main thread takes a record first, leaving CHT_MAX_THREADS - 1 for the holders */
+		ck_assert_int_eq(insert_cht(cht, (void *)1, compare_int_desc), 0);
+		pthread_barrier_init(&barrier, NULL, CHT_MAX_THREADS + 1);
+		for (int i = 0; i < CHT_MAX_THREADS; i++) {
+			holders[i].cht = cht;
+			holders[i].key = 2 + i;
+			holders[i].barrier = &barrier;
+			ck_assert_int_eq(pthread_create(&threads[i], NULL, cht_holder, &holders[i]), 0);
+		}
+		pthread_barrier_wait(&barrier);
+		for (int i = 0; i < CHT_MAX_THREADS; i++) {
+			pthread_join(threads[i], NULL);
+			inserted += holders[i].inserted == 0;
+			found += holders[i].found == (void *)1;
+		}
+		pthread_barrier_destroy(&barrier);
+		ck_assert_int_eq(inserted, CHT_MAX_THREADS - 1);
+		ck_assert_int_eq(found, CHT_MAX_THREADS - 1);
+		ck_assert_int_eq(atomic_load(&cht->items), CHT_MAX_THREADS);
+
+		/* Records of exited threads are free again */
+		pthread_barrier_init(&barrier, NULL, 1);
+		late.cht = cht;
+		late.key = 2 + CHT_MAX_THREADS;
+		late.barrier = &barrier;
+		ck_assert_int_eq(pthread_create(&thread, NULL, cht_holder, &late), 0);
+		pthread_join(thread, NULL);
+		pthread_barrier_destroy(&barrier);
+		ck_assert_int_eq(late.inserted, 0);
+		ck_assert_ptr_eq(late.found, (void *)1);
+		destroy_cht(&cht, no_op);
+	}
+END_TEST
+
+/* test a resize whose bucket copy fails, finishing once memory is back and growing again */
+START_TEST(test_resize_oom_cht)
+	{
+		concurrent_ht_t *cht = create_cht(16, ht_hash_intptr, NULL);
+		cht_table_t *table = NULL;
+		intptr_t key = 1;
+
+		ck_assert_ptr_ne(cht, NULL);
+		cht->node_alloc = cht_test_alloc;
+		for (; key <= 12; key++) {
+			ck_assert_int_eq(insert_cht(cht, (void *)key, compare_int_desc), 0);
+		}
+
+		/* The 13th insert starts a resize, its node is the first allocation and every copy fails */
+		atomic_store(&cht_test_allocs, 0);
+		cht_test_fail_from = 2;
+		ck_assert_int_eq(insert_cht(cht, (void *)key++, compare_int_desc), 0);
+		cht_test_fail_from = 0;
+		table = atomic_load(&cht->table);
+		ck_assert_int_eq(table->capacity, 16);
+		ck_assert_ptr_ne(atomic_load(&table->next), NULL);
+		ck_assert_int_gt(atomic_load(&table->failed), 0);
+		for (intptr_t i = 1; i < key; i++) {
+			ck_assert_ptr_eq(search_cht(cht, (void *)i, compare_int_desc), (void *)i);
+		}
+
+		/* The next writer retries the bucket and publishes the new table */
+		ck_assert_int_eq(insert_cht(cht, (void *)key++, compare_int_desc), 0);
+		table = atomic_load(&cht->table);
+		ck_assert_int_eq(table->capacity, 32);
+		ck_assert_ptr_eq(atomic_load(&table->next), NULL);
+
+		/* Later resizes start as usual */
+		for (; key <= 100; key++) {
+			ck_assert_int_eq(insert_cht(cht, (void *)key, compare_int_desc), 0);
+		}
+		ck_assert_int_eq(atomic_load(&cht->table)->capacity, 256);
+		for (intptr_t i = 1; i <= 100; i++) {
+			ck_assert_ptr_eq(search_cht(cht, (void *)i, compare_int_desc), (void *)i);
+		}
+		ck_assert_int_eq(atomic_load(&cht->items), 100);
+		destroy_cht(&cht, no_op);
+	}
+END_TEST
+
+static TFun cht_tests[] = {
+	test_create_cht,
+	test_insert_search_delete_cht,
+	test_threads_cht,
+	test_thread_limit_cht,
+	test_resize_oom_cht,
+	NULL
+};
+
+Suite *dsa_cht_st(void)
+{
+	Suite *s = suite_create("DsaCHT");
+
+	TCase *tc = tcase_create("CHT Core");
+	TFun *curr = cht_tests;
+	while (*curr) {
+		tcase_add_test(tc, *curr++);
+	}
+	suite_add_tcase(s, tc);
+	return s;
+}
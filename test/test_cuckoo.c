@@ -0,0 +1,113 @@
+#include <check.h>
+#include "../src/dsa_cuckoo.h"
+#include "test_utils.h"
+
+/* every key gets the same full hash, so only the two buckets and the stash can hold them */
+static uint64_t constant_hash(const void *key, size_t len)
+{
+	return 42;
+}
+
+/* test cuckoo hash table creation */
+START_TEST(test_create_cuckoo)
+	{
+		cuckoo_ht_t *ct = create_cuckoo(100, NULL, NULL);
+		ck_assert_ptr_ne(ct, NULL);
+		ck_assert_int_eq(ct->nbuckets, 32);
+		ck_assert_int_eq(((uintptr_t)ct->buckets) % 64, 0);
+		destroy_cuckoo(&ct, no_op);
+		ck_assert_ptr_eq(ct, NULL);
+	}
+END_TEST
+
+/* test cuckoo hash table insertion, search, and deletion */
+START_TEST(test_insert_search_delete_cuckoo)
+	{
+		cuckoo_ht_t *ct = create_cuckoo(16, NULL, NULL);
+		ck_assert_ptr_ne(ct, NULL);
+		ck_assert_int_eq(insert_cuckoo(ct, "Hello World", compare_alphanumeric), 0);
+		ck_assert_int_eq(insert_cuckoo(ct, "Good-bye World", compare_alphanumeric), 0);
+		ck_assert_int_eq(insert_cuckoo(ct, "Hello World", compare_alphanumeric), -1);
+		ck_assert_str_eq(search_cuckoo(ct, "Good-bye World", compare_alphanumeric), "Good-bye World");
+		ck_assert_int_eq(delete_cuckoo_item(ct, "Hello World", compare_alphanumeric), 0);
+		ck_assert_int_eq(delete_cuckoo_item(ct, "Hello World", compare_alphanumeric), -1);
+		ck_assert_ptr_eq(search_cuckoo(ct, "Hello World", compare_alphanumeric), NULL);
+		ck_assert_int_eq(ct->items, 1);
+		destroy_cuckoo(&ct, no_op);
+	}
+END_TEST
+
+/* test cuckoo hash table growth and high load */
+START_TEST(test_grow_cuckoo)
+	{
+		cuckoo_ht_t *ct = create_cuckoo(8, ht_hash_intptr, NULL);
+		ck_assert_ptr_ne(ct, NULL);
+		for (intptr_t i = 1; i <= 20000; i++) {
+			ck_assert_int_eq(insert_cuckoo(ct, (void *)i, compare_int_desc), 0);
+		}
+		ck_assert_int_eq(ct->items, 20000);
+		/* grows only once 90% of the slots are used */
+		ck_assert_int_le(ct->nbuckets * CUCKOO_BUCKET_SLOTS, 20000 / 0.45);
+		for (intptr_t i = 1; i <= 20000; i += 2) {
+			ck_assert_int_eq(delete_cuckoo_item(ct, (void *)i, compare_int_desc), 0);
+		}
+		for (intptr_t i = 1; i <= 20001; i++) {
+			ck_assert_ptr_eq(search_cuckoo(ct, (void *)i, compare_int_desc), (i % 2 == 0) ? (void *)i : NULL);
+		}
+		destroy_cuckoo(&ct, no_op);
+	}
+END_TEST
+
+/* test the stash and the rehash giving up on keys no seed can separate */
+START_TEST(test_stash_cuckoo)
+	{
+		cuckoo_ht_t *ct = create_cuckoo(64, constant_hash, NULL);
+		size_t nbuckets = ct->nbuckets;
+		const size_t fits = 2 * CUCKOO_BUCKET_SLOTS + CUCKOO_STASH_SIZE;
+
+		for (intptr_t i = 1; i <= (intptr_t)fits; i++) {
+			ck_assert_int_eq(insert_cuckoo(ct, (void *)i, compare_int_desc), 0);
+		}
+		ck_assert_int_eq(ct->stash_items, CUCKOO_STASH_SIZE);
+		ck_assert_int_eq(insert_cuckoo(ct, (void *)(fits + 1), compare_int_desc), -1);
+		ck_assert_int_eq(ct->nbuckets, nbuckets);
+		for (intptr_t i = 1; i <= (intptr_t)fits; i++) {
+			ck_assert_ptr_eq(search_cuckoo(ct, (void *)i, compare_int_desc), (void *)i);
+		}
+
+		/* a slot freed in a bucket is refilled from the stash */
+		for (intptr_t i = 1; i <= (intptr_t)fits; i++) {
+			if (search_cuckoo(ct, (void *)i, compare_int_desc) &&
+			    ct->stash[0].data != (void *)i && ct->stash[1].data != (void *)i &&
+			    ct->stash[2].data != (void *)i && ct->stash[3].data != (void *)i) {
+				ck_assert_int_eq(delete_cuckoo_item(ct, (void *)i, compare_int_desc), 0);
+				break;
+			}
+		}
+		ck_assert_int_eq(ct->stash_items, CUCKOO_STASH_SIZE - 1);
+		ck_assert_int_eq(insert_cuckoo(ct, (void *)(fits + 1), compare_int_desc), 0);
+		ck_assert_ptr_eq(search_cuckoo(ct, (void *)(fits + 1), compare_int_desc), (void *)(fits + 1));
+		destroy_cuckoo(&ct, no_op);
+	}
+END_TEST
+
+static TFun cuckoo_tests[] = {
+	test_create_cuckoo,
+	test_insert_search_delete_cuckoo,
+	test_grow_cuckoo,
+	test_stash_cuckoo,
+	NULL
+};
+
+Suite *dsa_cuckoo_st(void)
+{
+	Suite *s = suite_create("DsaCuckoo");
+
+	TCase *tc = tcase_create("Cuckoo Core");
+	TFun *curr = cuckoo_tests;
+	while (*curr) {
+		tcase_add_test(tc, *curr++);
+	}
+	suite_add_tcase(s, tc);
+	return s;
+}
@@ -162,6 +162,52 @@ START_TEST(test_dll_search)
 	}
 END_TEST
 
+/* test doubly linked list node unlinking and relinking */
+START_TEST(test_dll_unlink_link)
+	{
+		dll_t *dll = dll_create();
+		dll_node_t *node = NULL;
+		ck_assert_ptr_ne(dll, NULL);
+
+		dll_insert_front(dll, (void *)1);
+		dll_insert_front(dll, (void *)2);
+		dll_insert_front(dll, (void *)3);
+
+		/* middle, tail and head nodes move to the front */
+		node = dll->head->next;
+		dll_unlink(dll, node);
+		ck_assert_int_eq(dll->nodes, 2);
+		ck_assert_ptr_eq(dll->head->next, dll->tail);
+		ck_assert_ptr_eq(dll->tail->previous, dll->head);
+		dll_link_front(dll, node);
+		ck_assert_ptr_eq(dll->head->data, (void *)2);
+		ck_assert_ptr_eq(dll->head->next->data, (void *)3);
+
+		node = dll->tail;
+		dll_unlink(dll, node);
+		ck_assert_ptr_eq(dll->tail->data, (void *)3);
+		ck_assert_ptr_eq(dll->tail->next, NULL);
+		dll_link_front(dll, node);
+		ck_assert_ptr_eq(dll->head->data, (void *)1);
+		ck_assert_ptr_eq(dll->tail->data, (void *)3);
+		ck_assert_int_eq(dll->nodes, 3);
+
+		/* the last node leaves an empty list */
+		while (dll->head) {
+			node = dll->head;
+			dll_unlink(dll, node);
+			free(node);
+		}
+		ck_assert_ptr_eq(dll->tail, NULL);
+		ck_assert_int_eq(dll->nodes, 0);
+		dll_link_front(dll, dll_create_node((void *)4));
+		ck_assert_ptr_eq(dll->head, dll->tail);
+		ck_assert_ptr_eq(dll->tail->data, (void *)4);
+
+		dll_destroy(&dll, no_op);
+	}
+END_TEST
+
 /* test doubly linked list insertion sorting */
 START_TEST(test_sort_dll)
 	{
@@ -189,6 +235,7 @@ static TFun dll_tests[] = {
 	test_dll_delete_rear,
 	test_dll_delete_at_pos,
 	test_dll_search,
+	test_dll_unlink_link,
 	test_sort_dll,
 	NULL
 };
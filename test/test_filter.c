@@ -0,0 +1,258 @@
+#include <check.h>
+#include "../src/dsa_filter.h"
+#include "../src/dsa_hash.h"
+#include "../src/dsa_ht.h"
+#include "test_utils.h"
+
+#define FILTER_KEYS 10000
+
+/* test blocked Bloom filter creation and sizing */
+START_TEST(test_create_bloom)
+	{
+		bloom_filter_t *bf = create_bloom(1000, 10);
+		ck_assert_ptr_ne(bf, NULL);
+		ck_assert_int_eq(bf->nblocks, 32);
+		ck_assert_int_eq(bf->k, 7);
+		ck_assert_int_eq(((uintptr_t)bf->blocks) % 64, 0);
+		destroy_bloom(&bf);
+		ck_assert_ptr_eq(bf, NULL);
+		ck_assert_ptr_eq(create_bloom(1000, 0), NULL);
+
+		bf = create_bloom(0, 1);
+		ck_assert_int_eq(bf->nblocks, 1);
+		ck_assert_int_eq(bf->k, 1);
+		destroy_bloom(&bf);
+	}
+END_TEST
+
+/* test Bloom filter queries have no false negatives and few false positives */
+START_TEST(test_insert_search_bloom)
+	{
+		bloom_filter_t *bf = create_bloom(FILTER_KEYS, 10);
+		size_t false_positives = 0;
+
+		for (uint64_t i = 0; i < FILTER_KEYS; i++) {
+			ck_assert_int_eq(insert_bloom(bf, dsa_hash_u64(i)), 0);
+		}
+		ck_assert_int_eq(bf->items, FILTER_KEYS);
+		for (uint64_t i = 0; i < FILTER_KEYS; i++) {
+			ck_assert(search_bloom(bf, dsa_hash_u64(i)));
+		}
+		for (uint64_t i = FILTER_KEYS; i < 11 * FILTER_KEYS; i++) {
+			false_positives += search_bloom(bf, dsa_hash_u64(i));
+		}
+		ck_assert_int_lt(false_positives, FILTER_KEYS * 10 / 50);
+
+		ck_assert_int_eq(insert_bloom(NULL, 1), -1);
+		ck_assert(!search_bloom(NULL, 1));
+		destroy_bloom(&bf);
+	}
+END_TEST
+
+/* test Bloom filter bulk build, bulk query and merge */
+START_TEST(test_batch_merge_bloom)
+	{
+		uint64_t hashes[2 * FILTER_KEYS];
+		bool results[2 * FILTER_KEYS];
+		bloom_filter_t *low = create_bloom(2 * FILTER_KEYS, 10);
+		bloom_filter_t *high = create_bloom(2 * FILTER_KEYS, 10);
+		bloom_filter_t *other = create_bloom(2 * FILTER_KEYS, 4);
+
+		for (uint64_t i = 0; i < 2 * FILTER_KEYS; i++) {
+			hashes[i] = dsa_hash_u64(i);
+		}
+		ck_assert_int_eq(insert_bloom_batch(low, hashes, FILTER_KEYS), 0);
+		ck_assert_int_eq(insert_bloom_batch(high, hashes + FILTER_KEYS, FILTER_KEYS), 0);
+		ck_assert_int_ge(search_bloom_batch(low, hashes, 2 * FILTER_KEYS, results), FILTER_KEYS);
+		for (size_t i = 0; i < FILTER_KEYS; i++) {
+			ck_assert(results[i]);
+		}
+
+		ck_assert_int_eq(merge_bloom(low, high), 0);
+		ck_assert_int_eq(low->items, 2 * FILTER_KEYS);
+		ck_assert_int_eq(search_bloom_batch(low, hashes, 2 * FILTER_KEYS, results), 2 * FILTER_KEYS);
+		ck_assert_int_eq(merge_bloom(low, other), -1);
+		ck_assert_int_eq(merge_bloom(low, NULL), -1);
+
+		destroy_bloom(&low);
+		destroy_bloom(&high);
+		destroy_bloom(&other);
+	}
+END_TEST
+
+/* test cuckoo filter insertion, search, and deletion */
+START_TEST(test_insert_search_delete_cfilter)
+	{
+		cfilter_t *cf = create_cfilter(FILTER_KEYS);
+		size_t false_positives = 0;
+
+		ck_assert_ptr_ne(cf, NULL);
+		ck_assert_int_ge(cf->nbuckets * CFILTER_BUCKET_SLOTS * 0.95, FILTER_KEYS);
+		for (uint64_t i = 0; i < FILTER_KEYS; i++) {
+			ck_assert_int_eq(insert_cfilter(cf, dsa_hash_u64(i)), 0);
+		}
+		ck_assert_int_eq(cf->items, FILTER_KEYS);
+		for (uint64_t i = 0; i < FILTER_KEYS; i++) {
+			ck_assert(search_cfilter(cf, dsa_hash_u64(i)));
+		}
+		for (uint64_t i = FILTER_KEYS; i < 11 * FILTER_KEYS; i++) {
+			false_positives += search_cfilter(cf, dsa_hash_u64(i));
+		}
+		ck_assert_int_lt(false_positives, FILTER_KEYS * 10 / 200);
+
+		/* deleted keys are gone, the rest are still found */
+		for (uint64_t i = 0; i < FILTER_KEYS; i += 2) {
+			ck_assert_int_eq(delete_cfilter_item(cf, dsa_hash_u64(i)), 0);
+		}
+		ck_assert_int_eq(cf->items, FILTER_KEYS / 2);
+		false_positives = 0;
+		for (uint64_t i = 0; i < FILTER_KEYS; i++) {
+			if (i % 2) {
+				ck_assert(search_cfilter(cf, dsa_hash_u64(i)));
+			} else {
+				false_positives += search_cfilter(cf, dsa_hash_u64(i));
+			}
+		}
+		ck_assert_int_lt(false_positives, 10);
+
+		/* a key added twice is removed twice */
+		ck_assert_int_eq(insert_cfilter(cf, 42), 0);
+		ck_assert_int_eq(insert_cfilter(cf, 42), 0);
+		ck_assert_int_eq(delete_cfilter_item(cf, 42), 0);
+		ck_assert(search_cfilter(cf, 42));
+		ck_assert_int_eq(delete_cfilter_item(cf, 42), 0);
+
+		ck_assert_int_eq(insert_cfilter(NULL, 1), -1);
+		ck_assert_int_eq(delete_cfilter_item(NULL, 1), -1);
+		destroy_cfilter(&cf);
+		ck_assert_ptr_eq(cf, NULL);
+	}
+END_TEST
+
+/* test a full cuckoo filter refuses keys and keeps every key it accepted */
+START_TEST(test_full_cfilter)
+	{
+		cfilter_t *cf = create_cfilter(64);
+		size_t slots = cf->nbuckets * CFILTER_BUCKET_SLOTS;
+		uint64_t added = 0;
+
+		while (insert_cfilter(cf, dsa_hash_u64(added)) == 0) {
+			added++;
+		}
+		ck_assert_int_ne(cf->victim_fp, 0);
+		ck_assert_int_ge(added, slots * 0.9);
+		ck_assert_int_le(added, slots + 1);
+		for (uint64_t i = 0; i < added; i++) {
+			ck_assert(search_cfilter(cf, dsa_hash_u64(i)));
+		}
+
+		/* deleting makes room for the victim and then for new keys */
+		for (uint64_t i = 0; i < 8; i++) {
+			ck_assert_int_eq(delete_cfilter_item(cf, dsa_hash_u64(i)), 0);
+		}
+		for (uint64_t i = 8; i < added; i++) {
+			ck_assert(search_cfilter(cf, dsa_hash_u64(i)));
+		}
+		ck_assert_int_eq(cf->victim_fp, 0);
+		ck_assert_int_eq(insert_cfilter(cf, dsa_hash_u64(0)), 0);
+		destroy_cfilter(&cf);
+	}
+END_TEST
+
+/* test cuckoo filter bulk build, bulk query and merge */
+START_TEST(test_batch_merge_cfilter)
+	{
+		uint64_t hashes[2 * FILTER_KEYS];
+		bool results[2 * FILTER_KEYS];
+		cfilter_t *low = create_cfilter(2 * FILTER_KEYS);
+		cfilter_t *high = create_cfilter(2 * FILTER_KEYS);
+		cfilter_t *small = create_cfilter(16);
+
+		for (uint64_t i = 0; i < 2 * FILTER_KEYS; i++) {
+			hashes[i] = dsa_hash_u64(i);
+		}
+		ck_assert_int_eq(insert_cfilter_batch(low, hashes, FILTER_KEYS), FILTER_KEYS);
+		ck_assert_int_eq(insert_cfilter_batch(high, hashes + FILTER_KEYS, FILTER_KEYS), FILTER_KEYS);
+		ck_assert_int_lt(search_cfilter_batch(low, hashes, 2 * FILTER_KEYS, results), FILTER_KEYS + 100);
+		for (size_t i = 0; i < FILTER_KEYS; i++) {
+			ck_assert(results[i]);
+		}
+
+		ck_assert_int_eq(merge_cfilter(low, high), 0);
+		ck_assert_int_eq(low->items, 2 * FILTER_KEYS);
+		ck_assert_int_eq(search_cfilter_batch(low, hashes, 2 * FILTER_KEYS, results), 2 * FILTER_KEYS);
+		ck_assert_int_eq(delete_cfilter_item(low, hashes[FILTER_KEYS]), 0);
+		ck_assert_int_eq(merge_cfilter(low, small), -1);
+		ck_assert_int_eq(merge_cfilter(low, low), -1);
+
+		destroy_cfilter(&low);
+		destroy_cfilter(&high);
+		destroy_cfilter(&small);
+	}
+END_TEST
+
+/* test one hash from ht_hash_key serving a filter and the table it guards */
+START_TEST(test_filter_guards_ht)
+	{
+		unsigned int modes[] = { 0, HT_SEEDED_HASH | HT_POW2_CAPACITY, HT_GROUP_PROBE };
+		uint64_t hash = 0;
+
+		for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+			ht_options_t options = { .flags = modes[m], .hash = ht_hash_intptr };
+			hash_table_t *ht = create_ht_ex(16, &options);
+			bloom_filter_t *bf = create_bloom(1000, 10);
+			cfilter_t *cf = create_cfilter(1000);
+
+			for (intptr_t i = 1; i <= 1000; i++) {
+				hash = ht_hash_key(ht, (void *)i);
+				ck_assert_int_eq(insert_ht_hashed(ht, hash, (void *)i, compare_int_desc), 0);
+				insert_bloom(bf, hash);
+				insert_cfilter(cf, hash);
+			}
+			for (intptr_t i = 1; i <= 2000; i++) {
+				hash = ht_hash_key(ht, (void *)i);
+				if (i <= 1000) {
+					ck_assert(search_bloom(bf, hash));
+					ck_assert(search_cfilter(cf, hash));
+					ck_assert_ptr_ne(search_ht_hashed(ht, hash, (void *)i, compare_int_desc), NULL);
+					ck_assert_ptr_eq(search_ht_hashed(ht, hash, (void *)i, compare_int_desc),
+							 search_ht(ht, (void *)i, compare_int_desc));
+				} else if (search_bloom(bf, hash) || search_cfilter(cf, hash)) {
+					ck_assert_ptr_eq(search_ht_hashed(ht, hash, (void *)i, compare_int_desc), NULL);
+				}
+			}
+			ck_assert_int_eq(insert_ht_hashed(ht, ht_hash_key(ht, (void *)1), (void *)1, compare_int_desc), -1);
+
+			destroy_ht(&ht, no_op);
+			destroy_bloom(&bf);
+			destroy_cfilter(&cf);
+		}
+		ck_assert_int_eq(ht_hash_key(NULL, NULL), 0);
+		ck_assert_ptr_eq(search_ht_hashed(NULL, 0, NULL, compare_int_desc), NULL);
+		ck_assert_int_eq(insert_ht_hashed(NULL, 0, NULL, compare_int_desc), -1);
+	}
+END_TEST
+
+static TFun filter_tests[] = {
+	test_create_bloom,
+	test_insert_search_bloom,
+	test_batch_merge_bloom,
+	test_insert_search_delete_cfilter,
+	test_full_cfilter,
+	test_batch_merge_cfilter,
+	test_filter_guards_ht,
+	NULL
+};
+
+Suite *dsa_filter_st(void)
+{
+	Suite *s = suite_create("DsaFilter");
+
+	TCase *tc = tcase_create("Filter Core");
+	TFun *curr = filter_tests;
+	while (*curr) {
+		tcase_add_test(tc, *curr++);
+	}
+	suite_add_tcase(s, tc);
+	return s;
+}
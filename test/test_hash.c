@@ -0,0 +1,57 @@
+#include <check.h>
+#include <string.h>
+#include "../src/dsa_hash.h"
+
+/* test hashing is deterministic and length aware */
+START_TEST(test_hash64)
+	{
+		const char *key = "/var/lib/dsa/some/fairly/long/path/to/a/file.txt";
+		size_t len = strlen(key);
+
+		ck_assert(dsa_hash64(key, len) == dsa_hash64(key, len));
+		ck_assert(dsa_hash_string(key) == dsa_hash64(key, len));
+
+		/* every prefix length hashes differently */
+		for (size_t i = 0; i < len; i++) {
+			ck_assert(dsa_hash64(key, i) != dsa_hash64(key, i + 1));
+		}
+
+		/* bytes past the length are never read into the hash */
+		char a[32] = "abcdefgh-XXXXXXXX";
+		char b[32] = "abcdefgh-YYYYYYYY";
+		ck_assert(dsa_hash64(a, 9) == dsa_hash64(b, 9));
+		ck_assert(dsa_hash64(a, 17) != dsa_hash64(b, 17));
+	}
+END_TEST
+
+/* test seeded hashing */
+START_TEST(test_hash64_seeded)
+	{
+		const char *key = "Hello World";
+		size_t len = strlen(key);
+
+		ck_assert(dsa_hash64_seeded(key, len, 0) == dsa_hash64(key, len));
+		ck_assert(dsa_hash64_seeded(key, len, 1) != dsa_hash64_seeded(key, len, 2));
+		ck_assert(dsa_hash64_seeded(key, len, 1) == dsa_hash64_seeded(key, len, 1));
+		ck_assert(dsa_hash_u64(1) != dsa_hash_u64(2));
+	}
+END_TEST
+
+static TFun hash_tests[] = {
+	test_hash64,
+	test_hash64_seeded,
+	NULL
+};
+
+Suite *dsa_hash_st(void)
+{
+	Suite *s = suite_create("DsaHASH");
+
+	TCase *tc = tcase_create("HASH Core");
+	TFun *curr = hash_tests;
+	while (*curr) {
+		tcase_add_test(tc, *curr++);
+	}
+	suite_add_tcase(s, tc);
+	return s;
+}
@@ -1,4 +1,6 @@
 #include <check.h>
+#include <stdio.h>
+#include <string.h>
 #include "dsa_ht.h"
 #include "test_utils.h"
 
@@ -62,7 +64,7 @@ START_TEST(test_index_ht)
 		ck_assert_ptr_ne(ht, NULL);
 		ck_assert_int_eq(ht->capacity, 100);
 		insert_ht(ht, (void *)"Hello World", compare_alphanumeric);
-		index = index_ht(ht, 11);
+		index = index_ht(ht, ht_hash_string("Hello World", 0) % ht->capacity);
 		ck_assert_str_eq(index->data, "Hello World");
 		destroy_ht(&ht, no_op);
 	}
@@ -86,12 +88,746 @@ START_TEST(test_delete_ht_item)
 	}
 END_TEST
 
+/* test hash table incremental resizing */
+START_TEST(test_incremental_resize_ht)
+	{
+		hash_table_t *ht = NULL;
+		ht_options_t options = { .flags = HT_INCREMENTAL_RESIZE };
+		static char keys[200][16];
+		bool migrated = false;
+
+		ht = create_ht_ex(8, &options);
+		ck_assert_ptr_ne(ht, NULL);
+		for (int i = 0; i < 200; i++) {
+			snprintf(keys[i], sizeof(keys[i]), "key-%d", i);
+			ck_assert_int_eq(insert_ht(ht, keys[i], compare_alphanumeric), 0);
+			migrated |= (ht->old_array != NULL);
+			/* every key stays reachable while the arrays are side by side */
+			for (int j = 0; j <= i; j++) {
+				ck_assert_ptr_ne(search_ht(ht, keys[j], compare_alphanumeric), NULL);
+			}
+		}
+		ck_assert(migrated);
+		ck_assert_int_eq(ht->items, 200);
+		ck_assert_int_eq(insert_ht(ht, keys[42], compare_alphanumeric), -1);
+		ck_assert_int_eq(delete_ht_item(ht, keys[42], compare_alphanumeric), 0);
+		ck_assert_ptr_eq(search_ht(ht, keys[42], compare_alphanumeric), NULL);
+
+		/* enough operations drain the old array */
+		for (size_t i = 0; i < ht->capacity; i++) {
+			search_ht(ht, keys[0], compare_alphanumeric);
+		}
+		ck_assert_ptr_eq(ht->old_array, NULL);
+		ck_assert_ptr_ne(search_ht(ht, keys[199], compare_alphanumeric), NULL);
+		destroy_ht(&ht, no_op);
+	}
+END_TEST
+
+struct ht_test_point {
+	int x;
+	int y;
+};
+
+static size_t point_len(const void *key)
+{
+	return sizeof(struct ht_test_point);
+}
+
+static int compare_point(void *a, void *b)
+{
+	return memcmp(a, b, sizeof(struct ht_test_point));
+}
+
+static int compare_u64(void *a, void *b)
+{
+	uint64_t u64_a = *(uint64_t *)a;
+	uint64_t u64_b = *(uint64_t *)b;
+	return (u64_a > u64_b) - (u64_a < u64_b);
+}
+
+/* test hash table with user provided hash functions */
+START_TEST(test_custom_hash_ht)
+	{
+		hash_table_t *ht = NULL;
+		struct ht_test_point points[3] = { { 1, 2 }, { 2, 1 }, { 1, 2 } };
+		uint64_t numbers[3] = { 7, 1ull << 40, 7 };
+
+		/* binary struct keys hashed with a key length callback */
+		ht = create_ht_hash(16, ht_hash_bytes, point_len);
+		ck_assert_ptr_ne(ht, NULL);
+		ck_assert_int_eq(insert_ht(ht, &points[0], compare_point), 0);
+		ck_assert_int_eq(insert_ht(ht, &points[1], compare_point), 0);
+		ck_assert_int_eq(insert_ht(ht, &points[2], compare_point), -1);
+		ck_assert_ptr_eq(search_ht(ht, &points[2], compare_point)->data, &points[0]);
+		destroy_ht(&ht, no_op);
+
+		/* integer keys read through a pointer */
+		ht = create_ht_hash(16, ht_hash_u64, NULL);
+		ck_assert_int_eq(insert_ht(ht, &numbers[0], compare_u64), 0);
+		ck_assert_int_eq(insert_ht(ht, &numbers[1], compare_u64), 0);
+		ck_assert_ptr_eq(search_ht(ht, &numbers[2], compare_u64)->data, &numbers[0]);
+		destroy_ht(&ht, no_op);
+
+		/* integer keys stored directly in the data pointer */
+		ht = create_ht_hash(4, ht_hash_intptr, NULL);
+		for (intptr_t i = 1; i <= 64; i++) {
+			ck_assert_int_eq(insert_ht(ht, (void *)i, compare_int_desc), 0);
+		}
+		ck_assert_int_eq(ht->items, 64);
+		ck_assert_ptr_eq(search_ht(ht, (void *)33, compare_int_desc)->data, (void *)33);
+		ck_assert_ptr_eq(search_ht(ht, (void *)65, compare_int_desc), NULL);
+		destroy_ht(&ht, no_op);
+	}
+END_TEST
+
+static int compare_calls;
+
+static int counting_compare(void *a, void *b)
+{
+	compare_calls++;
+	return compare_int_desc(a, b);
+}
+
+/* every key shares home bucket 0 of a 16 slot table but has its own full hash */
+static uint64_t shifted_hash(const void *key, size_t len)
+{
+	return (uint64_t)(uintptr_t)key << 4;
+}
+
+/* test hash table filters on the full hash before calling compare */
+START_TEST(test_full_hash_ht)
+	{
+		hash_table_t *ht = NULL;
+		ht_item_t *search = NULL;
+
+		ht = create_ht_hash(16, shifted_hash, NULL);
+		ck_assert_ptr_ne(ht, NULL);
+		for (intptr_t i = 1; i <= 8; i++) {
+			ck_assert_int_eq(insert_ht(ht, (void *)i, counting_compare), 0);
+		}
+		ck_assert_int_eq(compare_calls, 0);
+
+		search = search_ht(ht, (void *)8, counting_compare);
+		ck_assert_ptr_ne(search, NULL);
+		ck_assert(search->hash == shifted_hash((void *)8, 0));
+		ck_assert_int_eq(compare_calls, 1);
+		destroy_ht(&ht, no_op);
+	}
+END_TEST
+
+/* test robin hood probing under insert/delete churn */
+START_TEST(test_robin_hood_ht)
+	{
+		hash_table_t *ht = NULL;
+		ht_options_t options = { .flags = HT_ROBIN_HOOD, .hash = ht_hash_intptr };
+		uint32_t max_dist = 0;
+
+		ht = create_ht_ex(1024, &options);
+		ck_assert_ptr_ne(ht, NULL);
+		for (intptr_t i = 1; i <= 600; i++) {
+			ck_assert_int_eq(insert_ht(ht, (void *)i, compare_int_desc), 0);
+		}
+		/* slide a window of 600 live keys forward, deleting the oldest each step */
+		for (intptr_t i = 601; i <= 20000; i++) {
+			ck_assert_int_eq(delete_ht_item(ht, (void *)(i - 600), compare_int_desc), 0);
+			ck_assert_int_eq(insert_ht(ht, (void *)i, compare_int_desc), 0);
+		}
+		ck_assert_int_eq(ht->capacity, 1024);
+		ck_assert_int_eq(ht->items, 600);
+
+		for (size_t i = 0; i < ht->capacity; i++) {
+			ht_item_t *item = index_ht(ht, i);
+			/* no tombstones are left behind */
+			ck_assert(item->has_item || item->hash != INT64_MAX);
+			if (item->has_item && item->dist > max_dist) {
+				max_dist = item->dist;
+			}
+		}
+		ck_assert_int_lt(max_dist, 32);
+		ck_assert_ptr_eq(search_ht(ht, (void *)19400, compare_int_desc), NULL);
+		ck_assert_ptr_eq(search_ht(ht, (void *)19401, compare_int_desc)->data, (void *)19401);
+		ck_assert_ptr_eq(search_ht(ht, (void *)20000, compare_int_desc)->data, (void *)20000);
+		destroy_ht(&ht, no_op);
+	}
+END_TEST
+
+/* test robin hood probing combined with incremental resizing */
+START_TEST(test_robin_hood_resize_ht)
+	{
+		hash_table_t *ht = NULL;
+		ht_options_t options = { .flags = HT_ROBIN_HOOD | HT_INCREMENTAL_RESIZE, .hash = ht_hash_intptr };
+
+		ht = create_ht_ex(4, &options);
+		ck_assert_ptr_ne(ht, NULL);
+		for (intptr_t i = 1; i <= 500; i++) {
+			ck_assert_int_eq(insert_ht(ht, (void *)i, compare_int_desc), 0);
+			if (i % 3 == 0) {
+				ck_assert_int_eq(delete_ht_item(ht, (void *)(i / 3), compare_int_desc), 0);
+			}
+		}
+		for (intptr_t i = 1; i <= 500; i++) {
+			bool deleted = i <= 500 / 3;
+			ck_assert_int_eq(search_ht(ht, (void *)i, compare_int_desc) == NULL, deleted);
+		}
+		destroy_ht(&ht, no_op);
+	}
+END_TEST
+
+/* test the group probed backend through the regular hash table API */
+START_TEST(test_group_probe_ht)
+	{
+		hash_table_t *ht = NULL;
+		ht_options_t options = { .flags = HT_GROUP_PROBE };
+		ht_item_t *search = NULL;
+		static char keys[1000][24];
+
+		options.flags = HT_GROUP_PROBE | HT_ROBIN_HOOD;
+		ck_assert_ptr_eq(create_ht_ex(16, &options), NULL);
+
+		options.flags = HT_GROUP_PROBE;
+		ht = create_ht_ex(20, &options);
+		ck_assert_ptr_ne(ht, NULL);
+		ck_assert_int_eq(ht->capacity, 32);
+		for (int i = 0; i < 1000; i++) {
+			snprintf(keys[i], sizeof(keys[i]), "group-%d", i);
+			ck_assert_int_eq(insert_ht(ht, keys[i], compare_alphanumeric), 0);
+		}
+		ck_assert_int_eq(insert_ht(ht, keys[500], compare_alphanumeric), -1);
+		ck_assert_int_eq(ht->items, 1000);
+		ck_assert_int_eq(ht->capacity % 16, 0);
+
+		for (int i = 0; i < 1000; i += 2) {
+			ck_assert_int_eq(delete_ht_item(ht, keys[i], compare_alphanumeric), 0);
+		}
+		for (int i = 0; i < 1000; i++) {
+			search = search_ht(ht, keys[i], compare_alphanumeric);
+			ck_assert_int_eq(search == NULL, i % 2 == 0);
+		}
+		/* deleted slots are reused */
+		ck_assert_int_eq(insert_ht(ht, keys[0], compare_alphanumeric), 0);
+		ck_assert_str_eq(search_ht(ht, keys[0], compare_alphanumeric)->data, "group-0");
+		destroy_ht(&ht, no_op);
+	}
+END_TEST
+
+static void *count_word(void *key, void *value, bool exists, void *ctx)
+{
+	(*(int *)ctx)++;
+	return (void *)((intptr_t)value + 1);
+}
+
+/* test hash table key/value map functions */
+START_TEST(test_map_ht)
+	{
+		hash_table_t *ht = NULL;
+		ht_item_t *item = NULL;
+		const char *words[] = { "a", "b", "a", "c", "a", "b" };
+		int calls = 0;
+		char key[16];
+
+		ht = create_ht(4);
+		ck_assert_ptr_ne(ht, NULL);
+		ck_assert_int_eq(ht_put(ht, "session-1", (void *)101, compare_alphanumeric), 0);
+		ck_assert_int_eq(ht_put(ht, "session-2", (void *)102, compare_alphanumeric), 0);
+		ck_assert_int_eq(ht_put(ht, "session-1", (void *)111, compare_alphanumeric), 0);
+		ck_assert_int_eq(ht->items, 2);
+
+		/* a lookup only needs an equal key, not the stored object */
+		strcpy(key, "session-1");
+		ck_assert_ptr_eq(ht_get(ht, key, compare_alphanumeric), (void *)111);
+		ck_assert_ptr_eq(ht_get(ht, "session-3", compare_alphanumeric), NULL);
+
+		item = ht_get_or_insert(ht, "session-2", (void *)999, compare_alphanumeric);
+		ck_assert_ptr_eq(item->value, (void *)102);
+		item = ht_get_or_insert(ht, "session-3", (void *)103, compare_alphanumeric);
+		ck_assert_ptr_eq(item->value, (void *)103);
+		ck_assert_str_eq(item->data, "session-3");
+
+		for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+			ck_assert_int_eq(ht_upsert(ht, (void *)words[i], count_word, &calls, compare_alphanumeric), 0);
+		}
+		ck_assert_int_eq(calls, 6);
+		ck_assert_ptr_eq(ht_get(ht, "a", compare_alphanumeric), (void *)3);
+		ck_assert_ptr_eq(ht_get(ht, "b", compare_alphanumeric), (void *)2);
+		ck_assert_ptr_eq(ht_get(ht, "c", compare_alphanumeric), (void *)1);
+		ck_assert_ptr_eq(ht_get(ht, "session-1", compare_alphanumeric), (void *)111);
+		destroy_ht(&ht, no_op);
+	}
+END_TEST
+
+/* test batched hash table insertion and search */
+START_TEST(test_batch_ht)
+	{
+		hash_table_t *ht = NULL;
+		void *keys[100];
+		void *lookups[150];
+		ht_item_t *results[150];
+		int rcs[100];
+
+		ht = create_ht_hash(8, ht_hash_intptr, NULL);
+		ck_assert_ptr_ne(ht, NULL);
+		for (intptr_t i = 0; i < 100; i++) {
+			/* the second half repeats the first */
+			keys[i] = (void *)(1 + i % 50);
+		}
+		ck_assert_int_eq(insert_ht_batch(ht, keys, 100, compare_int_desc, rcs), 50);
+		ck_assert_int_eq(rcs[0], 0);
+		ck_assert_int_eq(rcs[49], 0);
+		ck_assert_int_eq(rcs[50], -1);
+		ck_assert_int_eq(ht->items, 50);
+
+		for (intptr_t i = 0; i < 150; i++) {
+			lookups[i] = (void *)(1 + i);
+		}
+		ck_assert_int_eq(search_ht_batch(ht, lookups, 150, compare_int_desc, results), 50);
+		ck_assert_ptr_eq(results[0]->data, (void *)1);
+		ck_assert_ptr_eq(results[49]->data, (void *)50);
+		ck_assert_ptr_eq(results[50], NULL);
+		ck_assert_ptr_eq(results[149], NULL);
+		destroy_ht(&ht, no_op);
+	}
+END_TEST
+
+static size_t destroyed = 0;
+
+static void count_destroy(void *data)
+{
+	destroyed++;
+}
+
+/* test walking and clearing a hash table with every probing scheme */
+START_TEST(test_iterate_ht)
+	{
+		unsigned int modes[] = { 0, HT_INCREMENTAL_RESIZE, HT_ROBIN_HOOD, HT_GROUP_PROBE };
+		hash_table_t *ht = NULL;
+		ht_iter_t iter;
+		ht_item_t *item = NULL;
+		size_t count = 0;
+		intptr_t sum = 0;
+
+		for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+			ht_options_t options = { .flags = modes[m], .hash = ht_hash_intptr };
+			ht = create_ht_ex(4, &options);
+			ck_assert_ptr_ne(ht, NULL);
+			for (intptr_t i = 1; i <= 200; i++) {
+				ck_assert_int_eq(insert_ht(ht, (void *)i, compare_int_desc), 0);
+			}
+			for (intptr_t i = 1; i <= 200; i += 2) {
+				ck_assert_int_eq(delete_ht_item(ht, (void *)i, compare_int_desc), 0);
+			}
+
+			/* only the 100 even keys are left */
+			count = 0;
+			sum = 0;
+			ht_iter_init(ht, &iter);
+			while ((item = ht_iter_next(&iter))) {
+				count++;
+				sum += (intptr_t)item->data;
+			}
+			ck_assert_int_eq(count, 100);
+			ck_assert_int_eq(sum, 100 * 101);
+
+			destroyed = 0;
+			ht_clear(ht, count_destroy);
+			ck_assert_int_eq(destroyed, 100);
+			ck_assert_int_eq(ht->items, 0);
+			ht_iter_init(ht, &iter);
+			ck_assert_ptr_eq(ht_iter_next(&iter), NULL);
+			ck_assert_ptr_eq(search_ht(ht, (void *)2, compare_int_desc), NULL);
+
+			/* the table is usable again after a clear */
+			ck_assert_int_eq(insert_ht(ht, (void *)7, compare_int_desc), 0);
+			ck_assert_ptr_ne(search_ht(ht, (void *)7, compare_int_desc), NULL);
+			destroyed = 0;
+			destroy_ht(&ht, count_destroy);
+			ck_assert_int_eq(destroyed, 1);
+		}
+
+		/* items still in the old array of an incremental resize are walked and cleared too */
+		ht_options_t options = { .flags = HT_INCREMENTAL_RESIZE, .hash = ht_hash_intptr };
+		ht = create_ht_ex(4, &options);
+		for (intptr_t i = 1; i <= 175; i++) {
+			insert_ht(ht, (void *)i, compare_int_desc);
+		}
+		ck_assert_ptr_ne(ht->old_array, NULL);
+		count = 0;
+		ht_iter_init(ht, &iter);
+		while (ht_iter_next(&iter)) {
+			count++;
+		}
+		ck_assert_int_eq(count, 175);
+		destroyed = 0;
+		ht_clear(ht, count_destroy);
+		ck_assert_int_eq(destroyed, 175);
+		ck_assert_ptr_eq(ht->old_array, NULL);
+		destroy_ht(&ht, count_destroy);
+	}
+END_TEST
+
+/* test tombstone accounting, automatic shrinking and compaction with every probing scheme */
+START_TEST(test_shrink_compact_ht)
+	{
+		unsigned int modes[] = { 0, HT_INCREMENTAL_RESIZE, HT_ROBIN_HOOD, HT_GROUP_PROBE };
+		hash_table_t *ht = NULL;
+
+		for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+			ht_options_t options = { .flags = modes[m], .hash = ht_hash_intptr };
+
+			/* the table grows for a peak and shrinks again afterwards */
+			ht = create_ht_ex(16, &options);
+			for (intptr_t i = 1; i <= 1000; i++) {
+				ck_assert_int_eq(insert_ht(ht, (void *)i, compare_int_desc), 0);
+			}
+			ck_assert_int_ge(ht->capacity, 1500);
+			for (intptr_t i = 1; i <= 990; i++) {
+				ck_assert_int_eq(delete_ht_item(ht, (void *)i, compare_int_desc), 0);
+			}
+			ck_assert_int_lt(ht->capacity, 128);
+			ck_assert_int_ge(ht->capacity, 16);
+			for (intptr_t i = 991; i <= 1000; i++) {
+				ck_assert_ptr_ne(search_ht(ht, (void *)i, compare_int_desc), NULL);
+			}
+			destroy_ht(&ht, no_op);
+
+			/* insert/delete churn reuses and cleans out tombstones instead of growing */
+			ht = create_ht_ex(64, &options);
+			for (intptr_t i = 1; i <= 10000; i++) {
+				ck_assert_int_eq(insert_ht(ht, (void *)i, compare_int_desc), 0);
+				if (i > 8) {
+					ck_assert_int_eq(delete_ht_item(ht, (void *)(i - 8), compare_int_desc), 0);
+				}
+			}
+			ck_assert_int_eq(ht->capacity, 64);
+			ck_assert_int_eq(ht->items, 8);
+			ck_assert_int_lt(ht->items + ht->tombstones, 43);
+			ck_assert_ptr_ne(search_ht(ht, (void *)9993, compare_int_desc), NULL);
+			ck_assert_ptr_eq(search_ht(ht, (void *)9992, compare_int_desc), NULL);
+
+			/* compaction drops tombstones and shrinks to fit */
+			ck_assert_int_eq(ht_compact(ht), 0);
+			ck_assert_int_eq(ht->tombstones, 0);
+			ck_assert_int_eq(ht->capacity, 64);
+			for (intptr_t i = 9993; i <= 10000; i++) {
+				ck_assert_ptr_ne(search_ht(ht, (void *)i, compare_int_desc), NULL);
+			}
+			destroy_ht(&ht, no_op);
+
+			ht = create_ht_ex(16, &options);
+			for (intptr_t i = 1; i <= 300; i++) {
+				insert_ht(ht, (void *)i, compare_int_desc);
+			}
+			for (intptr_t i = 1; i <= 200; i++) {
+				delete_ht_item(ht, (void *)i, compare_int_desc);
+			}
+			ck_assert_int_eq(ht_compact(ht), 0);
+			ck_assert_ptr_eq(ht->old_array, NULL);
+			ck_assert_int_eq(ht->tombstones, 0);
+			ck_assert_int_le(ht->capacity, 320);
+			ck_assert_int_eq(ht->items, 100);
+			for (intptr_t i = 201; i <= 300; i++) {
+				ck_assert_ptr_ne(search_ht(ht, (void *)i, compare_int_desc), NULL);
+			}
+			destroy_ht(&ht, no_op);
+		}
+		ck_assert_int_eq(ht_compact(NULL), -1);
+	}
+END_TEST
+
+/* hash the integer key itself, leaving the low bits of aligned keys all zero */
+static uint64_t identity_hash(const void *key, size_t len)
+{
+	return (uint64_t)(uintptr_t)key;
+}
+
+/* test power of two capacities and presizing */
+START_TEST(test_pow2_reserve_ht)
+	{
+		unsigned int modes[] = { HT_POW2_CAPACITY, HT_POW2_CAPACITY | HT_ROBIN_HOOD, HT_POW2_CAPACITY | HT_GROUP_PROBE };
+		hash_table_t *ht = NULL;
+		ht_iter_t iter;
+		ht_item_t *item = NULL;
+		uint32_t max_dist = 0;
+		size_t capacity = 0;
+
+		for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+			ht_options_t options = { .flags = modes[m], .hash = identity_hash };
+			ht = create_ht_ex(100, &options);
+			ck_assert_ptr_ne(ht, NULL);
+			ck_assert_int_eq(ht->capacity, 128);
+
+			/* keys 64 apart still spread out once the hash is mixed */
+			for (intptr_t i = 1; i <= 1000; i++) {
+				ck_assert_int_eq(insert_ht(ht, (void *)(i * 64), compare_int_desc), 0);
+			}
+			ck_assert_int_eq(ht->capacity & (ht->capacity - 1), 0);
+			if (!(modes[m] & HT_GROUP_PROBE)) {
+				max_dist = 0;
+				ht_iter_init(ht, &iter);
+				while ((item = ht_iter_next(&iter))) {
+					max_dist = item->dist > max_dist ? item->dist : max_dist;
+				}
+				ck_assert_int_lt(max_dist, 64);
+			}
+			for (intptr_t i = 1; i <= 1000; i++) {
+				ck_assert_ptr_ne(search_ht(ht, (void *)(i * 64), compare_int_desc), NULL);
+			}
+			ck_assert_ptr_eq(search_ht(ht, (void *)32, compare_int_desc), NULL);
+			destroy_ht(&ht, no_op);
+		}
+
+		/* a reserved table holds its items without resizing and does not shrink below the reservation */
+		ht = create_ht_hash(16, ht_hash_intptr, NULL);
+		ck_assert_int_eq(ht_reserve(ht, 1000), 0);
+		capacity = ht->capacity;
+		ck_assert_int_ge(capacity, 1500);
+		for (intptr_t i = 1; i <= 1000; i++) {
+			ck_assert_int_eq(insert_ht(ht, (void *)i, compare_int_desc), 0);
+		}
+		ck_assert_int_eq(ht->capacity, capacity);
+		for (intptr_t i = 1; i <= 990; i++) {
+			ck_assert_int_eq(delete_ht_item(ht, (void *)i, compare_int_desc), 0);
+		}
+		ck_assert_int_eq(ht->capacity, capacity);
+		ck_assert_int_eq(ht_reserve(ht, 10), 0);
+		ck_assert_int_eq(ht->capacity, capacity);
+		destroy_ht(&ht, no_op);
+		ck_assert_int_eq(ht_reserve(NULL, 10), -1);
+	}
+END_TEST
+
+static int counting_strcmp(void *a, void *b)
+{
+	compare_calls++;
+	return strcmp((char *)a, (char *)b);
+}
+
+/* test inline key storage with short keys, and long keys that share their inline bytes */
+START_TEST(test_inline_keys_ht)
+	{
+		unsigned int modes[] = { HT_INLINE_KEYS, HT_INLINE_KEYS | HT_INCREMENTAL_RESIZE, HT_INLINE_KEYS | HT_ROBIN_HOOD,
+					 HT_INLINE_KEYS | HT_GROUP_PROBE };
+		static char keys[400][32];
+		char lookup[32];
+		hash_table_t *ht = NULL;
+		ht_item_t *item = NULL;
+
+		for (int i = 0; i < 200; i++) {
+			snprintf(keys[i], sizeof(keys[i]), "k%d", i);
+			snprintf(keys[200 + i], sizeof(keys[200 + i]), "shared-prefix-16%d", i);
+		}
+
+		for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+			ht_options_t options = { .flags = modes[m] };
+			ht = create_ht_ex(8, &options);
+			ck_assert_ptr_ne(ht, NULL);
+			for (int i = 0; i < 400; i++) {
+				ck_assert_int_eq(insert_ht(ht, keys[i], counting_strcmp), 0);
+			}
+			ck_assert_int_eq(insert_ht(ht, keys[3], counting_strcmp), -1);
+			for (int i = 0; i < 200; i += 2) {
+				ck_assert_int_eq(delete_ht_item(ht, keys[i], counting_strcmp), 0);
+			}
+
+			/* short keys are settled from their inline copy, without the comparator */
+			compare_calls = 0;
+			for (int i = 0; i < 200; i++) {
+				snprintf(lookup, sizeof(lookup), "k%d", i);
+				item = search_ht(ht, lookup, counting_strcmp);
+				if (i % 2) {
+					ck_assert_ptr_eq(item->data, keys[i]);
+				} else {
+					ck_assert_ptr_eq(item, NULL);
+				}
+			}
+			ck_assert_int_eq(compare_calls, 0);
+
+			/* long keys still go through the comparator */
+			for (int i = 0; i < 200; i++) {
+				snprintf(lookup, sizeof(lookup), "shared-prefix-16%d", i);
+				item = search_ht(ht, lookup, counting_strcmp);
+				ck_assert_ptr_eq(item->data, keys[200 + i]);
+			}
+			ck_assert_int_eq(compare_calls, 200);
+			ck_assert_ptr_eq(search_ht(ht, "shared-prefix-16x", counting_strcmp), NULL);
+			destroy_ht(&ht, no_op);
+		}
+
+		/* a custom hash needs a key length callback to copy keys inline */
+		ht_options_t options = { .flags = HT_INLINE_KEYS, .hash = ht_hash_intptr };
+		ck_assert_ptr_eq(create_ht_ex(8, &options), NULL);
+		options.hash = ht_hash_bytes;
+		options.key_len = point_len;
+		ht = create_ht_ex(8, &options);
+		ck_assert_ptr_ne(ht, NULL);
+		destroy_ht(&ht, no_op);
+	}
+END_TEST
+
+static int diag_calls;
+
+static void count_diag(const hash_table_t *ht, const char *message, void *ctx)
+{
+	diag_calls++;
+	ck_assert_ptr_eq(ctx, &diag_calls);
+	ck_assert_int_gt(strlen(message), 0);
+}
+
+/* test hash table statistics and the diagnostics callback */
+START_TEST(test_stats_ht)
+	{
+		unsigned int modes[] = { 0, HT_ROBIN_HOOD, HT_GROUP_PROBE };
+		hash_table_t *ht = NULL;
+		ht_stats_t stats;
+		size_t total = 0;
+
+		for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+			ht_options_t options = { .flags = modes[m], .hash = ht_hash_intptr, .diag = count_diag,
+						 .diag_ctx = &diag_calls };
+			diag_calls = 0;
+			ht = create_ht_ex(16, &options);
+			for (intptr_t i = 1; i <= 1000; i++) {
+				insert_ht(ht, (void *)i, compare_int_desc);
+			}
+			for (intptr_t i = 1; i <= 100; i++) {
+				delete_ht_item(ht, (void *)i, compare_int_desc);
+			}
+
+			ck_assert_int_eq(ht_stats(ht, &stats), 0);
+			ck_assert_int_eq(stats.items, 900);
+			ck_assert_int_eq(stats.capacity, ht->capacity);
+			ck_assert_int_eq(stats.tombstones, ht->tombstones);
+			ck_assert_int_gt(stats.resizes, 0);
+			ck_assert_int_eq(stats.resizes, diag_calls);
+			ck_assert(stats.resize_time >= 0);
+			ck_assert_int_ge(stats.bytes, stats.capacity * sizeof(ht_item_t));
+
+			/* every item is in the histogram, and the longest probe is in its range */
+			total = 0;
+			for (size_t i = 0; i < HT_STATS_PROBES; i++) {
+				total += stats.probes[i];
+				if (stats.probes[i] && i < HT_STATS_PROBES - 1) {
+					ck_assert_int_le(i, stats.max_displacement);
+				}
+			}
+			ck_assert_int_eq(total, 900);
+			ck_assert_int_gt(stats.probes[0], 0);
+			destroy_ht(&ht, no_op);
+		}
+
+		/* tombstones are reported */
+		ht = create_ht_hash(64, ht_hash_intptr, NULL);
+		for (intptr_t i = 1; i <= 20; i++) {
+			insert_ht(ht, (void *)i, compare_int_desc);
+		}
+		for (intptr_t i = 1; i <= 5; i++) {
+			delete_ht_item(ht, (void *)i, compare_int_desc);
+		}
+		ck_assert_int_eq(ht_stats(ht, &stats), 0);
+		ck_assert_int_eq(stats.tombstones, 5);
+		ck_assert_int_eq(stats.resizes, 0);
+		destroy_ht(&ht, no_op);
+		ck_assert_int_eq(ht_stats(NULL, &stats), -1);
+	}
+END_TEST
+
+/* test seeded hashing in every probing mode, per-table seeds and colliding keys spread by the seed */
+START_TEST(test_seeded_hash_ht)
+	{
+		unsigned int modes[] = { HT_SEEDED_HASH, HT_SEEDED_HASH | HT_ROBIN_HOOD, HT_SEEDED_HASH | HT_GROUP_PROBE };
+		char *keys[] = { "alpha", "bravo", "charlie", "delta", "echo", "foxtrot" };
+		size_t num_keys = sizeof(keys) / sizeof(keys[0]);
+		hash_table_t *ht = NULL;
+		hash_table_t *other = NULL;
+		ht_stats_t stats;
+		ht_iter_t iter;
+		ht_item_t *item = NULL;
+		uint64_t hash = 0;
+
+		for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+			ht_options_t options = { .flags = modes[m] };
+			ht = create_ht_ex(4, &options);
+			ck_assert_ptr_ne(ht, NULL);
+			ck_assert(ht->seed != 0);
+			for (size_t i = 0; i < num_keys; i++) {
+				ck_assert_int_eq(insert_ht(ht, keys[i], compare_alphanumeric), 0);
+			}
+			ck_assert_int_eq(insert_ht(ht, "alpha", compare_alphanumeric), -1);
+			for (size_t i = 0; i < num_keys; i++) {
+				ck_assert_ptr_eq(search_ht(ht, keys[i], compare_alphanumeric)->data, keys[i]);
+			}
+			ck_assert_int_eq(delete_ht_item(ht, "bravo", compare_alphanumeric), 0);
+			ck_assert_ptr_eq(search_ht(ht, "bravo", compare_alphanumeric), NULL);
+			ck_assert_ptr_eq(search_ht(ht, "golf", compare_alphanumeric), NULL);
+			destroy_ht(&ht, no_op);
+		}
+
+		/* each table draws its own seed unless one is given, and the seed changes the stored hashes */
+		ht_options_t options = { .flags = HT_SEEDED_HASH };
+		ht = create_ht_ex(16, &options);
+		other = create_ht_ex(16, &options);
+		ck_assert(ht->seed != other->seed);
+		destroy_ht(&other, no_op);
+		destroy_ht(&ht, no_op);
+
+		options.seed = 1;
+		ht = create_ht_ex(16, &options);
+		ck_assert(ht->seed == 1);
+		options.seed = 2;
+		other = create_ht_ex(16, &options);
+		insert_ht(ht, "alpha", compare_alphanumeric);
+		insert_ht(other, "alpha", compare_alphanumeric);
+		ht_iter_init(ht, &iter);
+		hash = ht_iter_next(&iter)->hash;
+		ht_iter_init(other, &iter);
+		item = ht_iter_next(&iter);
+		ck_assert(item->hash != hash);
+		ck_assert(hash != ht_hash_string("alpha", 0));
+		destroy_ht(&other, no_op);
+		destroy_ht(&ht, no_op);
+
+		/* keys chosen to share a slot under the plain hash are spread out by the seed */
+		ht = create_ht_hash(1000, identity_hash, NULL);
+		for (intptr_t i = 1; i <= 100; i++) {
+			insert_ht(ht, (void *)(i * (intptr_t)ht->capacity), compare_int_desc);
+		}
+		ht_stats(ht, &stats);
+		ck_assert_int_ge(stats.max_displacement, 99);
+		destroy_ht(&ht, no_op);
+
+		options = (ht_options_t){ .flags = HT_SEEDED_HASH, .hash = identity_hash };
+		ht = create_ht_ex(1000, &options);
+		for (intptr_t i = 1; i <= 100; i++) {
+			ck_assert_int_eq(insert_ht(ht, (void *)(i * (intptr_t)ht->capacity), compare_int_desc), 0);
+		}
+		ht_stats(ht, &stats);
+		ck_assert_int_lt(stats.max_displacement, 32);
+		for (intptr_t i = 1; i <= 100; i++) {
+			ck_assert_ptr_ne(search_ht(ht, (void *)(i * (intptr_t)ht->capacity), compare_int_desc), NULL);
+		}
+		destroy_ht(&ht, no_op);
+	}
+END_TEST
+
 static TFun ht_tests[] = {
 	test_create_ht,
 	test_insert_ht,
-	// test_search_ht,
-	// test_index_ht,
-	// test_delete_ht_item,
+	test_search_ht,
+	test_index_ht,
+	test_delete_ht_item,
+	test_incremental_resize_ht,
+	test_custom_hash_ht,
+	test_full_hash_ht,
+	test_robin_hood_ht,
+	test_robin_hood_resize_ht,
+	test_group_probe_ht,
+	test_map_ht,
+	test_batch_ht,
+	test_iterate_ht,
+	test_shrink_compact_ht,
+	test_pow2_reserve_ht,
+	test_inline_keys_ht,
+	test_stats_ht,
+	test_seeded_hash_ht,
 	NULL
 };
 
@@ -0,0 +1,162 @@
+#include <check.h>
+#include "../src/dsa_ht_typed.h"
+#include "../src/dsa_hash.h"
+#include "test_utils.h"
+
+typedef struct point3 {
+	int32_t x;
+	int32_t y;
+	int32_t z;
+} point3_t;
+
+#define POINT3_HASH(p) dsa_hash64(&(p), sizeof(point3_t))
+#define POINT3_EQ(a, b) (memcmp(&(a), &(b), sizeof(point3_t)) == 0)
+
+DSA_HT_DEFINE(u64map, uint64_t, void *)
+DSA_HT_DEFINE_EX(pointmap, point3_t, double, POINT3_HASH, POINT3_EQ)
+
+/* every key lands in the same slot */
+#define CONSTANT_HASH(key) ((uint64_t)0)
+DSA_HT_DEFINE_EX(collidemap, uint32_t, uint32_t, CONSTANT_HASH, DSA_HT_TYPED_EQ_INT)
+
+/* test typed hash table creation */
+START_TEST(test_create_ht_typed)
+	{
+		u64map_t *h = create_u64map(0);
+		ck_assert_ptr_ne(h, NULL);
+		ck_assert_int_eq(h->capacity, DSA_HT_TYPED_MIN_CAPACITY);
+		ck_assert_int_eq(h->items, 0);
+		destroy_u64map(&h);
+		ck_assert_ptr_eq(h, NULL);
+		destroy_u64map(&h);
+
+		/* sized to hold the requested keys below the load factor */
+		h = create_u64map(1000);
+		ck_assert_int_eq(h->capacity, 2048);
+		destroy_u64map(&h);
+	}
+END_TEST
+
+/* test typed hash table insertion, replacement, search and deletion */
+START_TEST(test_put_get_delete_ht_typed)
+	{
+		u64map_t *h = create_u64map(0);
+		size_t index = 0;
+		size_t seen = 0;
+
+		for (uint64_t i = 0; i < 100000; i++) {
+			ck_assert_int_eq(u64map_put(h, i, (void *)(uintptr_t)(i + 1)), 0);
+		}
+		ck_assert_int_eq(h->items, 100000);
+		ck_assert_int_eq(h->capacity & (h->capacity - 1), 0);
+		for (uint64_t i = 0; i < 100000; i++) {
+			ck_assert_ptr_eq(*u64map_get(h, i), (void *)(uintptr_t)(i + 1));
+		}
+		ck_assert_ptr_eq(u64map_get(h, 100000), NULL);
+
+		/* a second put replaces the value */
+		ck_assert_int_eq(u64map_put(h, 7, NULL), 0);
+		ck_assert_int_eq(h->items, 100000);
+		ck_assert_ptr_eq(*u64map_get(h, 7), NULL);
+
+		for (uint64_t i = 0; i < 100000; i += 2) {
+			ck_assert_int_eq(u64map_delete(h, i), 0);
+		}
+		ck_assert_int_eq(u64map_delete(h, 0), -1);
+		ck_assert_int_eq(h->items, 50000);
+		for (uint64_t i = 0; i < 100000; i++) {
+			ck_assert((u64map_get(h, i) != NULL) == (i % 2 == 1));
+		}
+
+		for (index = 0; u64map_next(h, &index); index++) {
+			ck_assert_int_eq(h->keys[index] % 2, 1);
+			seen++;
+		}
+		ck_assert_int_eq(seen, 50000);
+
+		ck_assert_int_eq(u64map_put(NULL, 1, NULL), -1);
+		ck_assert_ptr_eq(u64map_get(NULL, 1), NULL);
+		ck_assert_int_eq(u64map_delete(NULL, 1), -1);
+		destroy_u64map(&h);
+	}
+END_TEST
+
+/* test tombstones are reused and cleared, and reserve sizes the table once */
+START_TEST(test_tombstones_reserve_ht_typed)
+	{
+		collidemap_t *c = create_collidemap(16);
+		u64map_t *h = create_u64map(0);
+		size_t capacity = 0;
+
+		/* one chain, deleting inside it leaves tombstones that later inserts reuse */
+		for (uint32_t i = 0; i < 10; i++) {
+			ck_assert_int_eq(collidemap_put(c, i, i * 10), 0);
+		}
+		ck_assert_int_eq(collidemap_delete(c, 3), 0);
+		ck_assert_int_eq(collidemap_delete(c, 9), 0);
+		ck_assert_int_eq(c->tombstones, 1);
+		ck_assert_int_eq(*collidemap_get(c, 8), 80);
+		ck_assert_ptr_eq(collidemap_get(c, 3), NULL);
+		ck_assert_int_eq(collidemap_put(c, 3, 33), 0);
+		ck_assert_int_eq(c->tombstones, 0);
+		ck_assert_int_eq(*collidemap_get(c, 3), 33);
+		destroy_collidemap(&c);
+
+		/* churn on a fixed number of keys stays at one size */
+		ck_assert_int_eq(u64map_reserve(h, 1000), 0);
+		capacity = h->capacity;
+		for (uint64_t i = 0; i < 100000; i++) {
+			ck_assert_int_eq(u64map_put(h, i, NULL), 0);
+			if (i >= 1000) {
+				ck_assert_int_eq(u64map_delete(h, i - 1000), 0);
+			}
+		}
+		ck_assert_int_eq(h->items, 1000);
+		ck_assert_int_eq(h->capacity, capacity);
+		ck_assert_int_eq(u64map_reserve(h, 10), 0);
+		ck_assert_int_eq(h->capacity, capacity);
+		ck_assert_int_eq(u64map_reserve(NULL, 10), -1);
+		destroy_u64map(&h);
+	}
+END_TEST
+
+/* test fixed size struct keys with a user hash and equality */
+START_TEST(test_struct_keys_ht_typed)
+	{
+		pointmap_t *h = create_pointmap(4);
+		point3_t p = { 0 };
+
+		for (int32_t i = 0; i < 1000; i++) {
+			p = (point3_t){ i, -i, i * 3 };
+			ck_assert_int_eq(pointmap_put(h, p, i * 0.5), 0);
+		}
+		for (int32_t i = 0; i < 1000; i++) {
+			p = (point3_t){ i, -i, i * 3 };
+			ck_assert(*pointmap_get(h, p) == i * 0.5);
+		}
+		p = (point3_t){ 1, 1, 3 };
+		ck_assert_ptr_eq(pointmap_get(h, p), NULL);
+		destroy_pointmap(&h);
+	}
+END_TEST
+
+static TFun ht_typed_tests[] = {
+	test_create_ht_typed,
+	test_put_get_delete_ht_typed,
+	test_tombstones_reserve_ht_typed,
+	test_struct_keys_ht_typed,
+	NULL
+};
+
+Suite *dsa_ht_typed_st(void)
+{
+	Suite *s = suite_create("DsaHTTyped");
+
+	TCase *tc = tcase_create("HT Typed Core");
+	TFun *curr = ht_typed_tests;
+	while (*curr) {
+		tcase_add_test(tc, *curr++);
+	}
+	suite_add_tcase(s, tc);
+	return s;
+}
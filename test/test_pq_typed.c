@@ -0,0 +1,117 @@
+#include <check.h>
+#include "../src/dsa_pq_typed.h"
+#include "test_utils.h"
+
+typedef struct deadline {
+	uint32_t due;
+	uint32_t weight;
+	uint32_t id;
+} deadline_t;
+
+/* Earliest due first, then heaviest */
+#define DEADLINE_CMP(a, b) \
+	((a).due != (b).due ? DSA_PQ_TYPED_MIN((a).due, (b).due) : DSA_PQ_TYPED_MAX((a).weight, (b).weight))
+
+DSA_PQ_DEFINE(u64heap, uint64_t, DSA_PQ_TYPED_MIN)
+DSA_PQ_DEFINE(maxheap, int, DSA_PQ_TYPED_MAX)
+DSA_PQ_DEFINE(deadlineq, deadline_t, DEADLINE_CMP)
+
+/* test typed priority queue creation */
+START_TEST(test_create_pq_typed)
+	{
+		u64heap_t *h = create_u64heap(0);
+		uint64_t key = 0;
+		ck_assert_ptr_ne(h, NULL);
+		ck_assert_int_eq(h->capacity, DSA_PQ_TYPED_MIN_CAPACITY);
+		ck_assert_ptr_eq(u64heap_peek(h), NULL);
+		ck_assert_int_eq(u64heap_pop(h, &key), -1);
+		ck_assert_int_eq(u64heap_reserve(h, 1000), 0);
+		ck_assert_int_eq(h->capacity, 1000);
+		destroy_u64heap(&h);
+		ck_assert_ptr_eq(h, NULL);
+		destroy_u64heap(&h);
+	}
+END_TEST
+
+/* test min and max ordering against the keys pushed */
+START_TEST(test_push_pop_pq_typed)
+	{
+		u64heap_t *h = create_u64heap(0);
+		maxheap_t *m = create_maxheap(0);
+		uint64_t key = 0;
+		uint64_t last = 0;
+		int value = 0;
+
+		for (uint64_t i = 0; i < 10000; i++) {
+			ck_assert_int_eq(u64heap_push(h, (i * 7919) % 10007), 0);
+			ck_assert_int_eq(maxheap_push(m, (int)(i % 100) - 50), 0);
+		}
+		ck_assert_int_eq(h->items, 10000);
+		ck_assert_int_eq(*u64heap_peek(h), 0);
+		for (uint64_t i = 0; i < 10000; i++) {
+			ck_assert_int_eq(u64heap_pop(h, &key), 0);
+			ck_assert_int_ge(key, last);
+			last = key;
+		}
+		ck_assert_int_eq(h->items, 0);
+
+		ck_assert_int_eq(*maxheap_peek(m), 49);
+		for (int i = 49; i >= -50; i--) {
+			for (int j = 0; j < 100; j++) {
+				ck_assert_int_eq(maxheap_pop(m, &value), 0);
+				ck_assert_int_eq(value, i);
+			}
+		}
+		destroy_u64heap(&h);
+		destroy_maxheap(&m);
+	}
+END_TEST
+
+/* test composite keys with ties coming out in push order */
+START_TEST(test_fifo_pq_typed)
+	{
+		deadlineq_t *q = create_deadlineq(4);
+		deadline_t job = { 0 };
+		uint32_t last_id[4][2] = { { 0 } };
+
+		/* 4 due times and 2 weights, ids rising in push order */
+		for (uint32_t i = 1; i <= 800; i++) {
+			job.due = (i * 5) % 4;
+			job.weight = i % 3 == 0;
+			job.id = i;
+			ck_assert_int_eq(deadlineq_push(q, job), 0);
+		}
+		for (uint32_t due = 0; due < 4; due++) {
+			for (int weight = 1; weight >= 0; weight--) {
+				while (q->items && deadlineq_peek(q)->due == due && deadlineq_peek(q)->weight == (uint32_t)weight) {
+					deadlineq_pop(q, &job);
+					ck_assert_int_gt(job.id, last_id[due][weight]);
+					last_id[due][weight] = job.id;
+				}
+				ck_assert_int_ne(last_id[due][weight], 0);
+			}
+		}
+		ck_assert_int_eq(q->items, 0);
+		destroy_deadlineq(&q);
+	}
+END_TEST
+
+static TFun pq_typed_tests[] = {
+	test_create_pq_typed,
+	test_push_pop_pq_typed,
+	test_fifo_pq_typed,
+	NULL
+};
+
+Suite *dsa_pq_typed_st(void)
+{
+	Suite *s = suite_create("DsaPQTyped");
+
+	TCase *tc = tcase_create("PQ Typed Core");
+	TFun *curr = pq_typed_tests;
+	while (*curr) {
+		tcase_add_test(tc, *curr++);
+	}
+	suite_add_tcase(s, tc);
+	return s;
+}
@@ -93,10 +93,352 @@ START_TEST(test_index_pqueue)
 	}
 END_TEST
 
+/* Dequeue everything from a pqueue filled with pseudo-random priorities, checking the order */
+static void drain_random_pqueue(const pqueue_options_t *options)
+{
+	pqueue_t *pq = create_pqueue_ex(4, options);
+	size_t state = 12345;
+	size_t last = 0;
+	size_t priority = 0;
+	ck_assert_ptr_ne(pq, NULL);
+
+	for (size_t i = 0; i < 1000; i++) {
+		state = state * 6364136223846793005u + 1442695040888963407u;
+		priority = (state >> 33) % 500;
+		ck_assert_int_eq(enpqueue(pq, (void *)priority, priority), 0);
+	}
+	/* Interleave dequeues and enqueues so the heap is adjusted at every size */
+	for (size_t i = 0; i < 200; i++) {
+		priority = (size_t)depqueue(pq);
+		ck_assert_int_eq(enpqueue(pq, (void *)(priority + 250), priority + 250), 0);
+	}
+	ck_assert_int_eq(pq->elements, 1000);
+	for (size_t i = 0; i < 1000; i++) {
+		priority = (size_t)depqueue(pq);
+		ck_assert_int_ge(priority, last);
+		last = priority;
+	}
+	ck_assert_int_eq(pq->elements, 0);
+	ck_assert_ptr_eq(depqueue(pq), NULL);
+	destroy_pqueue(&pq);
+}
+
+/* test sift-down ordering, default and bottom-up */
+START_TEST(test_depqueue_order)
+	{
+		pqueue_options_t options = { .flags = PQ_BOTTOM_UP };
+		drain_random_pqueue(NULL);
+		drain_random_pqueue(&options);
+	}
+END_TEST
+
+/* test 4-ary and 8-ary heaps and the alignment of their groups of children */
+START_TEST(test_dary_pqueue)
+	{
+		pqueue_options_t options = { 0 };
+		pqueue_t *pq = NULL;
+
+		for (unsigned int arity = 4; arity <= 8; arity *= 2) {
+			options.arity = arity;
+			options.flags = 0;
+			drain_random_pqueue(&options);
+			options.flags = PQ_BOTTOM_UP;
+			drain_random_pqueue(&options);
+
+			pq = create_pqueue_ex(100, &options);
+			ck_assert_ptr_ne(pq, NULL);
+			ck_assert_int_eq((uintptr_t)&pq->array[1] % PQ_CACHE_LINE, 0);
+			ck_assert_int_eq((uintptr_t)&pq->array[arity + 1] % PQ_CACHE_LINE, 0);
+			destroy_pqueue(&pq);
+		}
+		options.arity = 3;
+		ck_assert_ptr_eq(create_pqueue_ex(16, &options), NULL);
+	}
+END_TEST
+
+/* test handles, priority updates and removal by handle */
+START_TEST(test_indexed_pqueue)
+	{
+		pqueue_options_t options = { .flags = PQ_INDEXED };
+		pqueue_t *pq = create_pqueue_ex(2, &options);
+		pq_handle_t handles[8];
+		ck_assert_ptr_ne(pq, NULL);
+
+		for (size_t i = 0; i < 8; i++) {
+			handles[i] = enpqueue_handle(pq, (void *)(i + 100), 10 * (i + 1));
+			ck_assert_int_ne(handles[i], PQ_INVALID_HANDLE);
+		}
+		/* Decrease to the front, increase to the back */
+		ck_assert_int_eq(pq_update_priority(pq, handles[5], 1), 0);
+		ck_assert_ptr_eq(pq->array[0].data, (void *)105);
+		ck_assert_int_eq(pq_update_priority(pq, handles[0], 1000), 0);
+		ck_assert_int_eq(find_pqueue_handle(pq, handles[0])->priority, 1000);
+
+		/* Cancel from the middle */
+		ck_assert_ptr_eq(pq_remove(pq, handles[3]), (void *)103);
+		ck_assert_ptr_eq(pq_remove(pq, handles[3]), NULL);
+		ck_assert_ptr_eq(find_pqueue_handle(pq, handles[3]), NULL);
+		ck_assert_int_eq(pq_update_priority(pq, handles[3], 5), -1);
+
+		ck_assert_ptr_eq(depqueue(pq), (void *)105);
+		ck_assert_ptr_eq(find_pqueue_handle(pq, handles[5]), NULL);
+		ck_assert_ptr_eq(depqueue(pq), (void *)101);
+		ck_assert_ptr_eq(depqueue(pq), (void *)102);
+		ck_assert_ptr_eq(depqueue(pq), (void *)104);
+		ck_assert_ptr_eq(depqueue(pq), (void *)106);
+		ck_assert_ptr_eq(depqueue(pq), (void *)107);
+		ck_assert_ptr_eq(depqueue(pq), (void *)100);
+		ck_assert_int_eq(pq->elements, 0);
+		destroy_pqueue(&pq);
+
+		/* Handles are only given out by indexed pqueues */
+		pq = create_pqueue(4);
+		ck_assert_int_eq(enpqueue_handle(pq, (void *)1, 1), PQ_INVALID_HANDLE);
+		ck_assert_ptr_eq(pq_remove(pq, 0), NULL);
+		destroy_pqueue(&pq);
+	}
+END_TEST
+
+/* test random updates and removals against the priorities they should leave */
+START_TEST(test_indexed_pqueue_random)
+	{
+		pqueue_options_t options = { .flags = PQ_INDEXED | PQ_BOTTOM_UP, .arity = 8 };
+		pqueue_t *pq = create_pqueue_ex(4, &options);
+		size_t priorities[512];
+		pq_handle_t handles[512];
+		size_t state = 99;
+		size_t index = 0;
+		size_t last = 0;
+		size_t left = 512;
+		ck_assert_ptr_ne(pq, NULL);
+
+		for (size_t i = 0; i < 512; i++) {
+			priorities[i] = i * 7 % 512;
+			handles[i] = enpqueue_handle(pq, (void *)i, priorities[i]);
+		}
+		for (size_t round = 0; round < 2000; round++) {
+			state = state * 6364136223846793005u + 1442695040888963407u;
+			index = (state >> 33) % 512;
+			if (priorities[index] == SIZE_MAX) {
+				continue;
+			}
+			if (round % 5 == 0) {
+				ck_assert_ptr_eq(pq_remove(pq, handles[index]), (void *)index);
+				priorities[index] = SIZE_MAX;
+				left--;
+			} else {
+				priorities[index] = (state >> 20) % 1000;
+				ck_assert_int_eq(pq_update_priority(pq, handles[index], priorities[index]), 0);
+			}
+		}
+		ck_assert_int_eq(pq->elements, left);
+		while (pq->elements) {
+			ck_assert_int_ge(pq->array[0].priority, last);
+			last = pq->array[0].priority;
+			index = (size_t)depqueue(pq);
+			ck_assert_int_eq(priorities[index], last);
+		}
+		destroy_pqueue(&pq);
+	}
+END_TEST
+
+/* test building a pqueue from an array, batch enqueue and batch dequeue */
+START_TEST(test_pqueue_batch)
+	{
+		pqueue_options_t options = { .flags = PQ_INDEXED, .arity = 4 };
+		pqueue_element_t elements[300];
+		void *popped[300];
+		pqueue_t *pq = NULL;
+
+		for (size_t i = 0; i < 300; i++) {
+			elements[i].priority = (i * 37) % 300;
+			elements[i].data = (void *)elements[i].priority;
+		}
+		pq = create_pqueue_from_array(elements, 200, NULL);
+		ck_assert_ptr_ne(pq, NULL);
+		ck_assert_int_eq(pq->elements, 200);
+		ck_assert_int_eq(pq->max_size, 200);
+
+		/* Smaller than the heap, enqueued one by one after one resize */
+		ck_assert_int_eq(enpqueue_batch(pq, elements + 200, 100), 0);
+		ck_assert_int_eq(pq->max_size, 400);
+		ck_assert_int_eq(depqueue_n(pq, popped, 150), 150);
+		ck_assert_int_eq(depqueue_n(pq, popped + 150, 1000), 150);
+		for (size_t i = 0; i < 300; i++) {
+			ck_assert_ptr_eq(popped[i], (void *)i);
+		}
+		ck_assert_int_eq(depqueue_n(pq, popped, 10), 0);
+
+		/* Larger than the heap, appended and heapified */
+		enpqueue(pq, (void *)7, 7);
+		ck_assert_int_eq(enpqueue_batch(pq, elements, 300), 0);
+		ck_assert_int_eq(pq->elements, 301);
+		ck_assert_ptr_eq(depqueue(pq), (void *)0);
+		ck_assert_ptr_eq(depqueue(pq), (void *)1);
+		destroy_pqueue(&pq);
+
+		/* Handles of an indexed pqueue follow the array */
+		pq = create_pqueue_from_array(elements, 300, &options);
+		ck_assert_ptr_ne(pq, NULL);
+		for (size_t i = 0; i < 300; i++) {
+			ck_assert_ptr_eq(find_pqueue_handle(pq, i)->data, elements[i].data);
+		}
+		ck_assert_int_eq(pq_update_priority(pq, 0, 1000), 0);
+		ck_assert_ptr_eq(depqueue(pq), (void *)1);
+		destroy_pqueue(&pq);
+
+		/* Bottom-up sifts during heapify stop at the subtree being built */
+		options.flags = PQ_BOTTOM_UP;
+		pq = create_pqueue_from_array(elements, 300, &options);
+		ck_assert_ptr_ne(pq, NULL);
+		ck_assert_int_eq(enpqueue_batch(pq, elements, 300), 0);
+		for (size_t i = 0; i < 600; i++) {
+			ck_assert_ptr_eq(depqueue(pq), (void *)(i / 2));
+		}
+		destroy_pqueue(&pq);
+
+		pq = create_pqueue_from_array(NULL, 0, NULL);
+		ck_assert_ptr_ne(pq, NULL);
+		ck_assert_ptr_eq(depqueue(pq), NULL);
+		destroy_pqueue(&pq);
+	}
+END_TEST
+
+/* test that a pqueue going up and down around a size keeps its array */
+START_TEST(test_pqueue_shrink)
+	{
+		pqueue_t *pq = create_pqueue(16);
+		ck_assert_ptr_ne(pq, NULL);
+
+		for (size_t i = 0; i < 1024; i++) {
+			enpqueue(pq, (void *)i, i);
+		}
+		ck_assert_int_eq(pq->max_size, 1024);
+		for (size_t i = 0; i < 600; i++) {
+			depqueue(pq);
+		}
+		ck_assert_int_eq(pq->max_size, 1024);
+		for (size_t i = 0; i < 100; i++) {
+			enpqueue(pq, (void *)i, i);
+			depqueue(pq);
+		}
+		ck_assert_int_eq(pq->max_size, 1024);
+		while (pq->elements > 10) {
+			depqueue(pq);
+		}
+		ck_assert_int_lt(pq->max_size, 1024);
+		ck_assert_int_ge(pq->max_size, pq->elements);
+		destroy_pqueue(&pq);
+	}
+END_TEST
+
+static int compare_max(const pqueue_element_t *a, const pqueue_element_t *b)
+{
+	return (a->priority < b->priority) - (a->priority > b->priority);
+}
+
+typedef struct job {
+	size_t deadline;
+	size_t weight;
+	size_t id;
+} job_t;
+
+/* Earliest deadline first, then heaviest */
+static int compare_job(const pqueue_element_t *a, const pqueue_element_t *b)
+{
+	const job_t *x = a->data;
+	const job_t *y = b->data;
+
+	if (x->deadline != y->deadline) {
+		return x->deadline < y->deadline ? -1 : 1;
+	}
+	return (x->weight < y->weight) - (x->weight > y->weight);
+}
+
+/* test comparators and FIFO order of ties */
+START_TEST(test_pqueue_compare)
+	{
+		pqueue_options_t options = { .compare = compare_max };
+		job_t jobs[] = {
+			{ 5, 1, 0 }, { 3, 1, 1 }, { 5, 9, 2 }, { 3, 1, 3 }, { 1, 0, 4 }, { 3, 1, 5 }, { 5, 1, 6 },
+		};
+		size_t order[] = { 4, 1, 3, 5, 2, 0, 6 };
+		pqueue_t *pq = create_pqueue_ex(2, &options);
+		ck_assert_ptr_ne(pq, NULL);
+
+		/* Max heap */
+		for (size_t i = 0; i < 100; i++) {
+			enpqueue(pq, (void *)(i * 31 % 100), i * 31 % 100);
+		}
+		for (size_t i = 100; i-- > 0;) {
+			ck_assert_ptr_eq(depqueue(pq), (void *)i);
+		}
+		destroy_pqueue(&pq);
+
+		/* Composite priorities in the data, ties in both fields in the order added */
+		options.compare = compare_job;
+		for (unsigned int arity = 2; arity <= 8; arity *= 2) {
+			options.arity = arity;
+			options.flags = PQ_FIFO;
+			pq = create_pqueue_ex(2, &options);
+			for (size_t i = 0; i < 7; i++) {
+				enpqueue(pq, &jobs[i], 0);
+			}
+			for (size_t i = 0; i < 7; i++) {
+				ck_assert_int_eq(((job_t *)depqueue(pq))->id, order[i]);
+			}
+			destroy_pqueue(&pq);
+		}
+	}
+END_TEST
+
+/* test FIFO order of equal priorities through every way of adding and removing */
+START_TEST(test_pqueue_fifo)
+	{
+		pqueue_options_t options = { .flags = PQ_FIFO | PQ_INDEXED | PQ_BOTTOM_UP, .arity = 4 };
+		pqueue_element_t elements[200];
+		pqueue_t *pq = NULL;
+		size_t last[4] = { 0 };
+		size_t id = 0;
+
+		/* Four priorities, ids rising in the order added */
+		for (size_t i = 0; i < 200; i++) {
+			elements[i].priority = i % 4;
+			elements[i].data = (void *)(i + 1);
+		}
+		pq = create_pqueue_from_array(elements, 100, &options);
+		ck_assert_ptr_ne(pq, NULL);
+		ck_assert_int_eq(enpqueue_batch(pq, elements + 100, 50), 0);
+		for (size_t i = 150; i < 200; i++) {
+			enpqueue_handle(pq, elements[i].data, elements[i].priority);
+		}
+		/* Removing from the middle and moving to the same priority keep the order */
+		ck_assert_ptr_eq(pq_remove(pq, 40), (void *)41);
+		ck_assert_int_eq(pq_update_priority(pq, 10, 2), 0);
+		ck_assert_int_eq(pq_update_priority(pq, 10, 2), 0);
+
+		while (pq->elements) {
+			size_t priority = pq->array[0].priority;
+			id = (size_t)depqueue(pq);
+			ck_assert_int_gt(id, last[priority]);
+			last[priority] = id;
+		}
+		destroy_pqueue(&pq);
+	}
+END_TEST
+
 static TFun pqueue_tests[] = {
 	test_create_pqueue,
 	test_enpqueue,
 	test_depqueue,
+	test_depqueue_order,
+	test_dary_pqueue,
+	test_indexed_pqueue,
+	test_indexed_pqueue_random,
+	test_pqueue_batch,
+	test_pqueue_shrink,
+	test_pqueue_compare,
+	test_pqueue_fifo,
 	test_search_pqueue,
 	test_index_pqueue,
 	NULL
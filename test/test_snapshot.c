@@ -0,0 +1,227 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../src/dsa_snapshot.h"
+#include "test_utils.h"
+
+#define SNAPSHOT_KEYS 5000
+
+static char snapshot_path[] = "/tmp/dsa_snapshot_XXXXXX";
+
+static void make_snapshot_path(void)
+{
+	int fd = 0;
+
+	strcpy(snapshot_path, "/tmp/dsa_snapshot_XXXXXX");
+	fd = mkstemp(snapshot_path);
+	ck_assert_int_ne(fd, -1);
+	close(fd);
+}
+
+static size_t value_string_bytes(const void *data, const void **bytes)
+{
+	*bytes = data;
+	return strlen((const char *)data) + 1;
+}
+
+/* Flip one byte of a file */
+static void corrupt(const char *path, long offset)
+{
+	FILE *file = fopen(path, "r+b");
+	int byte = 0;
+
+	fseek(file, offset, SEEK_SET);
+	byte = fgetc(file);
+	fseek(file, offset, SEEK_SET);
+	fputc(byte ^ 0xff, file);
+	fclose(file);
+}
+
+/* Point every used slot of a snapshot at offset, as a damaged or crafted file could */
+static void set_slot_offsets(const char *path, uint64_t offset)
+{
+	FILE *file = fopen(path, "r+b");
+	snapshot_header_t header;
+	snapshot_slot_t slot;
+
+	ck_assert_int_eq(fread(&header, sizeof(header), 1, file), 1);
+	for (uint64_t i = 0; i < header.capacity; i++) {
+		fseek(file, header.slots_offset + i * sizeof(slot), SEEK_SET);
+		ck_assert_int_eq(fread(&slot, sizeof(slot), 1, file), 1);
+		if (slot.hash) {
+			slot.offset = offset;
+			fseek(file, header.slots_offset + i * sizeof(slot), SEEK_SET);
+			fwrite(&slot, sizeof(slot), 1, file);
+		}
+	}
+	fclose(file);
+}
+
+/* test a hash table written to a snapshot answers the same lookups when mapped */
+START_TEST(test_save_open_snapshot)
+	{
+		hash_table_t *ht = create_ht(16);
+		char (*keys)[16] = malloc(SNAPSHOT_KEYS * sizeof(*keys));
+		char (*values)[24] = malloc(SNAPSHOT_KEYS * sizeof(*values));
+		snapshot_t *snap = NULL;
+		const char *value = NULL;
+		size_t value_len = 0;
+
+		make_snapshot_path();
+		for (int i = 0; i < SNAPSHOT_KEYS; i++) {
+			snprintf(keys[i], sizeof(keys[i]), "key-%d", i);
+			snprintf(values[i], sizeof(values[i]), "value-%d", i * 7);
+			ck_assert_int_eq(ht_put(ht, keys[i], values[i], compare_alphanumeric), 0);
+		}
+		ck_assert_int_eq(save_ht_snapshot(ht, snapshot_path, NULL, value_string_bytes), 0);
+
+		snap = open_snapshot(snapshot_path, true);
+		ck_assert_ptr_ne(snap, NULL);
+		ck_assert_int_eq(snap->header->items, SNAPSHOT_KEYS);
+		ck_assert_int_eq(snap->header->version, SNAPSHOT_VERSION);
+		ck_assert_int_eq(((uintptr_t)snap->slots) % 8, 0);
+		for (int i = 0; i < SNAPSHOT_KEYS; i++) {
+			value = search_snapshot(snap, keys[i], strlen(keys[i]), &value_len);
+			ck_assert_ptr_ne(value, NULL);
+			ck_assert_str_eq(value, values[i]);
+			ck_assert_int_eq(value_len, strlen(values[i]) + 1);
+		}
+		ck_assert_ptr_eq(search_snapshot(snap, "key-5000", 8, NULL), NULL);
+		/* a prefix of a stored key is another key */
+		ck_assert_ptr_eq(search_snapshot(snap, "key-1", 4, NULL), NULL);
+		ck_assert_ptr_eq(search_snapshot(NULL, "key-1", 5, NULL), NULL);
+		close_snapshot(&snap);
+		ck_assert_ptr_eq(snap, NULL);
+
+		destroy_ht(&ht, no_op);
+		free(keys);
+		free(values);
+		unlink(snapshot_path);
+	}
+END_TEST
+
+/* test the streaming writer with values larger than its buffer and keys without values */
+START_TEST(test_writer_snapshot)
+	{
+		size_t big_len = SNAPSHOT_BLOCK * 3 + 123;
+		uint8_t *big = malloc(big_len);
+		snapshot_writer_t *writer = NULL;
+		snapshot_t *snap = NULL;
+		const uint8_t *value = NULL;
+		size_t value_len = 0;
+		uint64_t key = 0;
+
+		make_snapshot_path();
+		for (size_t i = 0; i < big_len; i++) {
+			big[i] = (uint8_t)(i * 31);
+		}
+		/* sized for 4 keys, grows to hold 1000 */
+		writer = create_snapshot_writer(snapshot_path, 4);
+		ck_assert_ptr_ne(writer, NULL);
+		for (key = 0; key < 1000; key++) {
+			ck_assert_int_eq(snapshot_write(writer, &key, sizeof(key), NULL, 0), 0);
+		}
+		ck_assert_int_eq(snapshot_write(writer, "big", 3, big, big_len), 0);
+		ck_assert_int_eq(finish_snapshot(&writer), 0);
+		ck_assert_ptr_eq(writer, NULL);
+
+		snap = open_snapshot(snapshot_path, true);
+		ck_assert_ptr_ne(snap, NULL);
+		ck_assert_int_eq(snap->header->items, 1001);
+		for (key = 0; key < 1000; key++) {
+			ck_assert_ptr_ne(search_snapshot(snap, &key, sizeof(key), &value_len), NULL);
+			ck_assert_int_eq(value_len, 0);
+		}
+		value = search_snapshot(snap, "big", 3, &value_len);
+		ck_assert_int_eq(value_len, big_len);
+		ck_assert_int_eq(memcmp(value, big, big_len), 0);
+		close_snapshot(&snap);
+
+		ck_assert_int_eq(snapshot_write(NULL, "a", 1, NULL, 0), -1);
+		ck_assert_int_eq(finish_snapshot(&writer), -1);
+		free(big);
+		unlink(snapshot_path);
+	}
+END_TEST
+
+/* test damaged, truncated and unfinished snapshots are refused */
+START_TEST(test_damaged_snapshot)
+	{
+		hash_table_t *ht = create_ht(16);
+		snapshot_writer_t *writer = NULL;
+		snapshot_t *snap = NULL;
+		FILE *file = NULL;
+		long size = 0;
+
+		make_snapshot_path();
+		insert_ht(ht, "alpha", compare_alphanumeric);
+		insert_ht(ht, "bravo", compare_alphanumeric);
+		ck_assert_int_eq(save_ht_snapshot(ht, snapshot_path, NULL, NULL), 0);
+		snap = open_snapshot(snapshot_path, false);
+		ck_assert_ptr_ne(search_snapshot(snap, "alpha", 5, NULL), NULL);
+		close_snapshot(&snap);
+
+		/* a changed key byte passes the header checks but not the checksum */
+		corrupt(snapshot_path, sizeof(snapshot_header_t) + 1);
+		ck_assert_ptr_eq(open_snapshot(snapshot_path, true), NULL);
+		snap = open_snapshot(snapshot_path, false);
+		ck_assert_ptr_ne(snap, NULL);
+		close_snapshot(&snap);
+
+		/* a changed header or a truncated file is refused without the checksum */
+		corrupt(snapshot_path, 0);
+		ck_assert_ptr_eq(open_snapshot(snapshot_path, false), NULL);
+		ck_assert_int_eq(save_ht_snapshot(ht, snapshot_path, NULL, NULL), 0);
+		file = fopen(snapshot_path, "rb");
+		fseek(file, 0, SEEK_END);
+		size = ftell(file);
+		fclose(file);
+		ck_assert_int_eq(truncate(snapshot_path, size - 8), 0);
+		ck_assert_ptr_eq(open_snapshot(snapshot_path, false), NULL);
+
+		/* slot offsets whose end would overflow past the key bytes are refused */
+		ck_assert_int_eq(save_ht_snapshot(ht, snapshot_path, NULL, NULL), 0);
+		set_slot_offsets(snapshot_path, UINT64_MAX - 2);
+		snap = open_snapshot(snapshot_path, false);
+		ck_assert_ptr_ne(snap, NULL);
+		ck_assert_ptr_eq(search_snapshot(snap, "alpha", 5, NULL), NULL);
+		close_snapshot(&snap);
+
+		/* the header of an unfinished snapshot is blank */
+		writer = create_snapshot_writer(snapshot_path, 2);
+		snapshot_write(writer, "alpha", 5, NULL, 0);
+		fflush(writer->file);
+		ck_assert_ptr_eq(open_snapshot(snapshot_path, false), NULL);
+		ck_assert_int_eq(finish_snapshot(&writer), 0);
+		ck_assert_ptr_ne((snap = open_snapshot(snapshot_path, true)), NULL);
+		close_snapshot(&snap);
+
+		ck_assert_ptr_eq(open_snapshot("/nonexistent/snapshot", false), NULL);
+		ck_assert_ptr_eq(create_snapshot_writer("/nonexistent/snapshot", 2), NULL);
+		ck_assert_int_eq(save_ht_snapshot(NULL, snapshot_path, NULL, NULL), -1);
+		destroy_ht(&ht, no_op);
+		unlink(snapshot_path);
+	}
+END_TEST
+
+static TFun snapshot_tests[] = {
+	test_save_open_snapshot,
+	test_writer_snapshot,
+	test_damaged_snapshot,
+	NULL
+};
+
+Suite *dsa_snapshot_st(void)
+{
+	Suite *s = suite_create("DsaSnapshot");
+
+	TCase *tc = tcase_create("Snapshot Core");
+	TFun *curr = snapshot_tests;
+	while (*curr) {
+		tcase_add_test(tc, *curr++);
+	}
+	suite_add_tcase(s, tc);
+	return s;
+}